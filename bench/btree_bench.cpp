@@ -0,0 +1,235 @@
+// Сравнение BTreeMap и BinarySearchTree (AVL) на словаре терминов.
+// Запуск: btree_bench [размер словаря] [количество поисков]
+
+#include "btree_map.hpp"
+#include "binary_search_tree.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+#include <new>
+#include <malloc.h>
+
+// Счетчик живых байт кучи: операторы new/delete программы идут через
+// malloc, блок учитывается с фактическим размером (malloc_usable_size)
+// и заголовком malloc. Память деревьев - разность счетчика до и после
+// построения, а не оценка по размеру узла
+namespace {
+
+size_t live_heap_bytes = 0;
+constexpr size_t MALLOC_HEADER = sizeof(size_t);
+
+void* counted_alloc(size_t size, size_t alignment) {
+    void* block = nullptr;
+    if (alignment <= alignof(std::max_align_t)) {
+        block = std::malloc(size ? size : 1);
+    } else if (posix_memalign(&block, alignment, size ? size : 1) != 0) {
+        block = nullptr;
+    }
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    live_heap_bytes += malloc_usable_size(block) + MALLOC_HEADER;
+    return block;
+}
+
+void counted_free(void* block) noexcept {
+    if (block) {
+        live_heap_bytes -= malloc_usable_size(block) + MALLOC_HEADER;
+        std::free(block);
+    }
+}
+
+}  // namespace
+
+void* operator new(size_t size) { return counted_alloc(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment) {
+    return counted_alloc(size, static_cast<size_t>(alignment));
+}
+void operator delete(void* block) noexcept { counted_free(block); }
+void operator delete(void* block, size_t) noexcept { counted_free(block); }
+void operator delete(void* block, std::align_val_t) noexcept { counted_free(block); }
+void operator delete(void* block, size_t, std::align_val_t) noexcept { counted_free(block); }
+
+namespace {
+
+std::vector<std::string> make_vocabulary(size_t size, std::mt19937_64& random) {
+    std::vector<std::string> vocabulary;
+    vocabulary.reserve(size);
+    std::uniform_int_distribution<int> length(3, 12);
+    std::uniform_int_distribution<int> letter('a', 'z');
+
+    for (size_t i = 0; i < size; ++i) {
+        std::string word(length(random), ' ');
+        for (auto& c : word) {
+            c = static_cast<char>(letter(random));
+        }
+        vocabulary.push_back(word + std::to_string(i));
+    }
+    return vocabulary;
+}
+
+template<typename Function>
+double measure_ms(Function&& function) {
+    auto start = std::chrono::high_resolution_clock::now();
+    function();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void report(const char* name, double btree, double avl, const char* unit) {
+    std::cout << "  " << std::left << std::setw(22) << name << std::right << std::fixed
+              << std::setprecision(1) << std::setw(10) << btree << unit
+              << std::setw(11) << avl << unit << std::setw(8) << std::setprecision(2)
+              << avl / btree << "x" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    size_t vocabulary_size = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    size_t lookup_count = argc > 2 ? std::stoul(argv[2]) : 5000000;
+
+    std::mt19937_64 random(42);
+    auto vocabulary = make_vocabulary(vocabulary_size, random);
+
+    std::vector<std::string> lookups;
+    lookups.reserve(lookup_count);
+    std::uniform_int_distribution<size_t> pick(0, vocabulary_size - 1);
+    for (size_t i = 0; i < lookup_count; ++i) {
+        lookups.push_back(vocabulary[pick(random)]);
+    }
+
+    std::cout << "Terms: " << vocabulary_size << ", lookups: " << lookup_count << std::endl;
+    std::cout << "  " << std::left << std::setw(22) << "operation" << std::right
+              << std::setw(13) << "BTreeMap" << std::setw(14) << "AVL tree"
+              << std::setw(9) << "speedup" << std::endl;
+
+    BTreeMap<std::string, uint32_t> btree;
+    BinarySearchTree<std::string, uint32_t> avl;
+    long long checksum = 0;
+
+    size_t heap_before = live_heap_bytes;
+    double btree_ms = measure_ms([&] {
+        for (size_t i = 0; i < vocabulary_size; ++i) {
+            btree.insert(vocabulary[i], static_cast<uint32_t>(i));
+        }
+    });
+    double btree_bytes = double(live_heap_bytes - heap_before) / vocabulary_size;
+
+    heap_before = live_heap_bytes;
+    double avl_ms = measure_ms([&] {
+        for (size_t i = 0; i < vocabulary_size; ++i) {
+            avl.insert(vocabulary[i], static_cast<uint32_t>(i));
+        }
+    });
+    double avl_bytes = double(live_heap_bytes - heap_before) / vocabulary_size;
+    report("insert (random)", btree_ms, avl_ms, " ms");
+
+    long long hit_sum = 0;
+    btree_ms = measure_ms([&] {
+        for (const auto& term : lookups) {
+            hit_sum += *btree.find(term);
+        }
+    });
+    checksum += hit_sum;
+    avl_ms = measure_ms([&] {
+        uint32_t value = 0;
+        for (const auto& term : lookups) {
+            avl.get(term, value);
+            checksum -= value;
+        }
+    });
+    report("find (hit)", btree_ms, avl_ms, " ms");
+
+    std::vector<std::string> misses;
+    misses.reserve(vocabulary_size);
+    for (const auto& term : vocabulary) {
+        misses.push_back(term + "#");
+    }
+    btree_ms = measure_ms([&] {
+        for (const auto& term : misses) {
+            checksum += btree.contains(term);
+        }
+    });
+    avl_ms = measure_ms([&] {
+        for (const auto& term : misses) {
+            checksum += avl.contains(term);
+        }
+    });
+    report("find (miss)", btree_ms, avl_ms, " ms");
+
+    size_t btree_scanned = 0;
+    btree_ms = measure_ms([&] {
+        for (auto it = btree.begin(); it != btree.end(); ++it) {
+            btree_scanned += it.value();
+        }
+    });
+    size_t avl_scanned = 0;
+    avl_ms = measure_ms([&] {
+        for (const auto& entry : avl.get_all_sorted()) {
+            avl_scanned += entry.second;
+        }
+    });
+    report("ordered scan", btree_ms, avl_ms, " ms");
+
+    // Построение из отсортированного словаря: узлы заполнены полностью
+    std::vector<std::pair<std::string, uint32_t>> sorted;
+    sorted.reserve(vocabulary_size);
+    for (size_t i = 0; i < vocabulary_size; ++i) {
+        sorted.emplace_back(vocabulary[i], static_cast<uint32_t>(i));
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    BTreeMap<std::string, uint32_t> loaded;
+    heap_before = live_heap_bytes;
+    btree_ms = measure_ms([&] { loaded.build_sorted(std::move(sorted)); });
+    double loaded_bytes = double(live_heap_bytes - heap_before) / vocabulary_size;
+    std::cout << "  " << std::left << std::setw(22) << "bulk load" << std::right << std::fixed
+              << std::setprecision(1) << std::setw(10) << btree_ms << " ms" << std::endl;
+
+    btree_ms = measure_ms([&] {
+        for (const auto& term : lookups) {
+            checksum += *loaded.find(term);
+        }
+    });
+    std::cout << "  " << std::left << std::setw(22) << "find (bulk loaded)" << std::right
+              << std::setw(10) << btree_ms << " ms" << std::endl;
+
+    report("bytes/key (inserted)", btree_bytes, avl_bytes, " B ");
+    report("bytes/key (bulk)", loaded_bytes, avl_bytes, " B ");
+
+    if (checksum != hit_sum || btree.size() != avl.size() || loaded.size() != avl.size() ||
+        btree_scanned != avl_scanned) {
+        std::cerr << "Results differ: " << btree.size() << " vs " << avl.size() << std::endl;
+        return 1;
+    }
+
+    // Крайние ключи арены байтов: пустой первый ключ и ключи длиннее куска
+    // вперемешку с короткими
+    BTreeMap<std::string, uint32_t> edge;
+    std::vector<std::string> edge_keys = {"", std::string(100 * 1024, 'x'), "short",
+                                          std::string(64 * 1024 + 1, 'y'), "z",
+                                          std::string(64 * 1024, 'w')};
+    for (size_t i = 0; i < edge_keys.size(); ++i) {
+        edge.insert(edge_keys[i], static_cast<uint32_t>(i));
+    }
+    for (size_t i = 0; i < vocabulary_size % 1000 + 1000; ++i) {
+        edge.insert(vocabulary[i % vocabulary_size], static_cast<uint32_t>(edge_keys.size() + i));
+    }
+    for (size_t i = 0; i < edge_keys.size(); ++i) {
+        const uint32_t* value = edge.find(edge_keys[i]);
+        if (!value || *value != i) {
+            std::cerr << "Edge key " << i << " (" << edge_keys[i].size() << " bytes) lost"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
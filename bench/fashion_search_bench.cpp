@@ -0,0 +1,622 @@
+// Набор бенчмарков движка на синтетическом корпусе (CorpusGenerator,
+// воспроизводим по seed).
+// Микро: токенизатор, стеммер, HashTable, BinarySearchTree, BTreeMap,
+// запись метрик, операции над множествами (AND, OR, NOT), загрузка
+// индекса, find_term.
+// Макро: построение индекса по корпусу с частотами по Ципфу, повтор
+// журнала запросов, кластеризация почти-дубликатов (с проверкой полноты
+// на подложенных парах). Выборка - пачка из ops_per_sample операций;
+// медиана и p99 считаются по среднему времени операции в пачке (p99_batch_ns -
+// хвост пачек, а не отдельных операций; у повтора журнала пачка - один
+// запрос), плюс пропускная способность. Время в наносекундах, результат в JSON.
+// Запуск: fashion_search_bench [--docs N] [--queries N] [--vocab N] [--seed N]
+//                              [--dup-docs N] [--filter подстрока] [--json файл]
+
+#include "tokenizer.hpp"
+#include "stemmer.hpp"
+#include "hash_table.hpp"
+#include "binary_search_tree.hpp"
+#include "btree_map.hpp"
+#include "corpus_generator.hpp"
+#include "boolean_index.hpp"
+#include "boolean_search.hpp"
+#include "binary_index_format.hpp"
+#include "metrics.hpp"
+#include "near_duplicates.hpp"
+#include "text_format.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Config {
+    size_t documents = 20000;
+    size_t queries = 2000;
+    size_t vocabulary = 50000;
+    uint64_t seed = 42;
+    size_t duplicate_docs = 1000000;  // Подписей для кластеризации дубликатов
+    std::string filter;
+    std::string json_file;  // Пусто - JSON в stdout
+};
+
+// Сколько выборок снимать: не меньше min_samples и min_time_ms,
+// но не дольше max_time_ms (если уже есть хотя бы 3 выборки)
+struct Budget {
+    size_t min_samples = 30;
+    size_t max_samples = 10000;
+    double min_time_ms = 300.0;
+    double max_time_ms = 5000.0;
+};
+
+struct Result {
+    std::string name;
+    std::string group;  // micro или macro
+    std::string unit;   // Что считается одной операцией
+    size_t ops_per_sample = 0;
+    size_t samples = 0;
+    double median_ns = 0.0;
+    double p99_batch_ns = 0.0;  // p99 средних по пачкам
+    double min_ns = 0.0;
+    double mean_ns = 0.0;
+    double throughput = 0.0;  // Операций в секунду
+};
+
+// Результат операций копится сюда, чтобы компилятор их не выбросил
+volatile uint64_t sink = 0;
+
+class Suite {
+public:
+    explicit Suite(const std::string& filter) : filter(filter) {}
+
+    bool enabled(const std::string& name) const {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    }
+
+    // batch(i) выполняет ops_per_sample операций i-й выборки и возвращает
+    // контрольное значение; setup() вызывается перед выборкой вне замера
+    void run(const std::string& name, const std::string& group, const std::string& unit,
+             size_t ops_per_sample, const Budget& budget,
+             const std::function<uint64_t(size_t)>& batch,
+             const std::function<void()>& setup = {}) {
+        if (!enabled(name)) {
+            return;
+        }
+        std::cerr << "  " << std::left << std::setw(24) << name << std::right << std::flush;
+
+        // Прогрев: кэши, аллокатор, кэш стемминга анализатора
+        if (setup) setup();
+        sink = sink + batch(0);
+
+        std::vector<double> sample_ns;
+        double total_ns = 0.0;
+        while (sample_ns.size() < budget.max_samples) {
+            if (sample_ns.size() >= budget.min_samples && total_ns >= budget.min_time_ms * 1e6) {
+                break;
+            }
+            if (sample_ns.size() >= 3 && total_ns >= budget.max_time_ms * 1e6) {
+                break;
+            }
+
+            if (setup) setup();
+            auto start = std::chrono::steady_clock::now();
+            uint64_t value = batch(sample_ns.size());
+            auto end = std::chrono::steady_clock::now();
+            sink = sink + value;
+
+            double elapsed = std::chrono::duration<double, std::nano>(end - start).count();
+            total_ns += elapsed;
+            sample_ns.push_back(elapsed / ops_per_sample);
+        }
+
+        Result result;
+        result.name = name;
+        result.group = group;
+        result.unit = unit;
+        result.ops_per_sample = ops_per_sample;
+        result.samples = sample_ns.size();
+
+        std::sort(sample_ns.begin(), sample_ns.end());
+        result.median_ns = percentile(sample_ns, 0.50);
+        result.p99_batch_ns = percentile(sample_ns, 0.99);
+        result.min_ns = sample_ns.front();
+        result.mean_ns = total_ns / (sample_ns.size() * ops_per_sample);
+        result.throughput = result.mean_ns > 0 ? 1e9 / result.mean_ns : 0.0;
+        results.push_back(result);
+
+        std::cerr << std::fixed << std::setprecision(1)
+                  << std::setw(14) << result.median_ns << " ns"
+                  << std::setw(14) << result.p99_batch_ns << " ns p99/batch"
+                  << std::setw(14) << result.throughput << " " << unit << "/s" << std::endl;
+    }
+
+    const std::vector<Result>& get_results() const { return results; }
+
+private:
+    std::string filter;
+    std::vector<Result> results;
+
+    // Значение ранга ceil(q * n) отсортированной выборки
+    static double percentile(const std::vector<double>& sorted, double q) {
+        size_t rank = static_cast<size_t>(std::ceil(q * sorted.size()));
+        return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+    }
+};
+
+// Журнал запросов: частые и редкие термины, смесь AND/OR/NOT,
+// шаблонов, подсчета и ранжированного поиска
+struct LoggedQuery {
+    enum class Kind { SEARCH, COUNT, RANKED } kind;
+    std::string text;
+};
+
+std::vector<LoggedQuery> make_query_log(CorpusGenerator& corpus, size_t count,
+                                        std::mt19937_64& random) {
+    std::uniform_int_distribution<int> mix(0, 99);
+    QueryMix search_mix;
+
+    std::vector<LoggedQuery> log;
+    log.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        int roll = mix(random);
+        if (roll < 85) {
+            log.push_back({LoggedQuery::Kind::SEARCH, corpus.next_query(search_mix)});
+        } else if (roll < 92) {
+            log.push_back({LoggedQuery::Kind::COUNT, corpus.next_word() + " && " + corpus.next_word()});
+        } else {
+            log.push_back({LoggedQuery::Kind::RANKED, corpus.next_word() + " || " + corpus.next_word()});
+        }
+    }
+    return log;
+}
+
+// Запросы одного вида из терминов заданных рангов (для операций над множествами)
+std::vector<std::string> make_set_queries(const CorpusGenerator& corpus, const std::string& op,
+                                          size_t first_rank, size_t last_rank, size_t count,
+                                          std::mt19937_64& random) {
+    std::uniform_int_distribution<size_t> rank(first_rank, last_rank);
+    std::vector<std::string> queries;
+    for (size_t i = 0; i < count; ++i) {
+        queries.push_back(corpus.word_at(rank(random)) + op + corpus.word_at(rank(random)));
+    }
+    return queries;
+}
+
+// Подписи для кластеризации дубликатов: случайные документы по 40
+// терминов, в конце - копии каждого тысячного с одним замененным
+// термином (перепечатка далеко от оригинала по ID). В pairs -
+// подложенные пары с расстоянием <= MAX_DISTANCE: только их детектор
+// обязан найти
+void fill_duplicate_detector(CorpusGenerator& corpus, size_t count, std::mt19937_64& random,
+                             NearDuplicateDetector& detector,
+                             std::vector<std::pair<uint32_t, uint32_t>>& pairs) {
+    const size_t terms_per_doc = 40;
+    std::uniform_int_distribution<size_t> position(0, terms_per_doc - 1);
+    std::vector<std::string> terms(terms_per_doc);
+    std::vector<std::pair<uint32_t, std::vector<std::string>>> originals;
+
+    detector.clear();
+    pairs.clear();
+    while (detector.size() + originals.size() < count) {
+        for (auto& term : terms) {
+            term = corpus.next_word();
+        }
+        detector.add(terms);
+        if (detector.size() % 1000 == 0) {
+            originals.emplace_back(static_cast<uint32_t>(detector.size() - 1), terms);
+        }
+    }
+
+    for (auto& [original, copy] : originals) {
+        uint64_t signature = NearDuplicateDetector::simhash(copy);
+        copy[position(random)] = corpus.next_word();
+        detector.add(copy);
+
+        uint64_t distance = __builtin_popcountll(signature ^ NearDuplicateDetector::simhash(copy));
+        if (distance <= NearDuplicateDetector::MAX_DISTANCE) {
+            pairs.emplace_back(original, static_cast<uint32_t>(detector.size() - 1));
+        }
+    }
+}
+
+// Вывод движка (сообщения о построении и загрузке) подавляется на время замеров
+class QuietOutput {
+public:
+    QuietOutput() : saved(std::cout.rdbuf(nullptr)) {}
+    ~QuietOutput() {
+        std::cout.rdbuf(saved);
+        std::cout.clear();
+    }
+
+    std::streambuf* original() const { return saved; }
+
+private:
+    std::streambuf* saved;
+};
+
+void write_json(std::ostream& out, const Config& config, const std::vector<Result>& results) {
+    out << std::fixed << std::setprecision(1);
+    out << "{\n";
+    out << "  \"config\": {\n";
+    out << "    \"documents\": " << config.documents << ",\n";
+    out << "    \"queries\": " << config.queries << ",\n";
+    out << "    \"vocabulary\": " << config.vocabulary << ",\n";
+    out << "    \"seed\": " << config.seed << ",\n";
+    out << "    \"duplicate_docs\": " << config.duplicate_docs << ",\n";
+#ifdef __VERSION__
+    out << "    \"compiler\": " << json_string(__VERSION__) << ",\n";
+#endif
+#ifdef NDEBUG
+    out << "    \"assertions\": false\n";
+#else
+    out << "    \"assertions\": true\n";
+#endif
+    out << "  },\n";
+    out << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << "    {\"name\": " << json_string(r.name) << ", "
+            << "\"group\": \"" << r.group << "\", "
+            << "\"unit\": \"" << r.unit << "\", "
+            << "\"ops_per_sample\": " << r.ops_per_sample << ", "
+            << "\"samples\": " << r.samples << ", "
+            << "\"median_ns\": " << r.median_ns << ", "
+            << "\"p99_batch_ns\": " << r.p99_batch_ns << ", "
+            << "\"min_ns\": " << r.min_ns << ", "
+            << "\"mean_ns\": " << r.mean_ns << ", "
+            << "\"throughput_per_s\": " << r.throughput << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+bool parse_arguments(int argc, char* argv[], Config& config) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            return false;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Error: Missing value after " << arg << std::endl;
+            return false;
+        }
+
+        std::string value = argv[++i];
+        if (arg == "--docs") {
+            config.documents = std::stoul(value);
+        } else if (arg == "--queries") {
+            config.queries = std::stoul(value);
+        } else if (arg == "--vocab") {
+            config.vocabulary = std::stoul(value);
+        } else if (arg == "--seed") {
+            config.seed = std::stoull(value);
+        } else if (arg == "--dup-docs") {
+            config.duplicate_docs = std::stoul(value);
+        } else if (arg == "--filter") {
+            config.filter = value;
+        } else if (arg == "--json") {
+            config.json_file = value;
+        } else {
+            std::cerr << "Error: Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (config.documents == 0 || config.queries == 0 || config.vocabulary == 0 ||
+        config.duplicate_docs == 0) {
+        std::cerr << "Error: --docs, --queries, --vocab and --dup-docs must be positive" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Config config;
+    if (!parse_arguments(argc, argv, config)) {
+        std::cerr << "Usage: " << argv[0] << " [--docs N] [--queries N] [--vocab N] [--seed N]"
+                  << " [--dup-docs N] [--filter substring] [--json file]" << std::endl;
+        return 1;
+    }
+
+    QuietOutput quiet;
+    Suite suite(config.filter);
+
+    std::cerr << "Generating corpus: " << config.documents << " documents, vocabulary "
+              << config.vocabulary << ", seed " << config.seed << std::endl;
+    CorpusModel model;
+    model.vocabulary_size = config.vocabulary;
+    CorpusGenerator corpus(model, config.seed);
+    std::mt19937_64 random(config.seed);
+
+    std::vector<Document> documents(config.documents);
+    for (auto& doc : documents) {
+        corpus.next_document(doc);
+    }
+    std::vector<LoggedQuery> query_log = make_query_log(corpus, config.queries, random);
+
+    // Поток токенов и словарь для контейнеров
+    std::vector<std::string> tokens;
+    for (size_t i = 0; i < 100000; ++i) {
+        tokens.push_back(corpus.next_word());
+    }
+    std::vector<std::string> vocabulary;
+    for (size_t r = 0; r < model.vocabulary_size; ++r) {
+        vocabulary.push_back(corpus.word_at(r));
+    }
+    std::sort(vocabulary.begin(), vocabulary.end());
+    vocabulary.erase(std::unique(vocabulary.begin(), vocabulary.end()), vocabulary.end());
+    std::shuffle(vocabulary.begin(), vocabulary.end(), random);
+
+    const size_t token_batch = 1000;
+    auto token_at = [&](size_t sample, size_t i) -> const std::string& {
+        return tokens[(sample * token_batch + i) % tokens.size()];
+    };
+
+    std::cerr << "Micro benchmarks:" << std::endl;
+
+    Tokenizer tokenizer;
+    const size_t doc_batch = std::min<size_t>(64, documents.size());
+    suite.run("tokenizer", "micro", "doc", doc_batch, Budget{}, [&](size_t sample) {
+        uint64_t total = 0;
+        for (size_t i = 0; i < doc_batch; ++i) {
+            total += tokenizer.tokenize(documents[(sample * doc_batch + i) % documents.size()].content)
+                         .tokens.size();
+        }
+        return total;
+    });
+
+    Stemmer stemmer;
+    suite.run("stemmer", "micro", "word", token_batch, Budget{}, [&](size_t sample) {
+        uint64_t total = 0;
+        for (size_t i = 0; i < token_batch; ++i) {
+            total += stemmer.stem(token_at(sample, i)).size();
+        }
+        return total;
+    });
+
+    HashTable<std::string, uint32_t> frequencies;
+    suite.run("hash_table_upsert", "micro", "op", token_batch, Budget{}, [&](size_t sample) {
+        uint64_t total = 0;
+        for (size_t i = 0; i < token_batch; ++i) {
+            total += ++frequencies[token_at(sample, i)];
+        }
+        return total;
+    });
+
+    // Поиск идет по заполненным контейнерам, даже если вставка отфильтрована
+    if (!frequencies.contains(tokens.front())) {
+        for (const auto& token : tokens) {
+            frequencies[token]++;
+        }
+    }
+
+    suite.run("hash_table_find", "micro", "op", token_batch, Budget{}, [&](size_t sample) {
+        uint64_t total = 0;
+        for (size_t i = 0; i < token_batch; ++i) {
+            const uint32_t* count = frequencies.find(token_at(sample, i));
+            total += count ? *count : 0;
+        }
+        return total;
+    });
+
+    // Вставка: каждая выборка строит дерево заново по всему словарю
+    BinarySearchTree<std::string, uint32_t> tree;
+    Budget insert_budget{5, 100, 300.0, 5000.0};
+    suite.run("bst_insert", "micro", "op", vocabulary.size(), insert_budget, [&](size_t) {
+        for (size_t i = 0; i < vocabulary.size(); ++i) {
+            tree.insert(vocabulary[i], static_cast<uint32_t>(i));
+        }
+        return vocabulary.size();
+    }, [&] { tree.clear(); });
+
+    if (!tree.contains(vocabulary.front())) {
+        for (size_t i = 0; i < vocabulary.size(); ++i) {
+            tree.insert(vocabulary[i], static_cast<uint32_t>(i));
+        }
+    }
+
+    suite.run("bst_find", "micro", "op", token_batch, Budget{}, [&](size_t sample) {
+        uint64_t total = 0;
+        uint32_t value = 0;
+        for (size_t i = 0; i < token_batch; ++i) {
+            total += tree.get(token_at(sample, i), value) ? value : 0;
+        }
+        return total;
+    });
+
+    BTreeMap<std::string, uint32_t> btree;
+    suite.run("btree_insert", "micro", "op", vocabulary.size(), insert_budget, [&](size_t) {
+        for (size_t i = 0; i < vocabulary.size(); ++i) {
+            btree.insert(vocabulary[i], static_cast<uint32_t>(i));
+        }
+        return vocabulary.size();
+    }, [&] { btree.clear(); });
+
+    if (!btree.find(vocabulary.front())) {
+        for (size_t i = 0; i < vocabulary.size(); ++i) {
+            btree.insert(vocabulary[i], static_cast<uint32_t>(i));
+        }
+    }
+
+    suite.run("btree_find", "micro", "op", token_batch, Budget{}, [&](size_t sample) {
+        uint64_t total = 0;
+        for (size_t i = 0; i < token_batch; ++i) {
+            const uint32_t* value = btree.find(token_at(sample, i));
+            total += value ? *value : 0;
+        }
+        return total;
+    });
+
+    // Запись метрик на пути запроса: одно событие должно стоить единицы наносекунд
+    Counter& counter = MetricsRegistry::global().counter("bench_events_total", "Benchmark events");
+    suite.run("metrics_counter_add", "micro", "op", token_batch, Budget{}, [&](size_t) {
+        for (size_t i = 0; i < token_batch; ++i) {
+            counter.add();
+        }
+        return counter.value();
+    });
+
+    LatencyHistogram& histogram = MetricsRegistry::global().histogram(
+        "bench_latency_seconds", "Benchmark latencies");
+    suite.run("metrics_histogram_record", "micro", "op", token_batch, Budget{}, [&](size_t sample) {
+        for (size_t i = 0; i < token_batch; ++i) {
+            histogram.record((sample * token_batch + i) * 997 % 100000000);
+        }
+        return sample;
+    });
+
+    // Индекс для замеров поиска; файл во временном каталоге удаляется в конце
+    std::filesystem::path index_path = std::filesystem::temp_directory_path() /
+        ("fashion_search_bench_" + std::to_string(config.seed) + ".bin");
+    std::string index_file = index_path.string();
+
+    BooleanIndexBuilder builder;
+    builder.build_from_documents(documents);
+    builder.save_index(index_file);
+    auto index_stats = builder.get_statistics();
+    std::cerr << "  (index: " << index_stats.total_terms << " terms, "
+              << index_stats.total_postings << " postings)" << std::endl;
+
+    BooleanSearch searcher(builder);
+    std::mt19937_64 query_random(config.seed + 1);
+    const size_t query_batch = 32;
+    struct SetKernel {
+        const char* name;
+        const char* op;
+        size_t first_rank;
+        size_t last_rank;
+    };
+    // Частые термины - длинные списки, средние - короткие
+    const SetKernel kernels[] = {
+        {"set_intersect_frequent", " && ", 0, 20},
+        {"set_intersect_mixed", " && ", 0, 2000},
+        {"set_union_frequent", " || ", 0, 20},
+        {"set_union_mixed", " || ", 0, 2000},
+        {"set_difference", " !", 0, 200},
+    };
+    for (const auto& kernel : kernels) {
+        auto queries = make_set_queries(corpus, kernel.op, kernel.first_rank,
+                                        kernel.last_rank, query_batch, query_random);
+        suite.run(kernel.name, "micro", "query", query_batch, Budget{}, [&, queries](size_t) {
+            uint64_t total = 0;
+            for (const auto& query : queries) {
+                total += searcher.search(query).size();
+            }
+            return total;
+        });
+    }
+
+    BooleanIndexBuilder loaded;
+    suite.run("index_load", "micro", "load", 1, Budget{10, 1000, 300.0, 5000.0}, [&](size_t) {
+        return static_cast<uint64_t>(loaded.load_index(index_file));
+    });
+
+    // find_term по словарю файла: существующие термины и 10% промахов
+    BinaryIndexReader reader(index_file);
+    uint32_t doc_count = 0, term_count = 0;
+    reader.read_header(doc_count, term_count);
+    std::vector<std::string> lookup_terms;
+    for (const auto& [term, postings] : builder.get_inverted_index()) {
+        lookup_terms.push_back(term);
+    }
+    std::sort(lookup_terms.begin(), lookup_terms.end());
+    std::shuffle(lookup_terms.begin(), lookup_terms.end(), query_random);
+    lookup_terms.resize(std::min<size_t>(lookup_terms.size(), token_batch));
+    for (size_t i = 0; i < lookup_terms.size(); i += 10) {
+        lookup_terms[i] += "zq";
+    }
+    if (!lookup_terms.empty()) {
+        suite.run("find_term", "micro", "op", lookup_terms.size(), Budget{}, [&](size_t) {
+            uint64_t total = 0;
+            for (const auto& term : lookup_terms) {
+                total += reader.find_term(term).size();
+            }
+            return total;
+        });
+    }
+
+    std::cerr << "Macro benchmarks:" << std::endl;
+
+    BooleanIndexBuilder rebuilt;
+    suite.run("index_build", "macro", "doc", documents.size(), Budget{3, 20, 0.0, 20000.0},
+              [&](size_t) {
+        rebuilt.build_from_documents(documents);
+        return rebuilt.get_statistics().total_postings;
+    });
+
+    // Повтор журнала: пачка - один запрос, поэтому p99 - хвост задержек запросов
+    BooleanSearch replay(loaded);
+    Budget replay_budget{query_log.size(), query_log.size(), 0.0, 1e9};
+    suite.run("query_log_replay", "macro", "query", 1, replay_budget, [&](size_t sample) {
+        const LoggedQuery& query = query_log[sample % query_log.size()];
+        switch (query.kind) {
+            case LoggedQuery::Kind::COUNT:
+                return static_cast<uint64_t>(replay.count(query.text));
+            case LoggedQuery::Kind::RANKED:
+                return static_cast<uint64_t>(replay.search_ranked(query.text, 10).size());
+            default:
+                return static_cast<uint64_t>(replay.search(query.text).size());
+        }
+    });
+
+    // Полнота кластеризации на масштабе: каждая подложенная пара должна
+    // попасть в один кластер
+    bool duplicates_ok = true;
+    if (suite.enabled("near_duplicate_clusters")) {
+        NearDuplicateDetector detector;
+        std::vector<std::pair<uint32_t, uint32_t>> pairs;
+        std::mt19937_64 duplicate_random(config.seed + 2);
+        fill_duplicate_detector(corpus, config.duplicate_docs, duplicate_random, detector, pairs);
+
+        std::vector<uint32_t> clusters;
+        suite.run("near_duplicate_clusters", "macro", "doc", detector.size(),
+                  Budget{1, 1, 0.0, 0.0}, [&](size_t) {
+            clusters = detector.clusters();
+            return static_cast<uint64_t>(clusters.back());
+        });
+
+        size_t found = 0;
+        for (const auto& [original, copy] : pairs) {
+            found += clusters[original] == clusters[copy];
+        }
+        std::cerr << "  (near duplicates: " << found << "/" << pairs.size()
+                  << " planted pairs found in " << detector.size() << " documents)" << std::endl;
+        duplicates_ok = found == pairs.size();
+    }
+
+    std::error_code error;
+    std::filesystem::remove(index_path, error);
+    std::filesystem::remove(index_file + ".store", error);
+
+    if (config.json_file.empty()) {
+        std::ostream out(quiet.original());
+        write_json(out, config, suite.get_results());
+    } else {
+        std::ofstream out(config.json_file);
+        if (!out) {
+            std::cerr << "Error: Cannot write " << config.json_file << std::endl;
+            return 1;
+        }
+        write_json(out, config, suite.get_results());
+        std::cerr << "Results written to " << config.json_file << std::endl;
+    }
+
+    if (!duplicates_ok) {
+        std::cerr << "Error: Near-duplicate clustering missed planted pairs" << std::endl;
+        return 1;
+    }
+    return 0;
+}
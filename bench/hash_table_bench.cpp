@@ -0,0 +1,149 @@
+// Сравнение HashTable и std::unordered_map на подсчете частот токенов.
+// Запуск: hash_table_bench [количество токенов] [размер словаря]
+
+#include "hash_table.hpp"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// Словарь со случайными словами и поток токенов по закону Ципфа
+std::vector<std::string> make_vocabulary(size_t size, std::mt19937_64& random) {
+    std::vector<std::string> vocabulary;
+    vocabulary.reserve(size);
+    std::uniform_int_distribution<int> length(3, 12);
+    std::uniform_int_distribution<int> letter('a', 'z');
+
+    for (size_t i = 0; i < size; ++i) {
+        std::string word(length(random), ' ');
+        for (auto& c : word) {
+            c = static_cast<char>(letter(random));
+        }
+        vocabulary.push_back(word + std::to_string(i));
+    }
+    return vocabulary;
+}
+
+std::vector<std::string_view> make_tokens(const std::vector<std::string>& vocabulary,
+                                          size_t count, std::mt19937_64& random) {
+    std::vector<double> weights(vocabulary.size());
+    for (size_t i = 0; i < weights.size(); ++i) {
+        weights[i] = 1.0 / (i + 1);
+    }
+    std::discrete_distribution<size_t> rank(weights.begin(), weights.end());
+
+    std::vector<std::string_view> tokens;
+    tokens.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        tokens.push_back(vocabulary[rank(random)]);
+    }
+    return tokens;
+}
+
+template<typename Function>
+double measure_ms(Function&& function) {
+    auto start = std::chrono::high_resolution_clock::now();
+    function();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void report(const char* name, double table_ms, double map_ms) {
+    std::cout << "  " << std::left << std::setw(22) << name << std::right << std::fixed
+              << std::setprecision(1) << std::setw(10) << table_ms << " ms"
+              << std::setw(11) << map_ms << " ms" << std::setw(8) << std::setprecision(2)
+              << map_ms / table_ms << "x" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    size_t token_count = argc > 1 ? std::stoul(argv[1]) : 5000000;
+    size_t vocabulary_size = argc > 2 ? std::stoul(argv[2]) : 200000;
+
+    std::mt19937_64 random(42);
+    auto vocabulary = make_vocabulary(vocabulary_size, random);
+    auto tokens = make_tokens(vocabulary, token_count, random);
+
+    std::cout << "Tokens: " << token_count << ", vocabulary: " << vocabulary_size << std::endl;
+    std::cout << "  " << std::left << std::setw(22) << "operation" << std::right
+              << std::setw(13) << "HashTable" << std::setw(14) << "unordered_map"
+              << std::setw(9) << "speedup" << std::endl;
+
+    HashTable<std::string, int> table;
+    std::unordered_map<std::string, int> map;
+    long long checksum = 0;
+
+    // Подсчет: в unordered_map (C++17) поиск по string_view требует строки
+    double table_ms = measure_ms([&] {
+        for (auto token : tokens) {
+            table[token]++;
+        }
+    });
+    double map_ms = measure_ms([&] {
+        for (auto token : tokens) {
+            map[std::string(token)]++;
+        }
+    });
+    report("count tokens", table_ms, map_ms);
+
+    table_ms = measure_ms([&] {
+        for (auto token : tokens) {
+            checksum += *table.find(token);
+        }
+    });
+    map_ms = measure_ms([&] {
+        std::string key;
+        for (auto token : tokens) {
+            key.assign(token);
+            checksum -= map.find(key)->second;
+        }
+    });
+    report("find (hit)", table_ms, map_ms);
+
+    std::vector<std::string> misses;
+    for (size_t i = 0; i < vocabulary_size; ++i) {
+        misses.push_back(vocabulary[i] + "#");
+    }
+    table_ms = measure_ms([&] {
+        for (int round = 0; round < 10; ++round) {
+            for (const auto& key : misses) {
+                checksum += table.contains(key);
+            }
+        }
+    });
+    map_ms = measure_ms([&] {
+        for (int round = 0; round < 10; ++round) {
+            for (const auto& key : misses) {
+                checksum += map.count(key);
+            }
+        }
+    });
+    report("find (miss)", table_ms, map_ms);
+
+    table_ms = measure_ms([&] {
+        for (size_t i = 0; i < vocabulary_size; i += 2) {
+            checksum += table.remove(vocabulary[i]);
+        }
+    });
+    map_ms = measure_ms([&] {
+        for (size_t i = 0; i < vocabulary_size; i += 2) {
+            checksum -= map.erase(vocabulary[i]);
+        }
+    });
+    report("remove half", table_ms, map_ms);
+
+    if (checksum != 0 || table.get_count() != map.size()) {
+        std::cerr << "Results differ: " << table.get_count() << " vs " << map.size() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,48 @@
+#ifndef ANALYZER_HPP
+#define ANALYZER_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "tokenizer.hpp"
+#include "stemmer.hpp"
+
+/*
+ * Общий конвейер анализа текста для построения индекса и для запросов:
+ * токенизация (с фильтрами Tokenizer) -> стемминг -> фильтр длины.
+ * Результаты стемминга кэшируются, поэтому объект стоит создавать один
+ * раз на поток и переиспользовать между документами и запросами.
+ */
+class Analyzer {
+public:
+    explicit Analyzer(size_t cache_capacity = 65536);
+
+    // Термины текста документа; out очищается и переиспользуется
+    void analyze(const std::string& text, std::vector<std::string>& out);
+
+    // Термины одного слова запроса (пусто, если это стоп-слово)
+    std::vector<std::string> analyze_query_term(const std::string& raw);
+
+    // Нормализация токена, уже прошедшего токенизатор; пустая строка -
+    // термин отбрасывается
+    const std::string& normalize_token(const std::string& token);
+
+    size_t get_cache_hits() const { return cache_hits; }
+    size_t get_cache_misses() const { return cache_misses; }
+
+private:
+    Tokenizer tokenizer;
+    Stemmer stemmer;
+
+    std::unordered_map<std::string, std::string> term_cache;
+    size_t cache_capacity;
+    size_t cache_hits = 0;
+    size_t cache_misses = 0;
+
+    // Уже переданные в метрики (раз на текст, не на каждый токен)
+    size_t reported_hits = 0;
+    size_t reported_misses = 0;
+    void report_cache_metrics();
+};
+
+#endif
@@ -2,98 +2,437 @@
 #define BINARY_INDEX_FORMAT_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cstdint>
-#include <fstream>
+#include <atomic>
+#include <memory>
+#include <memory_resource>
+#include "document.hpp"
+#include "forward_index.hpp"
+#include "facet_index.hpp"
+#include "numeric_column.hpp"
+#include "file_writer.hpp"
+#include <map>
 
 /*
  * Бинарный формат индекса:
  *
- * Файл состоит из заголовка, прямого индекса и обратного индекса.
+ * Файл состоит из заголовка, прямого индекса, обратного индекса,
+ * словаря терминов и таблицы секций.
  *
- * 1. Заголовок (32 байта):
+ * Файл пишется во временный файл и публикуется атомарным переименованием
+ * (FileWriter), поэтому читатель не видит недописанный индекс.
+ *
+ * 1. Заголовок (56 байт):
  *    [magic: 4 байта] = "FASH"
- *    [version: 2 байта] = 1
+ *    [version: 2 байта] = 8
+ *    [flags: 2 байта] = 0
  *    [doc_count: 4 байта] = количество документов
  *    [term_count: 4 байта] = количество уникальных терминов
  *    [forward_offset: 8 байт] = смещение к прямому индексу
  *    [inverted_offset: 8 байт] = смещение к обратному индексу
- *    [reserved: 2 байта] = 0
+ *    [sections_offset: 8 байт] = смещение к таблице секций
+ *    [checksums_offset: 8 байт] = смещение к контрольным суммам
+ *    [store_id: 8 байт] = идентификатор хранилища текстов (<индекс>.store),
+ *                         записанного вместе с индексом
  *
- * 2. Прямой индекс:
- *    [doc_count] записей, каждая:
- *      [id_len: 1 байт] - длина ID
- *      [id: id_len байт] - ID документа
- *      [url_len: 2 байта] - длина URL
- *      [url: url_len байт] - URL документа
- *      [title_len: 2 байта] - длина заголовка
- *      [title: title_len байт] - заголовок документа
- *      [doc_length: 4 байта] - количество терминов в документе
- *      [checksum: 4 байта] - контрольная сумма
+ * 2. Прямой индекс (по колонкам, начало выровнено на 8 байт):
+ *    [doc_count: 4 байта]
+ *    [field_count: 4 байта] = 3 (id, url, title)
+ *    [strings_size: 8 байт]
+ *    [offsets: (doc_count * field_count + 1) * 4 байта] - границы полей в строках
+ *    [doc_lengths: doc_count * 4 байта] - количество терминов в документе
+ *    [strings: strings_size байт] - поля всех документов подряд
  *
  * 3. Обратный индекс:
- *    [term_count] записей, каждая:
+ *    [term_count] записей, отсортированных по термину, каждая:
  *      [term_len: 1 байт] - длина термина
  *      [term: term_len байт] - термин (нижний регистр)
  *      [doc_count: 4 байта] - количество документов с этим термином
- *      [doc_ids: doc_count * 4 байт] - список ID документов
+ *      [ids_length: 4 байта] - размер закодированного списка ID
+ *      [tfs_length: 4 байта] - размер закодированных частот
+ *      [doc_ids: ids_length байт] - первый ID и разности соседних ID (varint)
+ *      [tfs: tfs_length байт] - частота термина в каждом документе (varint)
+ *
+ * 4. Словарь терминов (front coding):
+ *    [term_count: 4 байта]
+ *    [block_size: 4 байта] - терминов в блоке
+ *    [block_count: 4 байта]
+ *    [reserved: 4 байта]
+ *    [total_postings: 8 байт]
+ *    [block_offsets: block_count * 4 байт] - смещения блоков от начала области блоков
+ *    Блоки, в каждом до block_size терминов:
+ *      [prefix_len: 1 байт] - общий префикс с предыдущим термином (0 для первого)
+ *      [suffix_len: 1 байт]
+ *      [suffix: suffix_len байт]
+ *      [doc_freq: varint]
+ *      [postings: varint] - для первого термина блока абсолютное смещение
+ *                           списка doc_count в файле, для остальных - разница
+ *                           с предыдущим термином
+ *
+ *    Первый термин блока хранится целиком, поэтому поиск идет бинарным
+ *    поиском по блокам прямо в отображенном в память файле и линейным
+ *    проходом внутри одного блока.
+ *
+ * 5. Индекс триграмм для запросов с подстановкой (*):
+ *    [gram_count: 4 байта]
+ *    [reserved: 4 байта]
+ *    [gram_count] записей, отсортированных по триграмме:
+ *      [gram: 3 байта] - триграмма термина, обрамленного символами '$'
+ *      [reserved: 1 байт]
+ *      [list_offset: 4 байта] - номер первого элемента списка
+ *      [list_size: 4 байта]
+ *    [ordinals: 4 байта каждый] - порядковые номера терминов в словаре
+ *
+ * 6. Фильтры (source, category), начало выровнено на 8 байт:
+ *    [field_count: 4 байта]
+ *    [doc_count: 4 байта]
+ *    Для каждого поля:
+ *      [name_len: 1 байт][name]
+ *      [value_count: 4 байта]
+ *      Для каждого значения:
+ *        [value_len: 1 байт][value]
+ *        [kind: 1 байт] - 0 карта, 1 список (меньше doc_count / 32 документов)
+ *        Карта:
+ *          [выравнивание до 8 байт]
+ *          [bitmap: (doc_count + 63) / 64 * 8 байт] - документы со значением
+ *        Список:
+ *          [id_count: 4 байта]
+ *          [выравнивание до 4 байт]
+ *          [doc_ids: id_count * 4 байта] - документы по возрастанию ID
+ *
+ * 7. Числовые колонки (word_count), начало выровнено на 8 байт:
+ *    [column_count: 4 байта]
+ *    [doc_count: 4 байта]
+ *    Для каждой колонки:
+ *      [name_len: 1 байт][name]
+ *      [bit_width: 4 байта] - бит на значение
+ *      [min_value: 4 байта] - значения хранятся как value - min_value
+ *      [max_value: 4 байта]
+ *      [выравнивание до 8 байт]
+ *      [data: (doc_count * bit_width + 7) / 8 + 8 байт] - упакованные значения
+ *
+ * 8. Верхний уровень (hot tier) для ранжированного поиска, начало
+ *    выровнено на 8 байт. Только для терминов, у которых документов
+ *    больше tier_size:
+ *    [term_count: 4 байта]
+ *    [tier_size: 4 байта] - документов в списке верхнего уровня
+ *    [term_count] записей, отсортированных по postings_offset:
+ *      [postings_offset: 8 байт] - список термина в обратном индексе
+ *      [list_offset: 8 байт] - смещение списка верхнего уровня в файле
+ *    Списки:
+ *      [count: 4 байта]
+ *      [max_rest_tf: 4 байта] - максимальная частота среди остальных документов
+ *      [doc_ids: count * 4 байта] - документы с наибольшей частотой, по возрастанию ID
+ *      [tfs: count * 4 байта]
+ *
+ * 9. Самые частые термины (для прогрева), начало выровнено на 8 байт:
+ *    [term_count: 4 байта] - не больше 4096
+ *    [reserved: 4 байта]
+ *    [term_count] записей по убыванию doc_freq (при равенстве - по термину):
+ *      [postings_offset: 8 байт] - список термина в обратном индексе
+ *      [postings_length: 8 байт] - его размер вместе с заголовком списка
+ *    Прогрев подгружает списки по этой таблице, не разбирая словарь.
+ *
+ * 10. Таблица секций:
+ *    [section_count: 4 байта]
+ *    [section_count] записей: [id: 4 байта][offset: 8 байт][length: 8 байт]
+ *
+ * 11. Контрольные суммы CRC32C (в конце файла):
+ *    [block_size: 4 байта]
+ *    [block_count: 4 байта]
+ *    [header_crc: 4 байта] - CRC заголовка
+ *    [reserved: 4 байта]
+ *    [block_crc: block_count * 4 байта] - CRC блоков по block_size байт
+ *      от конца заголовка до начала контрольных сумм (все секции и таблица)
+ *    Суммы блоков, а не секций целиком: читатель проверяет только те
+ *    блоки, которые действительно читает.
  */
 
+enum class SectionId : uint32_t {
+    FORWARD = 1,
+    INVERTED = 2,
+    DICTIONARY = 3,
+    KGRAMS = 4,
+    FACETS = 5,
+    DOC_VALUES = 6,
+    HOT_TIER = 7,
+    FREQUENT_TERMS = 8
+};
+
+// Положение списка документов термина в файле
+struct TermInfo {
+    uint32_t doc_freq = 0;
+    uint64_t postings_offset = 0;  // Смещение поля doc_count
+};
+
+// Список документов термина с частотами (для ранжирования)
+struct WeightedPostings {
+    std::vector<uint32_t> doc_ids;
+    std::vector<uint32_t> frequencies;
+    uint32_t doc_freq = 0;  // Документов с термином во всем индексе
+    // Для неполного списка (верхний уровень): граница частот остальных
+    // документов; 0 - список полный
+    uint32_t max_rest_frequency = 0;
+};
+
 class BinaryIndexWriter {
 public:
     BinaryIndexWriter(const std::string& filename);
     ~BinaryIndexWriter();
 
-    void write_header(uint32_t doc_count, uint32_t term_count);
+    // store_id - идентификатор хранилища текстов, сохраненного с индексом
+    void write_header(uint32_t doc_count, uint32_t term_count, uint64_t store_id);
+
+    void write_forward_index(const ForwardIndex& index);
+
+    // Обратный индекс пишется по одному термину в порядке возрастания
+    // терминов, списки не копируются. frequencies - частоты тех же
+    // документов (пусто - все 1)
+    void begin_inverted_index(uint32_t term_count);
+    void add_term(const std::string& term, const std::vector<uint32_t>& doc_ids,
+                  const std::vector<uint32_t>& frequencies = {});
+    void end_inverted_index();
+
+    // Размер списков верхнего уровня; задается до begin_inverted_index (0 - без него)
+    void set_hot_tier_size(uint32_t size);
+    void write_hot_tier();
+
+    // Словарь строится по терминам, записанным add_term
+    void write_dictionary(uint32_t block_size = 16);
+
+    // Триграммы терминов словаря для раскрытия шаблонов *infix*
+    void write_kgram_index();
+
+    // Битовые карты значений полей-фильтров
+    void write_facets(const FacetIndex& facets);
+
+    // Упакованные числовые колонки (поле -> колонка)
+    void write_doc_values(const std::map<std::string, NumericColumn>& columns);
 
-    void write_forward_index(const std::vector<ForwardIndexEntry>& entries);
+    // Положения списков самых частых терминов, записанных add_term
+    void write_frequent_terms();
 
-    void write_inverted_index(const std::vector<std::pair<std::string, std::vector<uint32_t>>>& entries);
+    // Записывает таблицу секций и контрольные суммы, обновляет заголовок
+    // и публикует файл (до вызова целевой файл не меняется)
+    void finish();
 
-    uint64_t get_position() const;
+    // Размер закодированных списков документов
+    uint64_t get_postings_bytes() const { return postings_bytes; }
+
+    uint64_t get_position();
 
 private:
-    std::ofstream file;
+    struct SectionEntry {
+        SectionId id;
+        uint64_t offset;
+        uint64_t length;
+    };
+
+    FileWriter file;
+    std::vector<SectionEntry> sections;
+    std::vector<std::pair<std::string, TermInfo>> dictionary_terms;
+    uint64_t postings_bytes = 0;
+
+    // Запись обратного индекса
+    uint64_t inverted_offset = 0;
+    uint32_t expected_terms = 0;
+    std::string encoded_ids;
+    std::string encoded_frequencies;
+    std::vector<uint32_t> ones;
+
+    struct HotList {
+        uint64_t postings_offset;
+        uint32_t max_rest_frequency;
+        std::vector<uint32_t> doc_ids;
+        std::vector<uint32_t> frequencies;
+    };
+
+    uint32_t hot_tier_size = 0;
+    std::vector<HotList> hot_lists;
+
+    // Самые частые термины: куча с наименьшим doc_freq в вершине
+    struct FrequentList {
+        uint32_t doc_freq;
+        uint64_t postings_offset;
+        uint64_t postings_length;
+    };
+    std::vector<FrequentList> frequent_lists;
+
+    void add_section(SectionId id, uint64_t offset);
 
     void write_string(const std::string& str, bool length_first = true);
     void write_uint32(uint32_t value);
     void write_uint16(uint16_t value);
     void write_uint8(uint8_t value);
     void write_uint64(uint64_t value);
+    void write_varint(uint64_t value);
+    void write_padding(uint64_t alignment);
 };
 
+/*
+ * Читатель отображает файл в память (mmap). Заголовок и таблица секций
+ * разбираются при открытии, словарь не загружается: все операции над ним
+ * работают напрямую по отображенным байтам, поэтому методы поиска const
+ * и могут вызываться из нескольких потоков.
+ *
+ * С verify_checksums каждый блок файла проверяется по CRC32C при первом
+ * чтении байт из него (отметки проверенных блоков атомарные), поэтому
+ * загрузка не читает весь файл, а поврежденные данные дают исключение.
+ */
 class BinaryIndexReader {
 public:
-    BinaryIndexReader(const std::string& filename);
+    BinaryIndexReader(const std::string& filename, bool verify_checksums = false);
     ~BinaryIndexReader();
 
+    BinaryIndexReader(const BinaryIndexReader&) = delete;
+    BinaryIndexReader& operator=(const BinaryIndexReader&) = delete;
+
     bool read_header(uint32_t& doc_count, uint32_t& term_count);
 
-    std::vector<ForwardIndexEntry> read_forward_index();
+    // Колонки прямого индекса в отображенном файле (живут, пока жив читатель)
+    ForwardIndex read_forward_index() const;
+
+    // Фильтры в отображенном файле (живут, пока жив читатель; пустые,
+    // если секции нет)
+    FacetIndex read_facets() const;
+
+    // Числовые колонки в отображенном файле (пусто, если секции нет)
+    std::map<std::string, NumericColumn> read_doc_values() const;
+
+    std::vector<std::pair<std::string, std::vector<uint32_t>>> read_inverted_index() const;
+
+    std::vector<uint32_t> find_term(const std::string& term) const;
+
+    // Операции над словарем
+    bool lookup_term(const std::string& term, TermInfo& info) const;
+    std::vector<uint32_t> read_postings(const TermInfo& info) const;
+    // Разбор в готовый список: его память задает вызывающий (арена запроса)
+    void read_postings(const TermInfo& info, std::pmr::vector<uint32_t>& doc_ids) const;
+    WeightedPostings read_weighted_postings(const TermInfo& info) const;
+
+    // Список верхнего уровня; false, если у термина его нет (список короткий)
+    bool read_hot_postings(const TermInfo& info, WeightedPostings& postings) const;
+    bool has_hot_tier() const { return hot_tier_size > 0; }
+
+    // Термины с заданным префиксом в порядке сортировки (не более limit)
+    std::vector<std::pair<std::string, TermInfo>> terms_with_prefix(const std::string& prefix,
+                                                                    size_t limit) const;
+
+    // Термины из полуинтервала [from, to); пустой to - до конца словаря
+    std::vector<std::pair<std::string, TermInfo>> terms_in_range(const std::string& from,
+                                                                 const std::string& to,
+                                                                 size_t limit) const;
+
+    // Термины, подходящие под шаблон с '*' (не более limit)
+    std::vector<std::pair<std::string, TermInfo>> terms_matching(const std::string& pattern,
+                                                                 size_t limit) const;
+
+    // Термины на расстоянии Левенштейна не больше max_edits,
+    // по убыванию doc_freq (не более limit)
+    std::vector<std::pair<std::string, TermInfo>> fuzzy_terms(const std::string& term,
+                                                              uint32_t max_edits,
+                                                              size_t limit) const;
 
-    std::vector<std::pair<std::string, std::vector<uint32_t>>> read_inverted_index();
+    bool term_at(uint32_t ordinal, std::string& term, TermInfo& info) const;
 
-    std::vector<uint32_t> find_term(const std::string& term);
+    // Сколько самых частых терминов записано при построении (секция 9)
+    size_t get_frequent_term_count() const { return frequent_count; }
 
-    ForwardIndexEntry get_document_info(uint32_t doc_id);
+    // Подсказка ядру (madvise WILLNEED) заранее прочитать страницы файла:
+    // чтение идет в фоне, вызов не ждет диска. Возвращают размер области
+    // в байтах. prefetch_dictionary - словарь и верхний уровень,
+    // prefetch_frequent_postings - список термина с номером rank по
+    // убыванию doc_freq (положение берется из таблицы, файл не читается)
+    uint64_t prefetch_dictionary() const;
+    uint64_t prefetch_frequent_postings(size_t rank) const;
+
+    uint32_t get_term_count() const { return dict_term_count; }
+
+    // Идентификатор хранилища текстов, записанного вместе с индексом
+    uint64_t get_store_id() const { return store_id; }
+
+    // Байты сжатых списков, разобранные вызывающим потоком всеми читателями
+    // (разность до и после запроса - объем, прочитанный запросом)
+    static uint64_t thread_decoded_bytes();
+    uint64_t get_total_postings() const { return dict_total_postings; }
 
 private:
-    std::ifstream file;
+    const uint8_t* data = nullptr;
+    size_t data_size = 0;
+
     uint64_t forward_offset = 0;
     uint64_t inverted_offset = 0;
+    uint64_t sections_offset = 0;
+    uint64_t checksums_offset = 0;
     uint32_t total_docs = 0;
     uint32_t total_terms = 0;
+    uint64_t store_id = 0;
+
+    // Словарь (указатели в отображенный файл)
+    uint32_t dict_term_count = 0;
+    uint32_t dict_block_size = 0;
+    uint32_t dict_block_count = 0;
+    uint64_t dict_total_postings = 0;
+    uint64_t dict_offsets_pos = 0;
+    uint64_t dict_blocks_pos = 0;
+    uint64_t dict_end_pos = 0;
+
+    // Индекс триграмм
+    uint32_t kgram_count = 0;
+    uint64_t kgram_table_pos = 0;
+    uint64_t kgram_lists_pos = 0;
+
+    // Верхний уровень
+    uint32_t hot_count = 0;
+    uint32_t hot_tier_size = 0;
+    uint64_t hot_table_pos = 0;
+
+    // Самые частые термины
+    uint32_t frequent_count = 0;
+    uint64_t frequent_table_pos = 0;
+
+    bool find_section(SectionId id, uint64_t& offset, uint64_t& length) const;
+    void read_dictionary_header();
+    void read_kgram_header();
+    void read_hot_tier_header();
+    void read_frequent_terms_header();
+
+    // Разбор списка: ID и (если frequencies не nullptr) частоты
+    template <typename List>
+    void decode_postings(const TermInfo& info, List& doc_ids,
+                         std::vector<uint32_t>* frequencies) const;
+
+    std::vector<uint32_t> kgram_ordinals(std::string_view gram) const;
+
+    std::string_view block_first_term(uint32_t block) const;
+    uint32_t find_block(std::string_view term) const;
+
+    // Проход по терминам начиная с первого >= from, пока callback возвращает true
+    template<typename Callback>
+    void scan_terms(std::string_view from, Callback&& callback) const;
+
+    // Контрольные суммы блоков (только при проверке)
+    bool verify_checksums = false;
+    uint32_t checksum_block_size = 0;
+    uint32_t checksum_block_count = 0;
+    uint64_t checksum_table_pos = 0;
+    std::unique_ptr<std::atomic<uint8_t>[]> verified_blocks;
 
-    std::string read_string(bool length_first = true);
-    uint32_t read_uint32();
-    uint16_t read_uint16();
-    uint8_t read_uint8();
-    uint64_t read_uint64();
+    bool read_checksums();
+    void verify_range(uint64_t pos, uint64_t length) const;
+    void verify_block(uint64_t block) const;
 
-    std::vector<ForwardIndexEntry> forward_cache;
-    std::vector<std::pair<std::string, uint64_t>> term_positions;
+    void check_range(uint64_t pos, uint64_t length) const;
+    uint64_t prefetch_range(uint64_t pos, uint64_t length) const;
 
-    void build_term_index();
+    std::string read_string(uint64_t& pos, bool length_first = true) const;
+    uint32_t read_uint32(uint64_t& pos) const;
+    uint16_t read_uint16(uint64_t& pos) const;
+    uint8_t read_uint8(uint64_t& pos) const;
+    uint64_t read_uint64(uint64_t& pos) const;
+    uint64_t read_varint(uint64_t& pos) const;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,157 @@
+#ifndef BITMAP_HPP
+#define BITMAP_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Битовое множество ID документов фиксированного размера.
+// Карта либо владеет словами, либо ссылается на слова отображенного файла
+// (view); представление только читается, изменение сначала копирует слова
+class Bitmap {
+private:
+    std::vector<uint64_t> words;
+    const uint64_t* mapped = nullptr;  // Слова представления
+    size_t bit_count;
+
+    const uint64_t* bits() const { return mapped ? mapped : words.data(); }
+
+    void own() {
+        if (mapped) {
+            words.assign(mapped, mapped + word_count());
+            mapped = nullptr;
+        }
+    }
+
+public:
+    explicit Bitmap(size_t size = 0)
+        : words((size + 63) / 64, 0), bit_count(size) {}
+
+    // Готовые слова (например, прочитанные из файла индекса)
+    Bitmap(size_t size, std::vector<uint64_t> bits)
+        : words(std::move(bits)), bit_count(size) {
+        words.resize((size + 63) / 64, 0);
+    }
+
+    // Представление слов в отображенном файле (живет, пока жив файл)
+    static Bitmap view(size_t size, const uint64_t* bits) {
+        Bitmap bitmap;
+        bitmap.bit_count = size;
+        bitmap.mapped = bits;
+        return bitmap;
+    }
+
+    // Новый размер; биты за новой границей сбрасываются
+    void resize(size_t size) {
+        own();
+        words.resize((size + 63) / 64, 0);
+        bit_count = size;
+        if (size % 64 != 0) {
+            words.back() &= (uint64_t(1) << (size % 64)) - 1;
+        }
+    }
+
+    void set(uint32_t index) {
+        own();
+        words[index >> 6] |= uint64_t(1) << (index & 63);
+    }
+
+    bool test(uint32_t index) const {
+        return (bits()[index >> 6] >> (index & 63)) & 1;
+    }
+
+    // Добавляет отсортированный или произвольный список ID
+    template<typename List>
+    void set_all(const List& ids) {
+        own();
+        for (uint32_t id : ids) {
+            if (id < bit_count) {
+                words[id >> 6] |= uint64_t(1) << (id & 63);
+            }
+        }
+    }
+
+    size_t count() const {
+        const uint64_t* data = bits();
+        size_t total = 0;
+        for (size_t w = 0; w < word_count(); ++w) {
+            total += __builtin_popcountll(data[w]);
+        }
+        return total;
+    }
+
+    std::vector<uint32_t> to_vector() const {
+        std::vector<uint32_t> result;
+        append_to(result);
+        return result;
+    }
+
+    // ID по возрастанию в конец списка (в том числе std::pmr::vector)
+    template<typename List>
+    void append_to(List& result) const {
+        result.reserve(result.size() + count());
+
+        const uint64_t* data = bits();
+        for (size_t w = 0; w < word_count(); ++w) {
+            uint64_t word = data[w];
+            while (word) {
+                result.push_back(static_cast<uint32_t>(w * 64 + __builtin_ctzll(word)));
+                word &= word - 1;
+            }
+        }
+    }
+
+    // Пересечение количества без построения результата
+    size_t count_and(const Bitmap& other) const {
+        const uint64_t* a = bits();
+        const uint64_t* b = other.bits();
+        size_t total = 0;
+        for (size_t w = 0; w < word_count(); ++w) {
+            total += __builtin_popcountll(a[w] & b[w]);
+        }
+        return total;
+    }
+
+    void and_with(const Bitmap& other) {
+        own();
+        const uint64_t* b = other.bits();
+        for (size_t w = 0; w < words.size(); ++w) {
+            words[w] &= b[w];
+        }
+    }
+
+    void or_with(const Bitmap& other) {
+        own();
+        const uint64_t* b = other.bits();
+        for (size_t w = 0; w < words.size(); ++w) {
+            words[w] |= b[w];
+        }
+    }
+
+    void and_not(const Bitmap& other) {
+        own();
+        const uint64_t* b = other.bits();
+        for (size_t w = 0; w < words.size(); ++w) {
+            words[w] &= ~b[w];
+        }
+    }
+
+    // Дополнение до [0, size)
+    void flip() {
+        own();
+        for (auto& word : words) {
+            word = ~word;
+        }
+        if (bit_count % 64 != 0) {
+            words.back() &= (uint64_t(1) << (bit_count % 64)) - 1;
+        }
+    }
+
+    size_t size() const { return bit_count; }
+
+    // Слова карты (для записи в файл и обхода итератором)
+    const uint64_t* data() const { return bits(); }
+    size_t word_count() const { return (bit_count + 63) / 64; }
+};
+
+#endif
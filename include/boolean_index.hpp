@@ -5,17 +5,58 @@
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <memory_resource>
+#include <map>
+#include <chrono>
 #include "document.hpp"
-#include "tokenizer.hpp"
-#include "stemmer.hpp"
+#include "analyzer.hpp"
+#include "forward_index.hpp"
+#include "content_store.hpp"
+#include "facet_index.hpp"
+#include "numeric_column.hpp"
+#include "near_duplicates.hpp"
 #include "binary_index_format.hpp"
+#include "scratch_arena.hpp"
 
 class BooleanIndexBuilder {
 public:
     BooleanIndexBuilder();
 
+    // Что делать с почти-дубликатами при построении
+    enum class DedupMode {
+        NONE,
+        COLLAPSE,  // Оставить все, записать номер кластера (колонка cluster)
+        DROP       // Оставить только первый документ кластера
+    };
+
+    void set_dedup_mode(DedupMode mode);
+
+    // Порядок ID документов в индексе
+    enum class DocumentOrder {
+        INPUT,  // Как во входных данных
+        URL     // По URL без схемы и www: статьи одного сайта и раздела
+                // получают соседние ID, разности в списках меньше
+    };
+
+    void set_document_order(DocumentOrder order);
+
+    // Верхний уровень индекса: для частых терминов - tier_size документов
+    // с наибольшей частотой термина (0 - не строить)
+    void set_hot_tier_size(uint32_t tier_size);
+
+    // Проверка контрольных сумм загружаемого индекса (по блокам, при чтении)
+    void set_verify_checksums(bool enabled);
+
     void build_from_documents(const std::vector<Document>& documents);
 
+    // Построение потоком, без вектора всех документов в памяти:
+    // begin_build, add_document для каждого документа, finish_build.
+    // При перенумерации (dedup, order url) тексты не пересжимаются,
+    // а переставляются в хранилище
+    void begin_build(size_t expected_documents = 0);
+    void add_document(const Document& doc);
+    void finish_build();
+
     void save_index(const std::string& filename);
 
     bool load_index(const std::string& filename);
@@ -28,29 +69,111 @@ public:
         double avg_term_length = 0.0;
         double indexing_time_ms = 0.0;
         double avg_doc_length = 0.0;
+        size_t content_raw_bytes = 0;     // Тексты документов без сжатия
+        size_t content_stored_bytes = 0;  // Размер хранилища текстов
+        size_t duplicate_documents = 0;   // Почти-дубликаты (удаленные или свернутые)
+        size_t postings_bytes = 0;        // Сжатые списки документов (после save_index)
+        size_t scratch_peak_bytes = 0;    // Пик арены временных данных документа
     };
 
     Statistics get_statistics() const;
 
     // Доступ к данным индекса
-    const std::vector<ForwardIndexEntry>& get_forward_index() const;
+    const ForwardIndex& get_forward_index() const;
+    // Заполнен только после build_from_documents; загруженный индекс
+    // читается через словарь отображенного файла
     const std::unordered_map<std::string, std::vector<uint32_t>>& get_inverted_index() const;
 
+    // Списки документов для разбора запроса: память из resource
+    // (арена запроса), вложенные списки на том же ресурсе
+    using PostingsList = std::pmr::vector<uint32_t>;
+    using PostingsLists = std::pmr::vector<PostingsList>;
+
+    // Список документов термина (из памяти или из файла индекса)
+    PostingsList get_postings(const std::string& term,
+                              std::pmr::memory_resource* resource) const;
+
+    // Список документов термина с частотами; hot - список верхнего уровня,
+    // если он есть (иначе полный список)
+    WeightedPostings get_weighted_postings(const std::string& term, bool hot) const;
+
+    // Списки документов терминов, подходящих под шаблон с '*' (не более limit)
+    PostingsLists get_matching_postings(const std::string& pattern, size_t limit,
+                                        std::pmr::memory_resource* resource) const;
+
+    // Самые частые термины словаря на расстоянии не больше max_edits
+    // (раскрытие нечеткого термина; по ним же подсвечивается выдача)
+    std::vector<std::string> get_fuzzy_terms(const std::string& term, uint32_t max_edits,
+                                             size_t limit) const;
+
+    bool has_term(const std::string& term) const;
+
+    // Предзагрузка страниц отображенного файла: словарь и списки limit
+    // самых частых терминов (по убыванию doc_freq, пока не наступит
+    // deadline; в файле записано не больше 4096). Для индекса,
+    // построенного в памяти, ничего не делает
+    struct PrefetchStats {
+        size_t terms = 0;
+        uint64_t bytes = 0;
+    };
+
+    PrefetchStats prefetch_frequent_terms(size_t limit,
+                                          std::chrono::steady_clock::time_point deadline) const;
+
+    // Битовые карты полей-фильтров (source, category)
+    const FacetIndex& get_facets() const;
+
+    // Числовая колонка поля (words - количество слов, cluster - номер
+    // кластера почти-дубликатов) или nullptr
+    const NumericColumn* get_numeric_column(const std::string& field) const;
+
+    // Текст документа из хранилища (файл <индекс>.store)
+    bool has_content() const;
+    std::string get_content(uint32_t doc_id) const;
+
     // Стемминг терминов
     std::string normalize_term(const std::string& term);
 
-private:
-    Tokenizer tokenizer;
-    Stemmer stemmer;
+    Analyzer& get_analyzer();
 
-    std::vector<ForwardIndexEntry> forward_index;
+private:
+    Analyzer analyzer;
+    std::vector<std::string> document_terms;  // Буфер терминов документа
+    ScratchArena scratch;                     // Частоты терминов документа
+    std::string term_key;                     // Ключ для поиска в inverted_index
+
+    ForwardIndex forward_index;
+    ContentStore content_store;
+    FacetIndex facets;
+    std::map<std::string, NumericColumn> numeric_columns;
+
+    DedupMode dedup_mode = DedupMode::NONE;
+    DocumentOrder document_order = DocumentOrder::INPUT;
+    uint32_t hot_tier_size = 0;
+    bool verify_checksums = false;
+    NearDuplicateDetector duplicates;
 
     std::unordered_map<std::string, std::vector<uint32_t>> inverted_index;
+    // Частоты терминов в том же порядке, что списки inverted_index
+    std::unordered_map<std::string, std::vector<uint32_t>> posting_frequencies;
+
+    // Отображенный файл загруженного индекса
+    std::unique_ptr<BinaryIndexReader> reader;
 
     Statistics stats;
+    std::chrono::high_resolution_clock::time_point build_start;
 
+    // Завершение построения; documents - исходные документы, если они в памяти
+    void complete_build(const std::vector<Document>* documents);
     void process_document(const Document& doc, uint32_t doc_id);
     void sort_and_unique_postings();
+    // Документы, которые остаются в индексе (для DROP - первые документы кластеров)
+    std::vector<uint32_t> remove_duplicates();
+    void sort_by_url(std::vector<uint32_t>& order) const;
+
+    // Перенумерация: новый документ i - бывший order[i], остальные удаляются
+    void remap_documents(const std::vector<Document>* documents,
+                         const std::vector<uint32_t>& order);
 
     std::vector<std::pair<std::string, std::vector<uint32_t>>> get_sorted_entries() const;
 };
@@ -5,7 +5,17 @@
 #include <vector>
 #include <memory>
 #include <unordered_set>
+#include <map>
+#include <memory_resource>
+#include <chrono>
 #include "boolean_index.hpp"
+#include "analyzer.hpp"
+#include "highlighter.hpp"
+#include "query_plan.hpp"
+#include "bitmap.hpp"
+#include "scratch_arena.hpp"
+#include "query_profile.hpp"
+#include "slow_query_log.hpp"
 
 class BooleanSearch {
 public:
@@ -22,6 +32,9 @@ public:
     struct QueryToken {
         TokenType type;
         std::string value;
+        // Простой термин: результат анализатора (пусто - стоп-слово)
+        std::vector<std::string> terms;
+        bool analyzed = false;
 
         QueryToken(TokenType t, const std::string& v = "") : type(t), value(v) {}
     };
@@ -31,6 +44,54 @@ public:
     // Выполнение поискового запроса
     std::vector<uint32_t> search(const std::string& query);
 
+    // Почти-дубликаты (индекс построен с DedupMode::COLLAPSE) сворачиваются
+    // до первого найденного документа кластера по всей выдаче (в search_page
+    // тоже: дубликат с прошлой страницы не появляется на следующей).
+    // count и facet_counts считают только показанные документы, exists от
+    // свертки не зависит. По умолчанию включено.
+    void set_collapse_duplicates(bool enabled);
+
+    // Ранжированный поиск: k лучших документов по сумме весов терминов
+    // (1 + ln tf) * ln(1 + N / df). Запросы из простых терминов через AND
+    // или OR считаются сначала по верхнему уровню индекса; полные списки
+    // читаются, только если верхний уровень не гарантирует точный top-k.
+    struct RankedDoc {
+        uint32_t doc_id;
+        double score;
+    };
+
+    std::vector<RankedDoc> search_ranked(const std::string& query, size_t k);
+
+    // Страница результатов: продолжение с курсора предыдущей страницы
+    // (пустой курсор - первая страница). Курсор содержит отпечаток
+    // запроса и последний выданный ID, поэтому следующая страница
+    // продолжает обход итераторов с него, а не пересчитывает выдачу.
+    struct Page {
+        std::vector<uint32_t> doc_ids;
+        std::string next_cursor;  // Пусто, если страниц больше нет
+    };
+
+    Page search_page(const std::string& query, const std::string& cursor, size_t limit);
+
+    // Количество результатов и проверка наличия без построения списка
+    // результатов: подсчет по размерам пересечений, битовым картам
+    // или итераторам, exists останавливается на первом совпадении
+    size_t count(const std::string& query);
+    bool exists(const std::string& query);
+
+    // Количество результатов по значениям полей-фильтров (source, category),
+    // по убыванию; считается пересечением битовых карт
+    struct FacetCount {
+        std::string value;
+        size_t count = 0;
+    };
+
+    std::map<std::string, std::vector<FacetCount>> facet_counts(const std::string& query);
+
+    // Выполнение запроса как в search с профилем плана (EXPLAIN):
+    // по узлам - прочитанные списки, байты, пропуски, размеры и время
+    QueryProfile explain(const std::string& query);
+
     // Пакетный поиск
     std::vector<std::pair<std::string, std::vector<uint32_t>>> batch_search(
         const std::vector<std::string>& queries);
@@ -41,15 +102,39 @@ public:
         size_t result_count = 0;
         double processing_time_ms = 0.0;
         size_t terms_processed = 0;
+        size_t terms_expanded = 0;  // Термины из раскрытых шаблонов
+        bool full_tier_used = false;  // Ранжирование читало полные списки
+        size_t scratch_bytes = 0;     // Временные данные запроса в арене
     };
 
     SearchStats get_last_stats() const;
 
+    // Наибольший объем временных данных одного запроса
+    size_t get_scratch_peak() const;
+
+    // Журнал медленных запросов для search (nullptr - без журнала);
+    // журнал должен жить дольше поиска
+    void set_query_log(SlowQueryLog* log);
+
+    // Максимум терминов при раскрытии шаблона (desig*, *sign*)
+    void set_max_expansions(size_t limit);
+
+    // Исправление опечаток для терминов без результатов
+    void set_fuzzy_fallback(bool enabled);
+
+    // Запись метрик поиска (MetricsRegistry); выключается для служебных
+    // запросов, например повтора журнала при прогреве
+    void set_record_metrics(bool enabled);
+
+    // Анализатор запросов этого поиска (кэш терминов живет между запросами)
+    Analyzer& get_analyzer();
+
     // Форматирование результатов
     struct SearchResult {
         uint32_t doc_id;
         std::string title;
         std::string url;
+        std::string snippet;
         double relevance = 0.0;
     };
 
@@ -57,29 +142,140 @@ public:
                                              size_t offset = 0,
                                              size_t limit = 50) const;
 
+    // Сниппеты с терминами запроса (если у индекса есть хранилище текстов)
+    void add_snippets(std::vector<SearchResult>& results, const std::string& query);
+
 private:
     const BooleanIndexBuilder& index;
     SearchStats last_stats;
 
+    // Анализ терминов запроса тем же конвейером, что и при индексации
+    Analyzer analyzer;
+    Highlighter highlighter;
+
+    // Промежуточные списки и таблицы запроса; сбрасывается в конце
+    // каждого публичного вызова (ScratchArena::Scope)
+    ScratchArena scratch;
+    using ScratchList = std::pmr::vector<uint32_t>;
+
+    // Отсортированный список ID без владения: список листа плана или
+    // результат в арене
+    struct ListView {
+        const uint32_t* ids = nullptr;
+        size_t count = 0;
+
+        ListView() = default;
+        template<typename List>
+        ListView(const List& list) : ids(list.data()), count(list.size()) {}
+
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        uint32_t operator[](size_t i) const { return ids[i]; }
+        const uint32_t* begin() const { return ids; }
+        const uint32_t* end() const { return ids + count; }
+    };
+
     // Парсинг запроса
     std::vector<QueryToken> tokenize_query(const std::string& query);
-    std::vector<uint32_t> parse_expression(const std::vector<QueryToken>& tokens,
-                                           size_t& pos);
-    std::vector<uint32_t> parse_term(const std::vector<QueryToken>& tokens,
-                                     size_t& pos);
-    std::vector<uint32_t> parse_factor(const std::vector<QueryToken>& tokens,
-                                       size_t& pos);
-
-    // Операции над множествами
-    std::vector<uint32_t> intersect_sets(const std::vector<uint32_t>& a,
-                                         const std::vector<uint32_t>& b);
-    std::vector<uint32_t> union_sets(const std::vector<uint32_t>& a,
-                                     const std::vector<uint32_t>& b);
-    std::vector<uint32_t> complement_set(const std::vector<uint32_t>& a);
-
-    std::string normalize_term(const std::string& term);
-
-    std::vector<uint32_t> get_postings(const std::string& term);
+    void drop_stop_terms(std::vector<QueryToken>& tokens);
+
+    // Термины запроса для подсветки и весов ранжирования, каждый один раз
+    // (без отрицаний и шаблонов)
+    std::vector<std::string> highlight_terms(const std::string& query);
+    std::vector<std::string> highlight_terms(const std::vector<QueryToken>& tokens);
+    // fingerprint - отпечаток запроса для курсора (query_fingerprint)
+    QueryPlan parse_query(const std::string& query, size_t& token_count,
+                          uint64_t* fingerprint = nullptr);
+    uint64_t query_fingerprint(const std::vector<QueryToken>& tokens) const;
+    QueryPlan parse_expression(const std::vector<QueryToken>& tokens, size_t& pos);
+    QueryPlan parse_term(const std::vector<QueryToken>& tokens, size_t& pos);
+    QueryPlan parse_factor(const std::vector<QueryToken>& tokens, size_t& pos);
+    QueryPlan combine(QueryNode::Type type, QueryPlan left, QueryPlan right);
+
+    // Полный результат по плану (операции над множествами). Список листа
+    // читается на месте, без копии; результаты операций - в storage и
+    // промежуточных списках в арене. profile заполняется только при профилировании
+    ListView evaluate_plan(const QueryNode& node, ScratchList& storage,
+                           QueryProfile::Node* profile = nullptr);
+
+    size_t count_plan(const QueryNode& node);
+    Bitmap evaluate_bitmap(const QueryNode& node);
+    static size_t count_intersection(ListView a, ListView b);
+
+    static std::string encode_cursor(uint64_t fingerprint, uint32_t last_doc);
+    static uint32_t decode_cursor(const std::string& cursor, uint64_t fingerprint);
+    // Страница отсортированного результата с документа start
+    static Page slice_page(const std::vector<uint32_t>& results, uint64_t fingerprint,
+                           uint32_t start, size_t limit);
+
+    // Операции над множествами; результат в арене,
+    // skipped - счетчик элементов, пропущенных без совпадения
+    ScratchList intersect_sets(ListView a, ListView b, size_t* skipped = nullptr);
+    ScratchList union_sets(ListView a, ListView b);
+    ScratchList complement_set(ListView a);
+
+    // Объединение сразу всех списков (битовая карта или слияние через кучу)
+    ScratchList union_many(const BooleanIndexBuilder::PostingsLists& lists);
+
+    std::string normalize_term(const std::string& term) const;
+
+    // Списки листьев плана читаются сразу в арену
+    ScratchList get_postings(const std::string& term);
+    ScratchList get_wildcard_postings(const std::string& pattern);
+    // Объединение списков раскрытых терминов (нечеткий термин, исправление --fuzzy)
+    ScratchList get_expanded_postings(const std::vector<std::string>& terms);
+
+    // Раскрытие нечеткого термина и исправление опечатки в термине без
+    // результатов (--fuzzy). Одни и те же термины идут в план и в подсветку
+    std::vector<std::string> fuzzy_terms(const std::string& term, uint32_t max_edits) const;
+    std::vector<std::string> fallback_terms(const std::string& term) const;
+    static uint32_t fuzzy_edits(const std::string& value, size_t tilde);
+    // Учет прочитанных списков (профиль и метрики)
+    void add_fetched(const BooleanIndexBuilder::PostingsLists& lists);
+
+    // Термин запроса: точный, шаблон (desig*), нечеткий (desgn~1)
+    // или фильтр по полю (source:wikipedia)
+    QueryPlan make_term_node(const QueryToken& token);
+    // make_term_node с замером чтения списков при профилировании
+    QueryPlan fetch_term_node(const QueryToken& token);
+    bool is_filter_term(const std::string& value) const;
+    // Значение числового фильтра: [low TO high] (границы включаются, * - открытая) или число
+    static bool parse_range(const std::string& text, uint32_t& low, uint32_t& high);
+
+    // Top-k только по верхнему уровню; false, если результат не гарантирован
+    bool rank_hot_tier(const std::vector<QueryToken>& tokens, size_t k,
+                       std::vector<RankedDoc>& ranked);
+    // Весы терминов по полным спискам для документов результата
+    std::vector<RankedDoc> rank_results(const std::vector<uint32_t>& doc_ids,
+                                        const std::vector<std::string>& terms, size_t k);
+    double term_weight(uint32_t frequency, uint32_t doc_freq) const;
+
+    // Колонка кластеров, если свертка включена и индекс построен со сверткой
+    const NumericColumn* collapse_column() const;
+    // Оставляет первый документ каждого кластера почти-дубликатов
+    void collapse_clusters(std::vector<uint32_t>& doc_ids) const;
+    // То же для отсортированного результата плана: карта показанных документов
+    Bitmap collapsed_matches(ListView doc_ids, const NumericColumn& clusters) const;
+
+    size_t max_expansions = 256;
+    size_t max_fuzzy_expansions = 5;
+    bool fuzzy_fallback = false;
+    bool collapse_duplicates = true;
+    size_t expanded_terms = 0;
+    bool nested_search = false;  // search внутри search_ranked (задержка пишется один раз)
+    bool record_metrics = true;
+
+    // Профилирование (explain, журнал медленных запросов): счетчики
+    // прочитанных списков и их длины
+    bool profiling = false;
+    size_t fetched_lists = 0;
+    size_t fetched_postings = 0;
+
+    SlowQueryLog* query_log = nullptr;
+    // Профиль запроса в журнал, если он медленный или попал в выборку
+    void log_query(const std::string& query, const QueryNode& plan, QueryProfile& profile,
+                   size_t result_count, std::chrono::nanoseconds parse_time,
+                   std::chrono::nanoseconds eval_time);
 
     std::vector<uint32_t> all_documents;
 
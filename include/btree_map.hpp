@@ -0,0 +1,726 @@
+#ifndef BTREE_MAP_HPP
+#define BTREE_MAP_HPP
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <new>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+/*
+ * Упорядоченный словарь на B+ дереве для отсортированных словарей терминов.
+ *
+ * В отличие от BinarySearchTree (узел на ключ, рекурсия):
+ * - узлы около 1 КиБ, ключи узла лежат подряд, поэтому уровней 4-5 на
+ *   миллион ключей вместо 20-25;
+ * - узлы берутся из арены (блоки по CHUNK_NODES узлов) и освобождаются
+ *   все сразу, без new/delete на ключ;
+ * - поиск в узле идет по массиву 64-битных префиксов ключей (для строк -
+ *   первые 8 байт), строка читается только при равных префиксах;
+ * - строковые ключи хранятся один раз в арене байтов: разделители
+ *   внутренних узлов не копируют строк;
+ * - поиск и вставка итеративные, значения доступны по ссылке на месте;
+ * - листья связаны списком: обход по порядку, диапазоны и префиксы без стека;
+ * - build_sorted строит дерево из отсортированных пар за O(n) с полными узлами.
+ *
+ * Удаление не сливает узлы и не освобождает байты ключа (опустевший лист
+ * остается в списке и пропускается при обходе): словарь в основном
+ * строится и читается.
+ */
+
+// Хранение ключа в узле. Кроме ключа узел держит подряд 64-битные
+// префиксы, сохраняющие порядок: поиск в узле идет по ним, ключи
+// сравниваются только при равных префиксах. Общий случай - префиксов нет
+template<typename K, typename Enable = void>
+struct BTreeKey {
+    using view_type = const K&;
+    using stored_type = K;
+
+    static constexpr bool exact_prefix = false;
+
+    static uint64_t prefix(view_type) { return 0; }
+
+    template<typename Arena>
+    static stored_type store(view_type key, Arena&) { return key; }
+
+    static view_type view(const stored_type& key) { return key; }
+};
+
+// Целые ключи: префикс - сам ключ, сравнения ключей не нужны
+template<typename K>
+struct BTreeKey<K, std::enable_if_t<std::is_integral_v<K> && sizeof(K) <= 8>> {
+    using view_type = K;
+    using stored_type = K;
+
+    static constexpr bool exact_prefix = true;
+
+    static uint64_t prefix(view_type key) {
+        if constexpr (std::is_signed_v<K>) {
+            return static_cast<uint64_t>(static_cast<int64_t>(key)) ^ (uint64_t(1) << 63);
+        } else {
+            return static_cast<uint64_t>(key);
+        }
+    }
+
+    template<typename Arena>
+    static stored_type store(view_type key, Arena&) { return key; }
+
+    static view_type view(const stored_type& key) { return key; }
+};
+
+// Строки: байты ключа один раз в арене, префикс - первые 8 байт (первый
+// символ - старший байт, короткая строка дополнена нулями), его порядок
+// как числа совпадает с порядком строк
+template<>
+struct BTreeKey<std::string> {
+    using view_type = std::string_view;
+
+    struct stored_type {
+        const char* data = nullptr;
+        uint32_t size = 0;
+    };
+
+    static constexpr bool exact_prefix = false;
+
+    static uint64_t prefix(view_type key) {
+        uint64_t prefix = 0;
+        for (size_t i = 0; i < 8; ++i) {
+            prefix = (prefix << 8) | (i < key.size() ? static_cast<unsigned char>(key[i]) : 0);
+        }
+        return prefix;
+    }
+
+    template<typename Arena>
+    static stored_type store(view_type key, Arena& arena) {
+        return {arena.copy(key), static_cast<uint32_t>(key.size())};
+    }
+
+    static view_type view(const stored_type& key) { return {key.data, key.size}; }
+};
+
+template<typename K, typename V>
+class BTreeMap {
+public:
+    using Traits = BTreeKey<K>;
+    using KeyView = typename Traits::view_type;
+
+private:
+    using Stored = typename Traits::stored_type;
+
+    struct Probe {
+        KeyView key;
+        uint64_t prefix;
+    };
+
+public:
+    static constexpr size_t NODE_BYTES = 1024;
+    static constexpr size_t LEAF_CAPACITY =
+        std::max<size_t>(8, NODE_BYTES / (sizeof(uint64_t) + sizeof(Stored) + sizeof(V)));
+    static constexpr size_t INNER_CAPACITY =
+        std::max<size_t>(8, NODE_BYTES / (sizeof(uint64_t) + sizeof(Stored) + sizeof(void*)));
+
+private:
+    struct alignas(64) Leaf {
+        uint32_t count = 0;
+        Leaf* next = nullptr;
+        uint64_t prefixes[LEAF_CAPACITY];
+        Stored keys[LEAF_CAPACITY];
+        V values[LEAF_CAPACITY];
+    };
+
+    // keys[i] - наименьший ключ поддерева children[i + 1]
+    struct alignas(64) Inner {
+        uint32_t count = 0;
+        uint64_t prefixes[INNER_CAPACITY];
+        Stored keys[INNER_CAPACITY];
+        void* children[INNER_CAPACITY + 1];
+    };
+
+    // Арена узлов одного типа: память блоками, освобождение разом
+    template<typename Node>
+    class NodeArena {
+    public:
+        static constexpr size_t CHUNK_NODES = 64;
+
+        NodeArena() = default;
+        NodeArena(const NodeArena&) = delete;
+        NodeArena& operator=(const NodeArena&) = delete;
+        ~NodeArena() { reset(); }
+
+        Node* allocate() {
+            if (chunks.empty() || used == CHUNK_NODES) {
+                chunks.push_back(static_cast<Node*>(
+                    ::operator new(sizeof(Node) * CHUNK_NODES, std::align_val_t(alignof(Node)))));
+                used = 0;
+            }
+            return new (chunks.back() + used++) Node();
+        }
+
+        // Узлы к этому моменту уже разрушены владельцем
+        void reset() {
+            for (Node* chunk : chunks) {
+                ::operator delete(chunk, std::align_val_t(alignof(Node)));
+            }
+            chunks.clear();
+            used = 0;
+        }
+
+        void swap(NodeArena& other) noexcept {
+            chunks.swap(other.chunks);
+            std::swap(used, other.used);
+        }
+
+        size_t bytes() const { return chunks.size() * CHUNK_NODES * sizeof(Node); }
+
+    private:
+        std::vector<Node*> chunks;
+        size_t used = 0;
+    };
+
+    // Арена байтов строковых ключей
+    class ByteArena {
+    public:
+        static constexpr size_t CHUNK_BYTES = 64 * 1024;
+
+        const char* copy(std::string_view bytes) {
+            // Ключ длиннее куска - в отдельном куске; текущий продолжает заполняться
+            if (bytes.size() > CHUNK_BYTES) {
+                chunks.emplace_back(new char[bytes.size()]);
+                total += bytes.size();
+                std::memcpy(chunks.back().get(), bytes.data(), bytes.size());
+                return chunks.back().get();
+            }
+            if (!current || bytes.size() > CHUNK_BYTES - used) {
+                chunks.emplace_back(new char[CHUNK_BYTES]);
+                total += CHUNK_BYTES;
+                current = chunks.back().get();
+                used = 0;
+            }
+            char* target = current + used;
+            if (!bytes.empty()) {
+                std::memcpy(target, bytes.data(), bytes.size());
+            }
+            used += bytes.size();
+            return target;
+        }
+
+        void reset() {
+            chunks.clear();
+            current = nullptr;
+            used = 0;
+            total = 0;
+        }
+
+        void swap(ByteArena& other) noexcept {
+            chunks.swap(other.chunks);
+            std::swap(current, other.current);
+            std::swap(used, other.used);
+            std::swap(total, other.total);
+        }
+
+        size_t bytes() const { return total; }
+
+    private:
+        std::vector<std::unique_ptr<char[]>> chunks;
+        char* current = nullptr;  // Заполняемый кусок (used байт заняты)
+        size_t used = 0;
+        size_t total = 0;
+    };
+
+public:
+    class const_iterator {
+    public:
+        const_iterator() = default;
+
+        KeyView key() const { return Traits::view(leaf->keys[index]); }
+        const V& value() const { return leaf->values[index]; }
+
+        std::pair<KeyView, const V&> operator*() const { return {key(), value()}; }
+
+        const_iterator& operator++() {
+            if (++index >= leaf->count) {
+                leaf = leaf->next;
+                index = 0;
+                skip_empty();
+            }
+            return *this;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return leaf == other.leaf && index == other.index;
+        }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+    private:
+        friend class BTreeMap;
+
+        const Leaf* leaf = nullptr;
+        size_t index = 0;
+
+        const_iterator(const Leaf* leaf, size_t index) : leaf(leaf), index(index) {
+            if (leaf && index >= leaf->count) {
+                this->leaf = leaf->next;
+                this->index = 0;
+            }
+            skip_empty();
+        }
+
+        void skip_empty() {
+            while (leaf && leaf->count == 0) {
+                leaf = leaf->next;
+            }
+        }
+    };
+
+    BTreeMap() = default;
+    ~BTreeMap() { clear(); }
+
+    BTreeMap(const BTreeMap&) = delete;
+    BTreeMap& operator=(const BTreeMap&) = delete;
+
+    // Перемещенное дерево остается пустым и пригодным к работе
+    BTreeMap(BTreeMap&& other) noexcept { swap(other); }
+    BTreeMap& operator=(BTreeMap&& other) noexcept {
+        if (this != &other) {
+            swap(other);
+            other.clear();
+        }
+        return *this;
+    }
+
+    void swap(BTreeMap& other) noexcept {
+        std::swap(root, other.root);
+        std::swap(first_leaf, other.first_leaf);
+        std::swap(levels, other.levels);
+        std::swap(count, other.count);
+        leaves.swap(other.leaves);
+        inners.swap(other.inners);
+        key_bytes.swap(other.key_bytes);
+    }
+
+    // Вставка или замена значения
+    void insert(KeyView key, const V& value) {
+        find_or_insert(key) = value;
+    }
+
+    // Значение ключа; новый ключ получает V()
+    V& operator[](KeyView key) {
+        return find_or_insert(key);
+    }
+
+    V* find(KeyView key) {
+        return const_cast<V*>(static_cast<const BTreeMap*>(this)->find(key));
+    }
+
+    const V* find(KeyView key) const {
+        if (!root) {
+            return nullptr;
+        }
+        Probe probe{key, Traits::prefix(key)};
+        const Leaf* leaf = find_leaf(probe);
+        size_t pos = position<false>(leaf->prefixes, leaf->keys, leaf->count, probe);
+        return matches(leaf, pos, probe) ? &leaf->values[pos] : nullptr;
+    }
+
+    bool get(KeyView key, V& value) const {
+        const V* found = find(key);
+        if (found) {
+            value = *found;
+        }
+        return found != nullptr;
+    }
+
+    bool contains(KeyView key) const { return find(key) != nullptr; }
+
+    bool remove(KeyView key) {
+        if (!root) {
+            return false;
+        }
+        Probe probe{key, Traits::prefix(key)};
+        Leaf* leaf = const_cast<Leaf*>(find_leaf(probe));
+        size_t pos = position<false>(leaf->prefixes, leaf->keys, leaf->count, probe);
+        if (!matches(leaf, pos, probe)) {
+            return false;
+        }
+
+        std::copy(leaf->prefixes + pos + 1, leaf->prefixes + leaf->count, leaf->prefixes + pos);
+        std::move(leaf->keys + pos + 1, leaf->keys + leaf->count, leaf->keys + pos);
+        std::move(leaf->values + pos + 1, leaf->values + leaf->count, leaf->values + pos);
+        leaf->count--;
+        leaf->keys[leaf->count] = Stored();
+        leaf->values[leaf->count] = V();
+        count--;
+        return true;
+    }
+
+    // Строит дерево заново из пар, отсортированных по ключу без повторов
+    void build_sorted(std::vector<std::pair<K, V>>&& items) {
+        for (size_t i = 1; i < items.size(); ++i) {
+            if (!(items[i - 1].first < items[i].first)) {
+                throw std::invalid_argument("BTreeMap::build_sorted: keys are not sorted and unique");
+            }
+        }
+
+        clear();
+        if (items.empty()) {
+            return;
+        }
+
+        // Листья заполняются полностью и связываются по порядку; у каждого
+        // узла уровня запоминается наименьший ключ поддерева
+        std::vector<void*> level;
+        std::vector<std::pair<uint64_t, Stored>> level_keys;
+        Leaf* previous = nullptr;
+
+        for (size_t start = 0; start < items.size(); start += LEAF_CAPACITY) {
+            Leaf* leaf = leaves.allocate();
+            size_t end = std::min(items.size(), start + LEAF_CAPACITY);
+            for (size_t i = start; i < end; ++i) {
+                leaf->prefixes[i - start] = Traits::prefix(items[i].first);
+                leaf->keys[i - start] = Traits::store(items[i].first, key_bytes);
+                leaf->values[i - start] = std::move(items[i].second);
+            }
+            leaf->count = static_cast<uint32_t>(end - start);
+
+            if (previous) {
+                previous->next = leaf;
+            } else {
+                first_leaf = leaf;
+            }
+            previous = leaf;
+
+            level.push_back(leaf);
+            level_keys.emplace_back(leaf->prefixes[0], leaf->keys[0]);
+        }
+
+        // Внутренние уровни снизу вверх
+        while (level.size() > 1) {
+            std::vector<void*> parents;
+            std::vector<std::pair<uint64_t, Stored>> parent_keys;
+
+            for (size_t start = 0, end = 0; start < level.size(); start = end) {
+                end = std::min(level.size(), start + INNER_CAPACITY + 1);
+                // Последний узел уровня не должен остаться с одним ребенком
+                if (level.size() - end == 1) {
+                    end--;
+                }
+
+                Inner* inner = inners.allocate();
+                inner->children[0] = level[start];
+                for (size_t i = start + 1; i < end; ++i) {
+                    inner->prefixes[i - start - 1] = level_keys[i].first;
+                    inner->keys[i - start - 1] = level_keys[i].second;
+                    inner->children[i - start] = level[i];
+                }
+                inner->count = static_cast<uint32_t>(end - start - 1);
+
+                parents.push_back(inner);
+                parent_keys.push_back(level_keys[start]);
+            }
+
+            level.swap(parents);
+            level_keys.swap(parent_keys);
+            levels++;
+        }
+
+        root = level[0];
+        count = items.size();
+    }
+
+    const_iterator begin() const { return const_iterator(first_leaf, 0); }
+    const_iterator end() const { return const_iterator(); }
+
+    // Первый ключ не меньше key
+    const_iterator lower_bound(KeyView key) const {
+        if (!root) {
+            return end();
+        }
+        Probe probe{key, Traits::prefix(key)};
+        const Leaf* leaf = find_leaf(probe);
+        return const_iterator(leaf, position<false>(leaf->prefixes, leaf->keys, leaf->count, probe));
+    }
+
+    // Ключи из [from, to) по порядку: callback(key, value), false - остановиться
+    template<typename Callback>
+    void for_each_in_range(KeyView from, KeyView to, Callback&& callback) const {
+        for (auto it = lower_bound(from); it != end() && it.key() < to; ++it) {
+            if (!callback(it.key(), it.value())) {
+                break;
+            }
+        }
+    }
+
+    // Строковые ключи с префиксом prefix по порядку
+    template<typename Callback>
+    void for_each_with_prefix(std::string_view prefix, Callback&& callback) const {
+        for (auto it = lower_bound(prefix); it != end(); ++it) {
+            std::string_view key = it.key();
+            if (key.substr(0, prefix.size()) != prefix || !callback(it.key(), it.value())) {
+                break;
+            }
+        }
+    }
+
+    std::vector<std::pair<K, V>> get_all_sorted() const {
+        std::vector<std::pair<K, V>> result;
+        result.reserve(count);
+        for (auto it = begin(); it != end(); ++it) {
+            result.emplace_back(K(it.key()), it.value());
+        }
+        return result;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // Память узлов и байтов строковых ключей
+    size_t memory_usage() const { return leaves.bytes() + inners.bytes() + key_bytes.bytes(); }
+
+    void clear() {
+        if (root) {
+            destroy_nodes();
+        }
+        leaves.reset();
+        inners.reset();
+        key_bytes.reset();
+        root = nullptr;
+        first_leaf = nullptr;
+        levels = 0;
+        count = 0;
+    }
+
+private:
+    void* root = nullptr;
+    Leaf* first_leaf = nullptr;
+    size_t levels = 0;  // Внутренних уровней над листьями
+    size_t count = 0;
+
+    NodeArena<Leaf> leaves;
+    NodeArena<Inner> inners;
+    ByteArena key_bytes;
+
+    // Двоичный поиск без ветвлений: переходы по сравнениям префиксов
+    // непредсказуемы, а условная пересылка их не требует
+    static size_t prefix_lower_bound(const uint64_t* prefixes, size_t size, uint64_t prefix) {
+        if (size == 0) {
+            return 0;
+        }
+        const uint64_t* base = prefixes;
+        while (size > 1) {
+            size_t half = size / 2;
+            base = base[half - 1] < prefix ? base + half : base;
+            size -= half;
+        }
+        return (base - prefixes) + (*base < prefix);
+    }
+
+    // Первая позиция узла с ключом >= probe (Upper = false) или > probe
+    // (Upper = true). Двоичный поиск по префиксам читает одну-две линии
+    // кэша; ключи сравниваются только в отрезке равных префиксов
+    template<bool Upper>
+    static size_t position(const uint64_t* prefixes, const Stored* keys, size_t size,
+                           const Probe& probe) {
+        size_t low = prefix_lower_bound(prefixes, size, probe.prefix);
+
+        if constexpr (Traits::exact_prefix) {
+            return Upper && low < size && prefixes[low] == probe.prefix ? low + 1 : low;
+        } else {
+            size_t high = low;
+            while (high < size && prefixes[high] == probe.prefix) {
+                high++;
+            }
+            if (Upper) {
+                return std::upper_bound(keys + low, keys + high, probe.key,
+                                        [](KeyView key, const Stored& node_key) {
+                                            return key < Traits::view(node_key);
+                                        }) -
+                       keys;
+            }
+            return std::lower_bound(keys + low, keys + high, probe.key,
+                                    [](const Stored& node_key, KeyView key) {
+                                        return Traits::view(node_key) < key;
+                                    }) -
+                   keys;
+        }
+    }
+
+    static bool matches(const Leaf* leaf, size_t pos, const Probe& probe) {
+        if (pos >= leaf->count || leaf->prefixes[pos] != probe.prefix) {
+            return false;
+        }
+        return Traits::exact_prefix || !(probe.key < Traits::view(leaf->keys[pos]));
+    }
+
+    const Leaf* find_leaf(const Probe& probe) const {
+        const void* node = root;
+        for (size_t level = 0; level < levels; ++level) {
+            const Inner* inner = static_cast<const Inner*>(node);
+            node = inner->children[position<true>(inner->prefixes, inner->keys, inner->count, probe)];
+        }
+        return static_cast<const Leaf*>(node);
+    }
+
+    V& find_or_insert(KeyView key) {
+        if (!root) {
+            first_leaf = leaves.allocate();
+            root = first_leaf;
+        }
+
+        // Путь от корня: узел и номер ребенка на каждом уровне
+        Inner* path[64];
+        size_t path_index[64];
+
+        Probe probe{key, Traits::prefix(key)};
+        void* node = root;
+        for (size_t level = 0; level < levels; ++level) {
+            Inner* inner = static_cast<Inner*>(node);
+            path[level] = inner;
+            path_index[level] = position<true>(inner->prefixes, inner->keys, inner->count, probe);
+            node = inner->children[path_index[level]];
+        }
+
+        Leaf* leaf = static_cast<Leaf*>(node);
+        size_t pos = position<false>(leaf->prefixes, leaf->keys, leaf->count, probe);
+        if (matches(leaf, pos, probe)) {
+            return leaf->values[pos];
+        }
+
+        count++;
+        Stored stored = Traits::store(key, key_bytes);
+
+        if (leaf->count < LEAF_CAPACITY) {
+            return insert_into_leaf(leaf, pos, probe.prefix, std::move(stored));
+        }
+
+        // Разделение листа пополам, ключ уходит в свою половину
+        Leaf* right = leaves.allocate();
+        size_t half = LEAF_CAPACITY / 2;
+        std::copy(leaf->prefixes + half, leaf->prefixes + LEAF_CAPACITY, right->prefixes);
+        std::move(leaf->keys + half, leaf->keys + LEAF_CAPACITY, right->keys);
+        std::move(leaf->values + half, leaf->values + LEAF_CAPACITY, right->values);
+        right->count = static_cast<uint32_t>(LEAF_CAPACITY - half);
+        leaf->count = static_cast<uint32_t>(half);
+        for (size_t i = half; i < LEAF_CAPACITY; ++i) {
+            leaf->keys[i] = Stored();
+            leaf->values[i] = V();
+        }
+        right->next = leaf->next;
+        leaf->next = right;
+
+        V& value = pos <= half ? insert_into_leaf(leaf, pos, probe.prefix, std::move(stored))
+                               : insert_into_leaf(right, pos - half, probe.prefix, std::move(stored));
+
+        insert_into_parent(path, path_index, levels, right->prefixes[0], right->keys[0], right);
+        return value;
+    }
+
+    V& insert_into_leaf(Leaf* leaf, size_t pos, uint64_t prefix, Stored&& key) {
+        std::copy_backward(leaf->prefixes + pos, leaf->prefixes + leaf->count,
+                           leaf->prefixes + leaf->count + 1);
+        std::move_backward(leaf->keys + pos, leaf->keys + leaf->count, leaf->keys + leaf->count + 1);
+        std::move_backward(leaf->values + pos, leaf->values + leaf->count,
+                           leaf->values + leaf->count + 1);
+        leaf->prefixes[pos] = prefix;
+        leaf->keys[pos] = std::move(key);
+        leaf->values[pos] = V();
+        leaf->count++;
+        return leaf->values[pos];
+    }
+
+    // Вставка разделителя и правого узла вверх по пути, с разделением
+    // переполненных внутренних узлов
+    void insert_into_parent(Inner** path, size_t* path_index, size_t depth, uint64_t prefix,
+                            Stored separator, void* right) {
+        while (depth > 0) {
+            Inner* inner = path[depth - 1];
+            size_t pos = path_index[depth - 1];
+
+            if (inner->count < INNER_CAPACITY) {
+                std::copy_backward(inner->prefixes + pos, inner->prefixes + inner->count,
+                                   inner->prefixes + inner->count + 1);
+                std::move_backward(inner->keys + pos, inner->keys + inner->count,
+                                   inner->keys + inner->count + 1);
+                std::move_backward(inner->children + pos + 1, inner->children + inner->count + 1,
+                                   inner->children + inner->count + 2);
+                inner->prefixes[pos] = prefix;
+                inner->keys[pos] = std::move(separator);
+                inner->children[pos + 1] = right;
+                inner->count++;
+                return;
+            }
+
+            // Узел полон: собираем ключи и детей с новым во временных массивах
+            uint64_t prefixes[INNER_CAPACITY + 1];
+            Stored keys[INNER_CAPACITY + 1];
+            void* children[INNER_CAPACITY + 2];
+            std::copy(inner->prefixes, inner->prefixes + pos, prefixes);
+            prefixes[pos] = prefix;
+            std::copy(inner->prefixes + pos, inner->prefixes + INNER_CAPACITY, prefixes + pos + 1);
+            std::move(inner->keys, inner->keys + pos, keys);
+            keys[pos] = std::move(separator);
+            std::move(inner->keys + pos, inner->keys + INNER_CAPACITY, keys + pos + 1);
+            std::copy(inner->children, inner->children + pos + 1, children);
+            children[pos + 1] = right;
+            std::copy(inner->children + pos + 1, inner->children + INNER_CAPACITY + 1,
+                      children + pos + 2);
+
+            // Средний ключ поднимается выше и в узлах не остается
+            size_t middle = (INNER_CAPACITY + 1) / 2;
+            Inner* sibling = inners.allocate();
+
+            std::copy(prefixes, prefixes + middle, inner->prefixes);
+            std::move(keys, keys + middle, inner->keys);
+            std::copy(children, children + middle + 1, inner->children);
+            inner->count = static_cast<uint32_t>(middle);
+            for (size_t i = middle; i < INNER_CAPACITY; ++i) {
+                inner->keys[i] = Stored();
+            }
+
+            std::copy(prefixes + middle + 1, prefixes + INNER_CAPACITY + 1, sibling->prefixes);
+            std::move(keys + middle + 1, keys + INNER_CAPACITY + 1, sibling->keys);
+            std::copy(children + middle + 1, children + INNER_CAPACITY + 2, sibling->children);
+            sibling->count = static_cast<uint32_t>(INNER_CAPACITY - middle);
+
+            prefix = prefixes[middle];
+            separator = std::move(keys[middle]);
+            right = sibling;
+            depth--;
+        }
+
+        // Разделился корень: дерево растет на уровень
+        Inner* new_root = inners.allocate();
+        new_root->prefixes[0] = prefix;
+        new_root->keys[0] = std::move(separator);
+        new_root->children[0] = root;
+        new_root->children[1] = right;
+        new_root->count = 1;
+        root = new_root;
+        levels++;
+    }
+
+    // Деструкторы узлов (ключи и значения могут владеть памятью)
+    void destroy_nodes() {
+        std::vector<void*> level{root};
+        for (size_t depth = 0; depth < levels; ++depth) {
+            std::vector<void*> children;
+            for (void* node : level) {
+                Inner* inner = static_cast<Inner*>(node);
+                children.insert(children.end(), inner->children, inner->children + inner->count + 1);
+                inner->~Inner();
+            }
+            level.swap(children);
+        }
+        for (void* node : level) {
+            static_cast<Leaf*>(node)->~Leaf();
+        }
+    }
+};
+
+#endif
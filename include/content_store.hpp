@@ -0,0 +1,103 @@
+#ifndef CONTENT_STORE_HPP
+#define CONTENT_STORE_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+/*
+ * Хранилище текстов документов (отдельный файл <индекс>.store).
+ *
+ * Тексты соседних документов собираются в блоки примерно по block_size
+ * байт, каждый блок сжимается (lz_codec) или хранится как есть, если
+ * сжатие не помогло. Для получения текста документа распаковывается
+ * ровно один блок.
+ *
+ * Формат файла:
+ *   [magic: 4 байта] = "FSTR"
+ *   [version: 2 байта] = 2
+ *   [flags: 2 байта] = 0
+ *   [doc_count: 4 байта]
+ *   [block_count: 4 байта]
+ *   [block_table_offset: 8 байт]
+ *   [doc_table_offset: 8 байт]
+ *   [store_id: 8 байт] - случайный идентификатор записи; индекс хранит
+ *                        его в заголовке и не принимает чужое хранилище
+ *   Блоки: [codec: 1 байт][raw_size: 4 байта][stored_size: 4 байта][данные]
+ *   Таблица блоков (выровнена на 8): block_count * [offset: 8 байт]
+ *   Таблица документов: doc_count * [block: 4 байта][offset: 4 байта][length: 4 байта]
+ *
+ * Положение документа хранится отдельно от порядка блоков, поэтому
+ * при перенумерации документов блоки не пересжимаются.
+ */
+class ContentStore {
+public:
+    explicit ContentStore(uint32_t block_size = 16384);
+    ~ContentStore();
+
+    ContentStore(const ContentStore&) = delete;
+    ContentStore& operator=(const ContentStore&) = delete;
+
+    void clear();
+
+    // Добавляет текст следующего документа (только при построении)
+    void add(std::string_view content);
+
+    // Новый документ i - бывший order[i], остальные удаляются; блоки
+    // не пересжимаются, тексты удаленных документов остаются в них
+    void reorder(const std::vector<uint32_t>& order);
+
+    // Записывает файл с новым идентификатором (get_store_id)
+    void save(const std::string& filename);
+
+    // Отображает файл хранилища в память; false, если файла нет
+    bool open(const std::string& filename);
+
+    size_t size() const { return doc_count; }
+    bool empty() const { return doc_count == 0; }
+
+    // Текст документа (распаковывает один блок)
+    std::string get(uint32_t doc_id) const;
+
+    uint64_t get_store_id() const { return store_id; }
+    uint64_t get_raw_size() const { return raw_bytes; }
+    uint64_t get_stored_size() const { return stored_bytes; }
+
+private:
+    struct DocLocation {
+        uint32_t block;
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    uint32_t block_size;
+
+    // Данные при построении
+    std::string own_blocks;
+    std::vector<uint64_t> own_block_offsets;
+    std::vector<DocLocation> own_locations;
+    std::string pending;  // Несжатый текущий блок
+
+    // Текущие данные: собственные или в отображенном файле
+    const uint8_t* blocks_data = nullptr;
+    uint64_t blocks_size = 0;
+    const uint64_t* block_offsets = nullptr;
+    const DocLocation* locations = nullptr;
+    uint32_t block_count = 0;
+    uint32_t doc_count = 0;
+    uint64_t store_id = 0;
+
+    uint64_t raw_bytes = 0;
+    uint64_t stored_bytes = 0;
+
+    // Отображенный файл
+    const uint8_t* mapped = nullptr;
+    size_t mapped_size = 0;
+
+    void flush_block();
+    void attach_own();
+    void unmap();
+};
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef CORPUS_GENERATOR_HPP
+#define CORPUS_GENERATOR_HPP
+
+#include <string>
+#include <vector>
+#include <random>
+#include <cstdint>
+#include "document.hpp"
+
+/*
+ * Синтетический корпус и журнал запросов для проверки на больших объемах
+ * без сети и без исходных данных.
+ *
+ * Слово ранга r выбирается с вероятностью ~ 1 / (r + B)^alpha (закон
+ * Ципфа-Мандельброта), длина документа в словах - логнормальная. Параметры
+ * можно подобрать по настоящим документам (fit), тогда частоты терминов
+ * и длины документов синтетического корпуса близки к исходным. Слова
+ * составлены из случайных букв и английских суффиксов, поэтому стеммер
+ * и токенизатор работают как на обычном тексте.
+ *
+ * Выдача детерминирована: одинаковые модель и seed дают один и тот же
+ * корпус. Документы генерируются по одному, поэтому корпус любого размера
+ * можно писать на диск или передавать в построитель индекса потоком.
+ */
+struct CorpusModel {
+    size_t vocabulary_size = 100000;
+    double zipf_alpha = 1.0;   // Показатель степени
+    double zipf_shift = 2.7;   // Сдвиг ранга B
+    double length_mu = 4.7;    // Среднее логарифма длины (медиана ~110 слов)
+    double length_sigma = 0.6;
+    size_t min_length = 5;
+    size_t max_length = 5000;
+
+    // Параметры по образцу документов (ZipfAnalyzer + fit_mandelbrot)
+    static CorpusModel fit(const std::vector<Document>& sample);
+};
+
+// Доли видов запросов в журнале (веса, не обязательно в сумме 100),
+// операторы в синтаксисе BooleanSearch
+struct QueryMix {
+    unsigned term = 35;      // Один термин
+    unsigned and_terms = 30; // a && b [&& c]
+    unsigned or_terms = 15;  // a || b [|| c]
+    unsigned not_terms = 15; // a !b
+    unsigned wildcard = 5;   // abc*
+
+    // Разбор строки "term=35,and=30,or=15,not=15,wildcard=5"
+    static QueryMix parse(const std::string& text);
+};
+
+class CorpusGenerator {
+public:
+    CorpusGenerator(const CorpusModel& model, uint64_t seed);
+
+    // Следующий документ; строки doc переиспользуются
+    void next_document(Document& doc);
+
+    // Следующий запрос журнала
+    std::string next_query(const QueryMix& mix);
+
+    // Слово ранга rank (0 - самое частое) и случайное слово по частотам
+    const std::string& word_at(size_t rank) const { return vocabulary[rank % vocabulary.size()]; }
+    const std::string& next_word();
+
+    const CorpusModel& get_model() const { return model; }
+    size_t get_document_count() const { return documents_generated; }
+
+private:
+    CorpusModel model;
+    std::mt19937_64 random;
+    std::vector<std::string> vocabulary;
+
+    // Выбор ранга за O(1): таблица псевдонимов (метод Уолкера)
+    std::vector<double> alias_probability;
+    std::vector<uint32_t> alias;
+
+    std::lognormal_distribution<double> length_distribution;
+    size_t documents_generated = 0;
+
+    void build_vocabulary();
+    void build_alias_table();
+    size_t next_rank();
+    void append_text(std::string& text, size_t words);
+};
+
+#endif
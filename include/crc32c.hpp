@@ -0,0 +1,16 @@
+#ifndef CRC32C_HPP
+#define CRC32C_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * CRC32C (полином Кастаньоли) для контрольных сумм файла индекса.
+ *
+ * На x86 с SSE4.2 считается инструкцией crc32 по 8 байт за шаг
+ * (выбор при первом вызове), иначе - по таблице.
+ * crc - значение для предыдущих данных, чтобы считать сумму частями.
+ */
+uint32_t crc32c(const void* data, size_t size, uint32_t crc = 0);
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef DOC_ITERATOR_HPP
+#define DOC_ITERATOR_HPP
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "query_plan.hpp"
+
+/*
+ * Итераторы по возрастающим ID документов. Дерево итераторов строится
+ * по плану запроса и вычисляет результат лениво: чтобы получить страницу,
+ * достаточно advance(last + 1) и limit вызовов next().
+ */
+class DocIterator {
+public:
+    static const uint32_t END = UINT32_MAX;
+
+    virtual ~DocIterator() = default;
+
+    // Текущий документ (END, если закончились)
+    uint32_t doc() const { return current; }
+
+    // Следующий документ
+    virtual uint32_t next() = 0;
+
+    // Первый документ >= target (не двигается назад)
+    virtual uint32_t advance(uint32_t target) = 0;
+
+    // Оценка числа документов (для порядка обхода в AND)
+    virtual size_t cost() const = 0;
+
+protected:
+    uint32_t current = END;  // До первого next()/advance() - END
+    bool started = false;
+};
+
+// Список документов термина; advance - экспоненциальный поиск
+class PostingsIterator : public DocIterator {
+public:
+    explicit PostingsIterator(const std::pmr::vector<uint32_t>& postings);
+
+    uint32_t next() override;
+    uint32_t advance(uint32_t target) override;
+    size_t cost() const override { return postings.size(); }
+
+private:
+    const std::pmr::vector<uint32_t>& postings;  // Список листа плана
+    size_t position = 0;
+};
+
+// Документы битовой карты
+class BitmapIterator : public DocIterator {
+public:
+    explicit BitmapIterator(const Bitmap& bitmap);
+
+    uint32_t next() override;
+    uint32_t advance(uint32_t target) override;
+    size_t cost() const override { return bit_count; }
+
+private:
+    const Bitmap& bitmap;
+    size_t bit_count;
+
+    uint32_t find_from(uint64_t position) const;
+};
+
+// Пересечение; отрицания (NOT) проверяются только на кандидатах
+class AndIterator : public DocIterator {
+public:
+    AndIterator(std::vector<std::unique_ptr<DocIterator>> required,
+                std::vector<std::unique_ptr<DocIterator>> excluded);
+
+    uint32_t next() override;
+    uint32_t advance(uint32_t target) override;
+    size_t cost() const override;
+
+private:
+    std::vector<std::unique_ptr<DocIterator>> required;
+    std::vector<std::unique_ptr<DocIterator>> excluded;
+
+    uint32_t align(uint32_t target);
+};
+
+class OrIterator : public DocIterator {
+public:
+    explicit OrIterator(std::vector<std::unique_ptr<DocIterator>> children);
+
+    uint32_t next() override;
+    uint32_t advance(uint32_t target) override;
+    size_t cost() const override;
+
+private:
+    std::vector<std::unique_ptr<DocIterator>> children;
+
+    uint32_t smallest() const;
+};
+
+// Все документы [0, doc_count), кроме документов дочернего итератора
+class NotIterator : public DocIterator {
+public:
+    NotIterator(std::unique_ptr<DocIterator> child, uint32_t doc_count);
+
+    uint32_t next() override;
+    uint32_t advance(uint32_t target) override;
+    size_t cost() const override { return doc_count; }
+
+private:
+    std::unique_ptr<DocIterator> child;
+    uint32_t doc_count;
+
+    uint32_t skip_excluded(uint32_t target);
+};
+
+// Дерево итераторов по плану (план должен жить дольше итераторов)
+std::unique_ptr<DocIterator> make_iterator(const QueryNode& node, uint32_t doc_count);
+
+#endif
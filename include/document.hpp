@@ -10,21 +10,12 @@ struct Document {
     std::string title;
     std::string content;
     std::string source;
+    std::string category;
     int word_count = 0;
     std::vector<std::string> tokens;
     std::vector<std::string> stemmed_tokens;
 };
 
-// Прямой индекс (document -> metadata)
-struct ForwardIndexEntry {
-    std::string id;
-    std::string url;
-    std::string title;
-    uint32_t doc_length;  // Количество терминов
-    uint64_t offset;      // Смещение в файле
-    uint32_t checksum;    // Контрольная сумма
-};
-
 // Обратный индекс (term -> [doc_ids])
 struct InvertedIndexEntry {
     std::string term;
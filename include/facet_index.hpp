@@ -0,0 +1,75 @@
+#ifndef FACET_INDEX_HPP
+#define FACET_INDEX_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <cstdint>
+#include "bitmap.hpp"
+
+/*
+ * Поля-фильтры документов (source, category): для каждого значения
+ * хранятся документы. Фильтр source:wikipedia - готовая карта, а количество
+ * результатов по значениям считается пересечением карт без обращения
+ * к прямому индексу.
+ *
+ * При построении у каждого значения битовая карта. В файле редкое значение
+ * (меньше doc_count / 32 документов, список ID короче карты) хранится
+ * отсортированным списком, поэтому поле с множеством значений не стоит
+ * values x N/8 байт. Загруженный индекс не копирует ни карты, ни списки:
+ * Value указывает в отображенный файл.
+ */
+class FacetIndex {
+public:
+    struct Value {
+        std::shared_ptr<Bitmap> bitmap;     // Частое значение (или при построении)
+        const uint32_t* doc_ids = nullptr;  // Редкое значение: ID по возрастанию
+        uint32_t id_count = 0;
+    };
+
+    using ValueMap = std::map<std::string, Value>;
+
+    // Редкое ли значение с count документами (хранится списком)
+    static bool is_sparse(size_t count, uint32_t doc_count) {
+        return count < doc_count / 32;
+    }
+
+    // Поля, которые индексируются
+    static const std::vector<std::string>& field_names();
+
+    // Значение для индекса и запросов: "Harper's Bazaar" -> "harpers_bazaar"
+    static std::string normalize_value(const std::string& raw);
+
+    void reset(uint32_t doc_count);
+
+    // Новое число документов для всех карт (при потоковом построении)
+    void resize(uint32_t doc_count);
+
+    // При построении: пустое значение не индексируется
+    void add(const std::string& field, uint32_t doc_id, const std::string& value);
+
+    // При загрузке: карта значения или список ID (в отображенном файле)
+    void set(const std::string& field, const std::string& value, Bitmap bitmap);
+    void set(const std::string& field, const std::string& value,
+             const uint32_t* doc_ids, uint32_t id_count);
+
+    // Новый документ i - бывший order[i]; опустевшие значения удаляются
+    // (только при построении, у всех значений карты)
+    void reorder(const std::vector<uint32_t>& order);
+
+    bool has_field(const std::string& field) const;
+
+    // Документы значения (nullptr, если значения нет)
+    const Value* find(const std::string& field, const std::string& value) const;
+
+    const ValueMap& values(const std::string& field) const;
+
+    uint32_t get_doc_count() const { return doc_count; }
+
+private:
+    uint32_t doc_count = 0;
+    std::map<std::string, ValueMap> fields;
+};
+
+#endif
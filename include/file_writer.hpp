@@ -0,0 +1,52 @@
+#ifndef FILE_WRITER_HPP
+#define FILE_WRITER_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * Запись файла с атомарной публикацией.
+ *
+ * Данные копятся в буфере и пишутся во временный файл <имя>.tmp
+ * большими блоками. commit() сбрасывает файл на диск (fsync), переименовывает
+ * его в целевой и сбрасывает каталог, поэтому после сбоя на месте файла
+ * остается либо старая, либо новая полная версия. Без commit() временный
+ * файл удаляется в деструкторе.
+ */
+class FileWriter {
+public:
+    explicit FileWriter(const std::string& filename, size_t buffer_size = 1 << 20);
+    ~FileWriter();
+
+    FileWriter(const FileWriter&) = delete;
+    FileWriter& operator=(const FileWriter&) = delete;
+
+    void write(const void* data, size_t size);
+
+    // Перезапись уже записанных байт (поля заголовка, таблицы смещений)
+    void patch(uint64_t pos, const void* data, size_t size);
+
+    uint64_t position() const { return flushed + used; }
+
+    // CRC32C блоков по block_size байт диапазона [from, to); читает
+    // записанные данные обратно (обычно из кэша страниц)
+    std::vector<uint32_t> block_checksums(uint64_t from, uint64_t to, uint32_t block_size);
+
+    void commit();
+
+private:
+    std::string filename;
+    std::string temp_filename;
+    int fd = -1;
+
+    std::vector<char> buffer;
+    size_t used = 0;
+    uint64_t flushed = 0;  // Байт уже в файле
+
+    void flush();
+    void write_at(uint64_t pos, const char* data, size_t size);
+};
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef FORWARD_INDEX_HPP
+#define FORWARD_INDEX_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * Прямой индекс в колоночном виде (document -> metadata).
+ *
+ * Строковые поля всех документов лежат подряд в одном буфере, поле field
+ * документа doc занимает [offsets[doc * 3 + field], offsets[doc * 3 + field + 1]).
+ * Длины документов хранятся отдельным массивом.
+ *
+ * Индекс либо владеет колонками (во время построения), либо ссылается
+ * на них в отображенном в память файле - тогда доступ к документу
+ * не требует разбора и копирования.
+ */
+class ForwardIndex {
+public:
+    static const uint32_t FIELD_COUNT = 3;
+
+    enum Field : uint32_t {
+        ID = 0,
+        URL = 1,
+        TITLE = 2
+    };
+
+    ForwardIndex() = default;
+
+    // Копия собственных колонок получает свои данные,
+    // копия представления ссылается на тот же файл
+    ForwardIndex(const ForwardIndex& other);
+    ForwardIndex& operator=(const ForwardIndex& other);
+    ForwardIndex(ForwardIndex&&) = default;
+    ForwardIndex& operator=(ForwardIndex&&) = default;
+
+    void clear();
+    void reserve(size_t doc_count, size_t string_bytes = 0);
+
+    // Новый документ i - бывший order[i]; документы не из order удаляются
+    void reorder(const std::vector<uint32_t>& order);
+
+    // Добавление документа (только для собственных колонок)
+    void add(std::string_view id, std::string_view url, std::string_view title,
+             uint32_t doc_length);
+
+    // Представление колонок, лежащих в отображенном файле
+    static ForwardIndex view(uint32_t doc_count, const uint32_t* offsets,
+                             const uint32_t* doc_lengths, const char* strings,
+                             uint64_t strings_size);
+
+    size_t size() const { return doc_count; }
+    bool empty() const { return doc_count == 0; }
+
+    std::string_view get_field(uint32_t doc_id, Field field) const {
+        uint32_t slot = doc_id * FIELD_COUNT + field;
+        return std::string_view(strings_data + offsets_data[slot],
+                                offsets_data[slot + 1] - offsets_data[slot]);
+    }
+
+    std::string_view get_id(uint32_t doc_id) const { return get_field(doc_id, ID); }
+    std::string_view get_url(uint32_t doc_id) const { return get_field(doc_id, URL); }
+    std::string_view get_title(uint32_t doc_id) const { return get_field(doc_id, TITLE); }
+    uint32_t get_doc_length(uint32_t doc_id) const { return doc_lengths_data[doc_id]; }
+
+    // Сырые колонки для записи в файл
+    const uint32_t* offsets() const { return offsets_data; }
+    const uint32_t* doc_lengths() const { return doc_lengths_data; }
+    const char* strings() const { return strings_data; }
+    uint64_t strings_size() const { return strings_bytes; }
+
+private:
+    // Собственные колонки
+    std::vector<uint32_t> own_offsets;
+    std::vector<uint32_t> own_doc_lengths;
+    std::vector<char> own_strings;  // vector, а не string: при перемещении данные не копируются
+
+    // Текущие колонки: собственные или в отображенном файле
+    uint32_t doc_count = 0;
+    const uint32_t* offsets_data = nullptr;
+    const uint32_t* doc_lengths_data = nullptr;
+    const char* strings_data = nullptr;
+    uint64_t strings_bytes = 0;
+
+    bool owned = true;
+
+    void attach_own();
+    void append_string(std::string_view value);
+};
+
+#endif
@@ -3,160 +3,375 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <functional>
-#include <iostream>
+#include <memory>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+ * Хеш-таблица с открытой адресацией для подсчета частот.
+ *
+ * - Емкость - степень двойки, позиция - младшие биты перемешанного хеша.
+ * - Метаданные отдельно от данных: по байту на ячейку (EMPTY или старшие
+ *   7 бит хеша). Поиск сравнивает сразу 16 байт (SSE2) и проверяет ключи
+ *   только у совпавших байт, поэтому к строкам обращается почти всегда
+ *   один раз.
+ * - Линейное пробирование группами по 16 и удаление сдвигом назад: цепочка
+ *   ключа не содержит пустых ячеек, поиск останавливается на первой
+ *   пустой, надгробий нет.
+ * - Рост вдвое с перемещением (move) элементов, без копирования.
+ * - Перемещенная таблица буферов не держит и выделяет их при первой
+ *   вставке, поэтому перемещение не выделяет память и noexcept.
+ * - Для строковых ключей поиск по std::string_view без создания строки;
+ *   operator[] и upsert создают ключ, только если его еще нет.
+ */
+
+template<typename K>
+struct HashTableKey {
+    using view_type = const K&;
+};
+
+template<>
+struct HashTableKey<std::string> {
+    using view_type = std::string_view;
+};
 
 template<typename K, typename V>
 class HashTable {
-private:
-    struct Entry {
-        K key;
-        V value;
-        bool occupied;
-        bool deleted;
-
-        Entry() : occupied(false), deleted(false) {}
-    };
+public:
+    using KeyView = typename HashTableKey<K>::view_type;
 
-    std::vector<Entry> table;
-    size_t size;
-    size_t count;
-    float load_factor_threshold;
+    explicit HashTable(size_t initial_size = 16) {
+        allocate(capacity_for(initial_size));
+    }
 
-    size_t hash(const K& key) const {
-        std::hash<K> hasher;
-        return hasher(key) % table.size();
+    HashTable(const HashTable& other) : HashTable(other.count) {
+        other.for_each([this](const K& key, const V& value) { insert(key, value); });
     }
 
-    size_t probe(size_t index, size_t i) const {
-        // Квадратичное пробирование
-        return (index + i * i) % table.size();
+    HashTable& operator=(const HashTable& other) {
+        if (this != &other) {
+            HashTable copy(other);
+            swap(copy);
+        }
+        return *this;
     }
 
-    void rehash() {
-        std::vector<Entry> old_table = table;
-        table.clear();
-        table.resize(size * 2, Entry());
-        size = table.size();
-        count = 0;
+    // Перемещенная таблица остается пустой и пригодной к работе
+    // (при присваивании - с буфером прежнего содержимого этой таблицы)
+    HashTable(HashTable&& other) noexcept {
+        swap(other);
+    }
 
-        for (const auto& entry : old_table) {
-            if (entry.occupied && !entry.deleted) {
-                insert(entry.key, entry.value);
-            }
+    HashTable& operator=(HashTable&& other) noexcept {
+        if (this != &other) {
+            swap(other);
+            other.clear();
         }
+        return *this;
     }
 
-public:
-    HashTable(size_t initial_size = 101)
-        : table(initial_size), size(initial_size),
-          count(0), load_factor_threshold(0.75f) {}
+    ~HashTable() {
+        release();
+    }
+
+    void swap(HashTable& other) noexcept {
+        std::swap(ctrl, other.ctrl);
+        std::swap(slots, other.slots);
+        std::swap(capacity, other.capacity);
+        std::swap(count, other.count);
+        std::swap(growth_limit, other.growth_limit);
+    }
 
+    // Вставка или замена значения
     void insert(const K& key, const V& value) {
-        if (float(count) / size > load_factor_threshold) {
-            rehash();
+        upsert(key, value, [&value](V& current) { current = value; });
+    }
+
+    // Значение ключа; новый ключ получает V()
+    V& operator[](KeyView key) {
+        return upsert(key, V(), [](V&) {});
+    }
+
+    // Новый ключ получает initial, у существующего вызывается update(value)
+    template<typename Update>
+    V& upsert(KeyView key, const V& initial, Update&& update) {
+        if (capacity == 0) {
+            allocate(MIN_CAPACITY);
+        }
+
+        size_t hash = hash_key(key);
+        size_t index = 0;
+
+        if (find_index(key, hash, index)) {
+            update(slots[index].value);
+            return slots[index].value;
         }
 
-        size_t index = hash(key);
-        size_t i = 0;
+        if (count >= growth_limit) {
+            grow();
+            find_index(key, hash, index);
+        }
 
-        while (i < size) {
-            size_t idx = probe(index, i);
+        new (&slots[index]) Slot{K(key), initial};
+        set_ctrl(index, tag(hash));
+        count++;
+        return slots[index].value;
+    }
 
-            if (!table[idx].occupied || table[idx].deleted) {
-                table[idx].key = key;
-                table[idx].value = value;
-                table[idx].occupied = true;
-                table[idx].deleted = false;
-                count++;
-                return;
-            }
+    V* find(KeyView key) {
+        size_t index = 0;
+        return count > 0 && find_index(key, hash_key(key), index) ? &slots[index].value : nullptr;
+    }
 
-            if (table[idx].key == key) {
-                table[idx].value = value;
-                return;
-            }
+    const V* find(KeyView key) const {
+        size_t index = 0;
+        return count > 0 && find_index(key, hash_key(key), index) ? &slots[index].value : nullptr;
+    }
 
-            i++;
+    bool get(KeyView key, V& value) const {
+        const V* found = find(key);
+        if (found) {
+            value = *found;
         }
+        return found != nullptr;
+    }
 
-        rehash();
-        insert(key, value);
+    bool contains(KeyView key) const {
+        return find(key) != nullptr;
     }
 
-    bool get(const K& key, V& value) const {
-        size_t index = hash(key);
-        size_t i = 0;
+    bool remove(KeyView key) {
+        size_t hole = 0;
+        if (count == 0 || !find_index(key, hash_key(key), hole)) {
+            return false;
+        }
 
-        while (i < size) {
-            size_t idx = probe(index, i);
+        slots[hole].~Slot();
+        count--;
+
+        // Сдвиг назад: следующий элемент цепочки занимает дыру, если его
+        // начальная позиция не лежит между дырой и ним самим
+        size_t mask = capacity - 1;
+        for (size_t j = (hole + 1) & mask; ctrl[j] != EMPTY; j = (j + 1) & mask) {
+            size_t home = hash_key(slots[j].key) & mask;
+            if (((j - home) & mask) >= ((j - hole) & mask)) {
+                new (&slots[hole]) Slot(std::move(slots[j]));
+                slots[j].~Slot();
+                set_ctrl(hole, ctrl[j]);
+                hole = j;
+            }
+        }
 
-            if (!table[idx].occupied) {
-                return false;
+        set_ctrl(hole, EMPTY);
+        return true;
+    }
+
+    // Готовит место под size элементов без роста
+    void reserve(size_t size) {
+        size_t needed = capacity_for(size);
+        if (needed > capacity) {
+            rehash(needed);
+        }
+    }
+
+    size_t get_count() const { return count; }
+    size_t get_size() const { return capacity; }
+
+    // Обход в порядке ячеек: callback(key, value)
+    template<typename Callback>
+    void for_each(Callback&& callback) const {
+        for (size_t i = 0; i < capacity; ++i) {
+            if (ctrl[i] != EMPTY) {
+                callback(slots[i].key, slots[i].value);
             }
+        }
+    }
 
-            if (table[idx].occupied && !table[idx].deleted && table[idx].key == key) {
-                value = table[idx].value;
-                return true;
+    std::vector<std::pair<K, V>> get_all() const {
+        std::vector<std::pair<K, V>> result;
+        result.reserve(count);
+        for_each([&result](const K& key, const V& value) { result.emplace_back(key, value); });
+        return result;
+    }
+
+    void clear() {
+        if (!ctrl) {
+            return;
+        }
+        for (size_t i = 0; i < capacity; ++i) {
+            if (ctrl[i] != EMPTY) {
+                slots[i].~Slot();
             }
+        }
+        std::memset(ctrl, EMPTY, capacity + GROUP_SIZE);
+        count = 0;
+    }
 
-            i++;
+private:
+    struct Slot {
+        K key;
+        V value;
+    };
+
+    static constexpr size_t GROUP_SIZE = 16;
+    static constexpr size_t MIN_CAPACITY = 16;
+    static constexpr int8_t EMPTY = -128;
+
+    // Байты ячеек; последние GROUP_SIZE повторяют первые, чтобы группа
+    // у конца таблицы читалась одной загрузкой
+    int8_t* ctrl = nullptr;
+    Slot* slots = nullptr;
+    size_t capacity = 0;
+    size_t count = 0;
+    size_t growth_limit = 0;
+
+    // Маски совпадений в группе из 16 байт: бит i - байт i
+    static uint32_t match_byte(const int8_t* group, int8_t value) {
+#if defined(__SSE2__)
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(value))));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < GROUP_SIZE; ++i) {
+            mask |= uint32_t(group[i] == value) << i;
         }
+        return mask;
+#endif
+    }
 
-        return false;
+    static size_t mix(size_t hash) {
+        // std::hash для целых - тождественная функция: перемешиваем все биты
+        uint64_t h = hash;
+        h ^= h >> 32;
+        h *= 0x9E3779B97F4A7C15ULL;
+        h ^= h >> 29;
+        return static_cast<size_t>(h);
     }
 
-    bool contains(const K& key) const {
-        V dummy;
-        return get(key, dummy);
+    static size_t hash_key(KeyView key) {
+        using HashType = std::remove_cv_t<std::remove_reference_t<KeyView>>;
+        return mix(std::hash<HashType>()(key));
     }
 
-    bool remove(const K& key) {
-        size_t index = hash(key);
-        size_t i = 0;
+    // Старшие 7 бит хеша; EMPTY (старший бит 1) с ними не совпадает
+    static int8_t tag(size_t hash) {
+        return static_cast<int8_t>(hash >> (sizeof(size_t) * 8 - 7));
+    }
 
-        while (i < size) {
-            size_t idx = probe(index, i);
+    static size_t capacity_for(size_t size) {
+        size_t capacity = MIN_CAPACITY;
+        while (capacity - capacity / 4 < size + 1) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
 
-            if (!table[idx].occupied) {
-                return false;
+    void set_ctrl(size_t index, int8_t value) {
+        ctrl[index] = value;
+        if (index < GROUP_SIZE) {
+            ctrl[capacity + index] = value;
+        }
+    }
+
+    // true - ключ найден в index; false - index указывает на пустую
+    // ячейку, куда ключ будет вставлен
+    bool find_index(KeyView key, size_t hash, size_t& index) const {
+        size_t mask = capacity - 1;
+        size_t pos = hash & mask;
+        int8_t key_tag = tag(hash);
+
+        while (true) {
+            uint32_t empty = match_byte(ctrl + pos, EMPTY);
+            uint32_t matches = match_byte(ctrl + pos, key_tag);
+
+            // Цепочка ключа заканчивается на первой пустой ячейке
+            if (empty) {
+                matches &= (empty & (0u - empty)) - 1;
+            }
+
+            while (matches) {
+                size_t i = (pos + __builtin_ctz(matches)) & mask;
+                if (slots[i].key == key) {
+                    index = i;
+                    return true;
+                }
+                matches &= matches - 1;
             }
 
-            if (table[idx].occupied && !table[idx].deleted && table[idx].key == key) {
-                table[idx].deleted = true;
-                count--;
-                return true;
+            if (empty) {
+                index = (pos + __builtin_ctz(empty)) & mask;
+                return false;
             }
 
-            i++;
+            pos = (pos + GROUP_SIZE) & mask;
         }
+    }
 
-        return false;
+    void allocate(size_t new_capacity) {
+        capacity = new_capacity;
+        ctrl = new int8_t[capacity + GROUP_SIZE];
+        std::memset(ctrl, EMPTY, capacity + GROUP_SIZE);
+        slots = std::allocator<Slot>().allocate(capacity);
+        count = 0;
+        growth_limit = capacity - capacity / 4;
     }
 
-    size_t get_count() const { return count; }
-    size_t get_size() const { return size; }
+    void release() {
+        if (!ctrl) {
+            return;
+        }
+        clear();
+        std::allocator<Slot>().deallocate(slots, capacity);
+        delete[] ctrl;
+        ctrl = nullptr;
+        slots = nullptr;
+        capacity = 0;
+    }
 
-    std::vector<std::pair<K, V>> get_all() const {
-        std::vector<std::pair<K, V>> result;
-        result.reserve(count);
+    void grow() {
+        rehash(capacity * 2);
+    }
+
+    void rehash(size_t new_capacity) {
+        int8_t* old_ctrl = ctrl;
+        Slot* old_slots = slots;
+        size_t old_capacity = capacity;
 
-        for (const auto& entry : table) {
-            if (entry.occupied && !entry.deleted) {
-                result.emplace_back(entry.key, entry.value);
+        allocate(new_capacity);
+
+        // Ключи уникальны: сравнения не нужны, только первая пустая ячейка
+        size_t mask = capacity - 1;
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (old_ctrl[i] == EMPTY) {
+                continue;
             }
-        }
 
-        return result;
-    }
+            size_t hash = hash_key(old_slots[i].key);
+            size_t pos = hash & mask;
+            uint32_t empty;
+            while (!(empty = match_byte(ctrl + pos, EMPTY))) {
+                pos = (pos + GROUP_SIZE) & mask;
+            }
+            size_t index = (pos + __builtin_ctz(empty)) & mask;
 
-    void clear() {
-        for (auto& entry : table) {
-            entry.occupied = false;
-            entry.deleted = false;
+            new (&slots[index]) Slot(std::move(old_slots[i]));
+            old_slots[i].~Slot();
+            set_ctrl(index, tag(hash));
+            count++;
         }
-        count = 0;
+
+        std::allocator<Slot>().deallocate(old_slots, old_capacity);
+        delete[] old_ctrl;
     }
 };
 
-#endif
\ No newline at end of file
+#endif
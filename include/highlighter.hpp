@@ -0,0 +1,40 @@
+#ifndef HIGHLIGHTER_HPP
+#define HIGHLIGHTER_HPP
+
+#include <string>
+#include <vector>
+#include "analyzer.hpp"
+
+/*
+ * Построение сниппетов: выбирает в тексте окно с наибольшим числом
+ * разных терминов запроса и выделяет найденные слова маркерами.
+ * Слова текста сравниваются с терминами после того же анализатора,
+ * что и при индексации (со стеммингом).
+ */
+class Highlighter {
+public:
+    explicit Highlighter(Analyzer& analyzer);
+
+    void set_max_length(size_t length);
+    void set_markers(const std::string& before, const std::string& after);
+
+    std::string snippet(const std::string& content,
+                        const std::vector<std::string>& terms);
+
+private:
+    struct Match {
+        size_t begin;
+        size_t end;
+        size_t term;
+    };
+
+    Analyzer& analyzer;
+    size_t max_length = 200;
+    std::string marker_before = "[";
+    std::string marker_after = "]";
+
+    std::vector<Match> find_matches(const std::string& content,
+                                    const std::vector<std::string>& terms);
+};
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef INDEX_HANDLE_HPP
+#define INDEX_HANDLE_HPP
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+#include "boolean_index.hpp"
+#include "boolean_search.hpp"
+#include "index_warmup.hpp"
+
+/*
+ * Индекс, который заменяется без остановки поиска.
+ *
+ * Загруженная версия - неизменяемый снимок под shared_ptr. reload() загружает
+ * новую версию рядом со старой и публикует ее: запросы, начатые на старом
+ * снимке, дорабатывают на нем, а отображение старого файла освобождается
+ * вместе с последней ссылкой. Фоновый поток (start_watching) следит за файлом
+ * индекса; индекс публикуется переименованием (FileWriter), поэтому новая
+ * версия - это новый inode, и недописанный файл никогда не загружается.
+ *
+ * Путь запроса не берет блокировок: SearchSession сравнивает номер поколения
+ * (атомарное чтение) и берет новый снимок под мьютексом только после замены.
+ */
+class IndexHandle {
+public:
+    struct Snapshot {
+        BooleanIndexBuilder index;
+        uint64_t generation = 0;
+        bool warmed_up = false;     // Прогрев прошел до публикации
+        IndexWarmup::Report warmup;  // Его итог (печатает вызывающий код)
+    };
+
+    explicit IndexHandle(const std::string& filename, bool verify_checksums = false);
+    ~IndexHandle();
+
+    IndexHandle(const IndexHandle&) = delete;
+    IndexHandle& operator=(const IndexHandle&) = delete;
+
+    // Прогрев каждой загруженной версии до ее публикации (IndexWarmup):
+    // первые запросы к новому снимку не ждут диск. Итог прогрева
+    // сохраняется в снимке, reload ничего не печатает
+    void set_warmup(const IndexWarmup::Options& options);
+
+    // Загружает файл и публикует новый снимок; при ошибке остается прежний
+    bool reload();
+
+    // Текущий снимок (nullptr до первой успешной загрузки)
+    std::shared_ptr<const Snapshot> snapshot() const;
+
+    uint64_t generation() const { return current_generation.load(std::memory_order_acquire); }
+
+    // Проверка файла индекса раз в interval в фоновом потоке
+    void start_watching(std::chrono::milliseconds interval);
+    void stop_watching();
+
+private:
+    struct FileVersion {
+        uint64_t device = 0;
+        uint64_t inode = 0;
+        uint64_t size = 0;
+        int64_t mtime_ns = 0;
+
+        bool operator==(const FileVersion& other) const {
+            return device == other.device && inode == other.inode &&
+                   size == other.size && mtime_ns == other.mtime_ns;
+        }
+    };
+
+    static bool stat_file(const std::string& filename, FileVersion& version);
+
+    std::string filename;
+    bool verify_checksums;
+    bool warmup_enabled = false;
+    IndexWarmup::Options warmup;
+
+    mutable std::mutex snapshot_mutex;  // Только для обмена указателя
+    std::shared_ptr<const Snapshot> current;
+    std::atomic<uint64_t> current_generation{0};
+
+    std::mutex reload_mutex;  // reload из CLI и из потока наблюдения
+    FileVersion loaded_version;
+    FileVersion failed_version;  // Не загружаем повторно тот же испорченный файл
+
+    std::thread watcher;
+    std::mutex watch_mutex;
+    std::condition_variable watch_signal;
+    bool stopping = false;
+
+    void watch_loop(std::chrono::milliseconds interval);
+};
+
+/*
+ * Поиск одного потока по последней опубликованной версии индекса.
+ * Снимок и BooleanSearch пересоздаются в refresh() между запросами,
+ * configure применяет к новому поиску те же настройки.
+ */
+class SearchSession {
+public:
+    using Configure = std::function<void(BooleanSearch&)>;
+
+    explicit SearchSession(const IndexHandle& handle, Configure configure = {});
+
+    // Переходит на последний снимок, если он сменился; true - сменился
+    bool refresh();
+
+    BooleanSearch& searcher() { return *search; }
+    const BooleanIndexBuilder& index() const { return snapshot->index; }
+    uint64_t generation() const { return snapshot->generation; }
+    // Итог прогрева текущего снимка (nullptr, если прогрева не было)
+    const IndexWarmup::Report* warmup() const {
+        return snapshot->warmed_up ? &snapshot->warmup : nullptr;
+    }
+
+private:
+    const IndexHandle& handle;
+    Configure configure;
+    std::shared_ptr<const IndexHandle::Snapshot> snapshot;
+    std::unique_ptr<BooleanSearch> search;
+};
+
+#endif
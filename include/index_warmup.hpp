@@ -0,0 +1,55 @@
+#ifndef INDEX_WARMUP_HPP
+#define INDEX_WARMUP_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+class BooleanIndexBuilder;
+
+/*
+ * Прогрев только что загруженного индекса до первых настоящих запросов.
+ *
+ * После запуска страницы отображенного файла еще не в памяти, и первые
+ * запросы ждут диск. Прогрев в пределах бюджета времени:
+ *   1. просит ядро заранее прочитать словарь и списки самых частых
+ *      терминов (madvise WILLNEED, чтение идет в фоне);
+ *   2. повторяет самые частые запросы из журнала прошлых запросов:
+ *      так в памяти оказываются именно нужные списки. Повтор идет
+ *      отдельным поиском без записи метрик поиска; его кэш анализатора
+ *      после прогрева не используется.
+ *
+ * Журнал - файл запросов по строке (как для --file) или журнал медленных
+ * запросов (JSON-строки SlowQueryLog, запрос берется из поля "query").
+ */
+class IndexWarmup {
+public:
+    struct Options {
+        std::string query_log;        // Пусто - без повтора запросов
+        size_t top_queries = 100;     // Сколько самых частых запросов повторить
+        size_t top_terms = 1000;      // Списки скольких частых терминов подгрузить
+        uint64_t budget_ns = 2000000000;  // 2 с на весь прогрев
+    };
+
+    struct Report {
+        size_t terms_prefetched = 0;
+        uint64_t bytes_prefetched = 0;
+        size_t queries_replayed = 0;
+        size_t queries_available = 0;  // Различных запросов в журнале
+        bool budget_exhausted = false;
+        double duration_ms = 0.0;
+
+        // Строка для вывода: что подгружено и сколько заняло
+        std::string summary() const;
+    };
+
+    // Самые частые запросы журнала по убыванию частоты (не более limit);
+    // при равной частоте - в порядке первого появления
+    static std::vector<std::string> read_top_queries(const std::string& filename, size_t limit,
+                                                     size_t* distinct = nullptr);
+
+    // Ошибка чтения журнала - исключение
+    static Report run(const BooleanIndexBuilder& index, const Options& options);
+};
+
+#endif
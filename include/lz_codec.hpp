@@ -0,0 +1,26 @@
+#ifndef LZ_CODEC_HPP
+#define LZ_CODEC_HPP
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * Простой кодек LZ77 в стиле LZ4 для блоков хранилища документов.
+ *
+ * Сжатые данные - последовательности:
+ *   [token: 1 байт] - старшие 4 бита длина литералов, младшие - длина совпадения - 4
+ *   [доп. длина литералов: байты 255 ... < 255, если поле равно 15]
+ *   [литералы]
+ *   [offset: 2 байта] - расстояние до совпадения назад
+ *   [доп. длина совпадения: байты 255 ... < 255, если поле равно 15]
+ * Последняя последовательность содержит только литералы.
+ */
+
+// Сжимает size байт из input в конец output
+void lz_compress(const char* input, size_t size, std::string& output);
+
+// Распаковывает ровно raw_size байт; при повреждении данных бросает исключение
+void lz_decompress(const char* input, size_t size, char* output, size_t raw_size);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef NEAR_DUPLICATES_HPP
+#define NEAR_DUPLICATES_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/*
+ * Поиск почти-дубликатов (перепечатки одной статьи) при построении индекса.
+ *
+ * Для каждого документа считается 64-битный SimHash по парам соседних
+ * терминов после анализа. Дубликатами считаются документы с расстоянием Хэмминга
+ * не больше MAX_DISTANCE. Пары-кандидаты ищутся по переставленным
+ * таблицам подписей: подпись делится на MAX_DISTANCE + 2 блока по 9-10
+ * бит, и у двух подписей с расстоянием <= MAX_DISTANCE совпадают хотя
+ * бы два блока. Для каждой пары блоков подписи сортируются по их битам
+ * (18-20 бит) и сравниваются только внутри групп с одинаковым ключом.
+ * Группы малы и при миллионах документов, поэтому все такие пары
+ * находятся за O(n log n), а не O(n^2).
+ */
+class NearDuplicateDetector {
+public:
+    // Одно лишнее слово в длинной статье меняет до 4-5 бит подписи
+    static const uint32_t MAX_DISTANCE = 5;
+    // Короткие документы не сравниваются: их подписи совпадают случайно
+    static const size_t MIN_TERMS = 8;
+
+    void clear();
+
+    // Термины следующего документа (по порядку ID)
+    void add(const std::vector<std::string>& terms);
+
+    size_t size() const { return signatures.size(); }
+
+    // Номер кластера каждого документа; номера идут по первому документу
+    // кластера, первый документ кластера - его представитель
+    std::vector<uint32_t> clusters() const;
+
+    static uint64_t simhash(const std::vector<std::string>& terms);
+
+private:
+    std::vector<uint64_t> signatures;
+    std::vector<bool> comparable;
+};
+
+#endif
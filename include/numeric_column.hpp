@@ -0,0 +1,80 @@
+#ifndef NUMERIC_COLUMN_HPP
+#define NUMERIC_COLUMN_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "bitmap.hpp"
+
+/*
+ * Числовая колонка по ID документа (doc values), например word_count.
+ *
+ * Значения хранятся упакованными: value - min_value занимает bit_width
+ * бит, значение документа i начинается с бита i * bit_width. Фильтр
+ * диапазона проходит по упакованному массиву без ветвлений и сразу
+ * собирает битовую карту документов.
+ *
+ * Для каждого блока из BLOCK_DOCS документов хранятся наименьшее и
+ * наибольшее значения (считаются при pack() и при отображении файла):
+ * фильтр пропускает блоки вне диапазона и заполняет блоки целиком
+ * внутри него, не читая значения.
+ *
+ * Как и прямой индекс, колонка либо владеет данными (после построения),
+ * либо ссылается на отображенный файл.
+ */
+class NumericColumn {
+public:
+    NumericColumn() = default;
+
+    NumericColumn(const NumericColumn& other);
+    NumericColumn& operator=(const NumericColumn& other);
+    NumericColumn(NumericColumn&&) = default;
+    NumericColumn& operator=(NumericColumn&&) = default;
+
+    void clear();
+
+    // Построение: значения добавляются по порядку ID, затем pack()
+    void add(uint32_t value);
+    void pack();
+
+    // Новый документ i - бывший order[i] (после pack())
+    void reorder(const std::vector<uint32_t>& order);
+
+    // Представление упакованных данных (после data должно быть
+    // не меньше 8 байт, чтобы читать значения словами)
+    static NumericColumn view(uint32_t doc_count, uint32_t bit_width, uint32_t min_value,
+                              uint32_t max_value, const uint8_t* data);
+
+    size_t size() const { return doc_count; }
+    uint32_t get_bit_width() const { return bit_width; }
+    uint32_t get_min() const { return min_value; }
+    uint32_t get_max() const { return max_value; }
+
+    uint32_t get(uint32_t doc_id) const;
+
+    // Документы со значением в [low, high]
+    Bitmap range(uint32_t low, uint32_t high) const;
+
+    // Упакованные данные для записи в файл (с запасом в 8 байт)
+    const uint8_t* packed_data() const { return data; }
+    size_t packed_size() const;
+
+    static constexpr uint32_t BLOCK_DOCS = 512;  // Кратно 64
+
+private:
+    void build_blocks();
+
+    std::vector<uint32_t> values;  // Только при построении
+    std::vector<uint8_t> own_data;
+
+    uint32_t doc_count = 0;
+    uint32_t bit_width = 0;
+    uint32_t min_value = 0;
+    uint32_t max_value = 0;
+    std::vector<uint32_t> block_min;  // value - min_value по блокам
+    std::vector<uint32_t> block_max;
+    const uint8_t* data = nullptr;
+    bool owned = true;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef QUERY_PLAN_HPP
+#define QUERY_PLAN_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <memory_resource>
+#include <cstdint>
+#include "bitmap.hpp"
+
+/*
+ * План запроса - дерево, которое строит парсер BooleanSearch.
+ * Листья TERM уже содержат списки документов (для шаблонов и нечетких
+ * терминов - объединение раскрытых терминов), листья FILTER - битовые
+ * карты полей-фильтров (редкие значения - списком), внутренние узлы - операции.
+ * По плану считается результат целиком (search) или строится дерево
+ * итераторов для постраничной выдачи (search_page).
+ */
+struct QueryNode {
+    enum class Type {
+        TERM,
+        FILTER,  // Готовая битовая карта (source:wikipedia)
+        AND,
+        OR,
+        NOT
+    };
+
+    Type type;
+    std::string label;               // Термин запроса после анализа (для TERM)
+    // Список документов (для TERM и FILTER без карты); память - ресурс
+    // узла (у BooleanSearch - арена запроса, план не переживает вызов)
+    std::pmr::vector<uint32_t> postings;
+    // Документы FILTER; у редкого значения поля карты нет, документы в postings
+    std::shared_ptr<const Bitmap> filter;
+    std::vector<std::unique_ptr<QueryNode>> children;
+
+    // Чтение списков листа при разборе запроса (заполняется только
+    // при профилировании, BooleanSearch::explain)
+    struct FetchStats {
+        size_t lists = 0;            // Списки терминов (шаблон раскрывается в несколько)
+        size_t postings = 0;         // Их суммарная длина
+        uint64_t bytes_decoded = 0;  // Сжатые байты, разобранные из файла индекса
+        uint64_t ns = 0;
+    };
+    FetchStats fetch;
+
+    explicit QueryNode(Type type, const std::string& label = "",
+                       std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : type(type), label(label), postings(resource) {}
+};
+
+using QueryPlan = std::unique_ptr<QueryNode>;
+
+// Каноническая запись плана: (AND dress (NOT shoe))
+std::string plan_to_string(const QueryNode& node);
+
+// Вид запроса для метрик: один термин, шаблон, нечеткий термин, фильтр,
+// AND или OR из листьев, AND с отрицаниями, остальное - составной
+enum class QueryShape {
+    TERM,
+    WILDCARD,
+    FUZZY,
+    FILTER,
+    AND,
+    OR,
+    NOT,
+    COMPLEX
+};
+
+constexpr size_t QUERY_SHAPES = 8;
+
+QueryShape plan_shape(const QueryNode& node);
+const char* shape_name(QueryShape shape);
+
+#endif
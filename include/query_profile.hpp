@@ -0,0 +1,45 @@
+#ifndef QUERY_PROFILE_HPP
+#define QUERY_PROFILE_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/*
+ * Профиль выполнения запроса (EXPLAIN): план после разбора и для каждого
+ * узла - прочитанные списки, разобранные байты индекса, пропуски при
+ * пересечении, размер промежуточного результата и время в наносекундах.
+ * Списки терминов читаются при разборе запроса, поэтому у листьев время
+ * чтения (fetch_ns) отдельно от времени вычисления (eval_ns).
+ */
+struct QueryProfile {
+    struct Node {
+        std::string operation;       // TERM, FILTER, AND, OR, NOT
+        std::string label;           // Термин или фильтр (для листьев)
+        size_t lists_read = 0;       // Прочитанные списки терминов
+        size_t postings_read = 0;    // Их суммарная длина
+        uint64_t bytes_decoded = 0;  // Сжатые байты из файла индекса
+        uint64_t fetch_ns = 0;       // Чтение списков при разборе
+        size_t skips = 0;            // Элементы, пропущенные при пересечении
+        size_t output_size = 0;      // Документов в результате узла
+        uint64_t eval_ns = 0;        // Вычисление узла вместе с дочерними
+        std::vector<Node> children;
+    };
+
+    std::string query;
+    std::string plan;  // Каноническая запись плана: (AND dress (NOT shoe))
+    std::string error;  // Ошибка разбора (план тогда пустой)
+    Node root;
+    size_t result_count = 0;  // После свертки почти-дубликатов
+    uint64_t parse_ns = 0;    // Разбор запроса и чтение списков
+    uint64_t eval_ns = 0;
+    uint64_t total_ns = 0;
+};
+
+// Дерево плана с показателями узлов для вывода в терминал
+std::string profile_to_text(const QueryProfile& profile);
+
+// Профиль одной строкой JSON
+std::string profile_to_json(const QueryProfile& profile);
+
+#endif
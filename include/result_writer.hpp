@@ -0,0 +1,89 @@
+#ifndef RESULT_WRITER_HPP
+#define RESULT_WRITER_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include "ring_buffer.hpp"
+
+class ForwardIndex;
+class FileWriter;
+
+/*
+ * Вывод результатов пакетного поиска отдельным потоком.
+ *
+ * Потоки поиска форматируют результаты своих запросов в собственный буфер
+ * (append) и отдают готовый блок с порядковым номером (submit) через
+ * RingBuffer без блокировок; большой блок можно отдавать частями по мере
+ * заполнения буфера. Поток записи выводит блоки строго по номерам,
+ * большими записями: в файл через FileWriter (временный файл, публикация
+ * переименованием в finish) или на стандартный вывод. Поэтому форматирование
+ * и запись идут одновременно с вычислением следующих запросов, а порядок
+ * вывода совпадает с порядком запросов.
+ *
+ * Форматы записи одного запроса:
+ *   TEXT   Query: ... / Results: N / "  - заголовок (URL)" на документ
+ *   TSV    запрос \t N \t id,id,...
+ *   JSONL  {"query": ..., "count": N, "doc_ids": [...]}
+ *   BINARY uint32 длина запроса, байты запроса, uint32 N, N x uint32 ID
+ *          (порядок байт машины)
+ */
+class ResultWriter {
+public:
+    enum class Format {
+        TEXT,
+        TSV,
+        JSONL,
+        BINARY
+    };
+
+    static Format parse_format(const std::string& name);
+
+    // Запись одного запроса в буфер; TEXT берет заголовки и URL из documents
+    static void append(Format format, std::string& out, const std::string& query,
+                       const std::vector<uint32_t>& doc_ids, const ForwardIndex& documents);
+
+    // Пустое имя - стандартный вывод
+    explicit ResultWriter(const std::string& filename, size_t queue_capacity = 64);
+    ~ResultWriter();
+
+    ResultWriter(const ResultWriter&) = delete;
+    ResultWriter& operator=(const ResultWriter&) = delete;
+
+    // Часть блока номер sequence (номера подряд с нуля, части одного блока
+    // из одного потока по порядку); last - последняя часть. Ждет, если
+    // очередь полна
+    void submit(size_t sequence, std::string&& block, bool last = true);
+
+    // Дописывает все блоки и публикует файл; ошибка записи - исключение
+    void finish();
+
+    uint64_t bytes_written() const { return written.load(std::memory_order_relaxed); }
+
+private:
+    struct Block {
+        size_t sequence = 0;
+        std::string data;
+        bool last = true;
+    };
+
+    std::unique_ptr<FileWriter> file;
+    RingBuffer<Block> queue;
+    std::atomic<uint64_t> written{0};
+    std::string error;  // Ошибка потока записи
+
+    std::thread writer;
+    std::mutex wake_mutex;
+    std::condition_variable wake_signal;
+    bool finishing = false;
+
+    void write_loop();
+    void stop();
+};
+
+#endif
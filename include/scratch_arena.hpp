@@ -0,0 +1,78 @@
+#ifndef SCRATCH_ARENA_HPP
+#define SCRATCH_ARENA_HPP
+
+#include <memory_resource>
+#include <vector>
+#include <cstddef>
+
+/*
+ * Арена для временных данных одного документа или запроса (std::pmr).
+ *
+ * Память выдается сдвигом указателя по блокам, deallocate ничего не делает.
+ * reset() возвращает указатель в начало первого блока, блоки остаются для
+ * следующего документа или запроса, поэтому в установившемся режиме
+ * обращений к malloc нет. Если запрос не поместился и блоков стало
+ * несколько, при сбросе они заменяются одним блоком суммарного размера,
+ * но не больше MAX_RETAINED; один блок при сбросе не перевыделяется.
+ */
+class ScratchArena : public std::pmr::memory_resource {
+public:
+    static constexpr size_t MAX_RETAINED = 64 << 20;
+
+    explicit ScratchArena(size_t initial_size = 64 << 10);
+    ~ScratchArena() override;
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    void reset();
+
+    size_t used_bytes() const { return used; }        // С последнего сброса
+    size_t peak_bytes() const { return peak; }        // Наибольший used_bytes
+    size_t reserved_bytes() const { return reserved; }  // Размер блоков
+
+    // Область документа или запроса: сброс при выходе из внешней области,
+    // вложенные (search внутри search_ranked) арену не трогают
+    class Scope {
+    public:
+        explicit Scope(ScratchArena& arena) : arena(arena) { arena.depth++; }
+        ~Scope() {
+            if (--arena.depth == 0) {
+                arena.reset();
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        ScratchArena& arena;
+    };
+
+private:
+    struct Block {
+        char* data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks;
+    size_t current = 0;  // Блок, из которого идет выдача
+    size_t offset = 0;   // Занято в текущем блоке
+    size_t initial_size;
+
+    size_t used = 0;
+    size_t peak = 0;
+    size_t reserved = 0;
+    size_t depth = 0;
+
+    void add_block(size_t size);
+    void release_blocks();
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+#endif
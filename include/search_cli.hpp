@@ -3,16 +3,48 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
+#include <memory>
+#include <fstream>
+#include "index_warmup.hpp"
+
+class BooleanSearch;
+class BooleanIndexBuilder;
+class SlowQueryLog;
 
 class SearchCLI {
 public:
     struct Config {
         std::string index_file = "fashion_index.bin";
+        std::string data_file = "fashion_data_compact.json";  // Документы для --build
         std::string query_file;
         std::string output_file;
+        std::string metrics_file;  // Метрики в формате Prometheus при выходе ("-" - на экран)
+        std::string slow_log_file;  // Журнал медленных запросов
+        double slow_ms = 100.0;     // Порог медленного запроса
+        uint32_t sample_every = 0;  // В журнал и каждый N-й обычный запрос
+        int threads = 1;            // Потоки пакетного поиска
+        std::string format;         // Формат вывода пакетного поиска: text, tsv, jsonl, bin
+        bool warmup = false;        // Прогрев индекса после загрузки
+        std::string warmup_log;     // Журнал запросов для прогрева
+        int warmup_queries = 100;   // Самые частые запросы журнала
+        double warmup_ms = 2000.0;  // Бюджет прогрева
         bool interactive = false;
         bool build_index = false;
         bool show_stats = false;
+        bool fuzzy = false;
+        bool snippets = true;
+        bool count_only = false;   // Только количество результатов
+        bool exists_only = false;  // Только есть ли результаты
+        bool show_facets = false;  // Количество результатов по source/category
+        bool collapse = true;      // Сворачивать почти-дубликаты в выдаче
+        std::string dedup = "none";  // Почти-дубликаты при построении: none, collapse, drop
+        std::string order = "input";  // Порядок ID документов: input, url
+        bool ranked = false;       // Top-k по весам терминов вместо всех результатов
+        int hot_tier = 0;          // Размер верхнего уровня индекса (0 - без него)
+        bool verify = false;       // Проверять контрольные суммы индекса
+        bool watch = false;        // Подхватывать пересобранный индекс без перезапуска
+        bool profile = false;      // Профиль выполнения запросов (EXPLAIN)
         int limit_results = 50;
     };
 
@@ -23,6 +55,10 @@ public:
     // Показать справку
     static void show_help();
 
+    // Поток служебных сообщений: поток ошибок, если результаты пакетного
+    // поиска идут на стандартный вывод (--threads/--format без -o)
+    std::ostream& messages() const;
+
 private:
     Config config;
 
@@ -32,14 +68,37 @@ private:
     // Режимы работы
     int run_interactive();
     int run_batch();
+    int run_count(BooleanSearch& searcher, const std::vector<std::string>& queries);
+    int run_ranked(BooleanSearch& searcher, const std::vector<std::string>& queries);
+    int run_profile(BooleanSearch& searcher, const std::vector<std::string>& queries);
+    // Пакетный поиск в потоках с выводом через ResultWriter
+    int run_pipeline(const BooleanIndexBuilder& index, const std::vector<std::string>& queries,
+                     SlowQueryLog* slow_log);
     int run_build_index();
     int run_show_stats();
 
+    void save_metrics();
+
+    // Настройки прогрева (IndexWarmup) из параметров командной строки
+    IndexWarmup::Options warmup_options() const;
+
+    // Журнал медленных запросов по настройкам (nullptr, если не задан)
+    std::unique_ptr<SlowQueryLog> open_slow_log();
+    void report_slow_log(const SlowQueryLog* log);
+
+    // Страница результатов с нумерацией от first_number + 1
+    void print_page(BooleanSearch& searcher, const std::vector<uint32_t>& doc_ids,
+                    const std::string& query, size_t first_number);
+
+    void print_facets(BooleanSearch& searcher, const std::string& query);
+
     void print_results(const std::vector<uint32_t>& doc_ids,
                        const std::string& query = "");
+    // Дописывает результат запроса в файл, открытый один раз на сеанс
     void save_results(const std::vector<uint32_t>& doc_ids,
                       const std::string& query,
                       const std::string& filename);
+    std::ofstream results_file;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,82 @@
+#ifndef SLOW_QUERY_LOG_HPP
+#define SLOW_QUERY_LOG_HPP
+
+#include <string>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include "query_profile.hpp"
+#include "ring_buffer.hpp"
+
+/*
+ * Журнал медленных запросов: запросы дольше порога и каждый N-й из
+ * остальных записываются с планом, временем и размером результата каждого
+ * узла (QueryProfile), по JSON-строке на запрос.
+ *
+ * Поток запроса только кладет профиль в кольцо (RingBuffer) и не ждет
+ * ввода-вывода; файл пишет фоновый поток большими блоками и сбрасывает
+ * буфер, когда очередь опустела. Если писатель не успевает и кольцо
+ * заполнено, запись теряется и учитывается в get_dropped().
+ */
+class SlowQueryLog {
+public:
+    struct Options {
+        std::string filename;
+        uint64_t threshold_ns = 100000000;  // 100 мс
+        uint32_t sample_every = 0;          // Каждый N-й запрос (0 - без выборки)
+        size_t capacity = 4096;             // Записей в очереди
+    };
+
+    enum class Reason {
+        NONE,
+        SLOW,
+        SAMPLED
+    };
+
+    explicit SlowQueryLog(const Options& options);
+    ~SlowQueryLog();
+
+    SlowQueryLog(const SlowQueryLog&) = delete;
+    SlowQueryLog& operator=(const SlowQueryLog&) = delete;
+
+    // Нужно ли записать запрос с таким временем; профиль стоит заполнять
+    // только при ответе не NONE
+    Reason classify(uint64_t total_ns);
+
+    // Постановка в очередь без ожидания
+    void submit(Reason reason, QueryProfile&& profile);
+
+    size_t get_written() const { return written.load(std::memory_order_relaxed); }
+    size_t get_dropped() const { return dropped.load(std::memory_order_relaxed); }
+    const std::string& get_filename() const { return options.filename; }
+
+private:
+    struct Entry {
+        Reason reason = Reason::NONE;
+        int64_t unix_ms = 0;
+        QueryProfile profile;
+    };
+
+    Options options;
+    RingBuffer<Entry> queue;
+    std::ofstream out;
+
+    std::atomic<uint64_t> query_number{0};
+    std::atomic<size_t> written{0};
+    std::atomic<size_t> dropped{0};
+
+    // Писатель спит, пока очередь пуста; пропущенное пробуждение
+    // ограничено таймаутом ожидания
+    std::thread writer;
+    std::mutex wake_mutex;
+    std::condition_variable wake_signal;
+    std::atomic<bool> stopping{false};
+
+    void write_loop();
+    void write_entry(const Entry& entry);
+};
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef TERM_MATCHING_HPP
+#define TERM_MATCHING_HPP
+
+#include <string_view>
+#include <cstdint>
+
+// Сопоставление термина с шаблоном, где '*' - любая последовательность
+bool wildcard_match(std::string_view pattern, std::string_view term);
+
+// Расстояние Левенштейна, если оно не больше max_edits, иначе max_edits + 1
+uint32_t bounded_edit_distance(std::string_view a, std::string_view b, uint32_t max_edits);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef TEXT_FORMAT_HPP
+#define TEXT_FORMAT_HPP
+
+#include <string>
+#include <cstdint>
+
+/*
+ * Общее форматирование текстового вывода: строки JSON (выдача jsonl,
+ * профили и журнал медленных запросов, отчет бенчмарков, генератор
+ * корпуса) и длительности в отчетах.
+ *
+ * Строка JSON пишется в кавычках: кавычка и обратная косая черта
+ * экранируются, \n \r \t - коротко, остальные управляющие символы -
+ * \u00XX. Байты UTF-8 остаются как есть.
+ */
+void append_json_string(std::string& out, const std::string& text);
+std::string json_string(const std::string& text);
+
+// Длительность с подходящей единицей: 850 ns, 12.5 us, 3.40 ms, 1.25 s
+std::string format_ns(uint64_t ns);
+
+#endif
@@ -7,7 +7,7 @@
 struct TokenizationResult {
     std::vector<std::string> tokens;
     size_t total_chars = 0;
-    long long processing_time_ms = 0;
+    double processing_time_ms = 0.0;
 };
 
 class Tokenizer {
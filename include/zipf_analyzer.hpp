@@ -13,6 +13,14 @@ struct ZipfAnalysis {
     double zipf_constant = 0.0;
 };
 
+// Параметры закона Ципфа-Мандельброта f(r) = C / (r + B)^alpha
+struct MandelbrotFit {
+    double C = 0.0;
+    double B = 0.0;
+    double alpha = 1.0;
+    double error = 0.0;  // Средний квадрат ошибки log f (с весом 1 / r)
+};
+
 class ZipfAnalyzer {
 public:
     ZipfAnalysis analyze(const std::vector<std::string>& tokens);
@@ -20,6 +28,10 @@ public:
     std::vector<double> calculate_mandelbrot(const ZipfAnalysis& analysis,
                                              double C, double B, double alpha);
 
+    // Подбор C, B, alpha: перебор B, для каждого - взвешенная регрессия
+    // log f по log(r + B); вес 1 / r, чтобы хвост редких слов не перевешивал
+    MandelbrotFit fit_mandelbrot(const ZipfAnalysis& analysis);
+
 private:
     double calculate_zipf_constant(const std::vector<std::pair<std::string, int>>& sorted_pairs);
 };
\ No newline at end of file
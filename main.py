@@ -464,6 +464,7 @@ class AdvancedFashionCrawler:
                     update_data = {
                         'title': title or existing.get('title', ''),
                         'content': content,
+                        'category': self._extract_category_from_url(url),
                         'content_hash': content_hash,
                         'last_crawled': datetime.now(),
                         'last_modified': datetime.now(),
@@ -484,6 +485,7 @@ class AdvancedFashionCrawler:
                     'content': content,
                     'content_hash': content_hash,
                     'source': source_name,
+                    'category': self._extract_category_from_url(url),
                     'word_count': len(content.split()),
                     'first_crawled': datetime.now(),
                     'last_crawled': datetime.now(),
@@ -497,6 +499,13 @@ class AdvancedFashionCrawler:
             logger.error(f"Ошибка обработки статьи {url}: {e}")
             return False
 
+    def _extract_category_from_url(self, url: str) -> str:
+        """Раздел сайта (первый сегмент пути) как категория статьи."""
+        parts = [part for part in urlparse(url).path.split('/') if part]
+        if len(parts) > 1 and parts[0] == 'category':
+            return parts[1]
+        return parts[0] if len(parts) > 1 else ''
+
     def _extract_title_from_url(self, url: str) -> str:
         """Извлекает заголовок из URL."""
         try:
@@ -632,7 +641,7 @@ class AdvancedFashionCrawler:
                     # Обрабатываем статью
                     if member.ns == wikipediaapi.Namespace.MAIN:
                         if member.pageid not in visited_articles:
-                            if self._process_wiki_article(member):
+                            if self._process_wiki_article(member, category_title):
                                 articles_found += 1
                                 visited_articles.add(member.pageid)
 
@@ -659,7 +668,7 @@ class AdvancedFashionCrawler:
         logger.info(f"Завершено сканирование Википедии: {articles_found} статей")
         return articles_found
 
-    def _process_wiki_article(self, page) -> bool:
+    def _process_wiki_article(self, page, category_title: str = '') -> bool:
         """Обрабатывает статью Википедии через API."""
         try:
             url = f"https://en.wikipedia.org/wiki/{page.title.replace(' ', '_')}"
@@ -696,6 +705,7 @@ class AdvancedFashionCrawler:
                 update_data = {
                     'title': page.title,
                     'content': content,
+                    'category': category_title.replace('Category:', ''),
                     'content_hash': content_hash,
                     'last_crawled': datetime.now(),
                     'last_modified': datetime.now(),
@@ -714,6 +724,7 @@ class AdvancedFashionCrawler:
                     'content': content,
                     'content_hash': content_hash,
                     'source': 'Wikipedia',
+                    'category': category_title.replace('Category:', ''),
                     'word_count': len(content.split()),
                     'first_crawled': datetime.now(),
                     'last_crawled': datetime.now(),
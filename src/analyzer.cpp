@@ -0,0 +1,65 @@
+#include "analyzer.hpp"
+#include "metrics.hpp"
+
+const size_t MIN_TERM_LENGTH = 2;
+const size_t MAX_TERM_LENGTH = 50;
+
+Analyzer::Analyzer(size_t cache_capacity) : cache_capacity(cache_capacity) {
+    term_cache.reserve(cache_capacity);
+}
+
+void Analyzer::analyze(const std::string& text, std::vector<std::string>& out) {
+    out.clear();
+
+    auto tokenization_result = tokenizer.tokenize(text);
+    out.reserve(tokenization_result.tokens.size());
+
+    for (const auto& token : tokenization_result.tokens) {
+        const std::string& term = normalize_token(token);
+        if (!term.empty()) {
+            out.push_back(term);
+        }
+    }
+
+    report_cache_metrics();
+}
+
+void Analyzer::report_cache_metrics() {
+    static Counter& hits = MetricsRegistry::global().counter(
+        "analyzer_term_cache_hits_total", "Stemmed terms served from the analyzer cache");
+    static Counter& misses = MetricsRegistry::global().counter(
+        "analyzer_term_cache_misses_total", "Terms stemmed on an analyzer cache miss");
+
+    hits.add(cache_hits - reported_hits);
+    misses.add(cache_misses - reported_misses);
+    reported_hits = cache_hits;
+    reported_misses = cache_misses;
+}
+
+std::vector<std::string> Analyzer::analyze_query_term(const std::string& raw) {
+    std::vector<std::string> terms;
+    analyze(raw, terms);
+    return terms;
+}
+
+const std::string& Analyzer::normalize_token(const std::string& token) {
+    auto it = term_cache.find(token);
+    if (it != term_cache.end()) {
+        cache_hits++;
+        return it->second;
+    }
+
+    cache_misses++;
+
+    // Кэш ограничен: при переполнении начинаем заново
+    if (term_cache.size() >= cache_capacity) {
+        term_cache.clear();
+    }
+
+    std::string term = stemmer.stem(token);
+    if (term.length() < MIN_TERM_LENGTH || term.length() > MAX_TERM_LENGTH) {
+        term.clear();
+    }
+
+    return term_cache.emplace(token, std::move(term)).first->second;
+}
@@ -1,94 +1,551 @@
 #include "binary_index_format.hpp"
+#include "term_matching.hpp"
+#include "crc32c.hpp"
 #include <iostream>
 #include <cstring>
 #include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 // Магическое число для идентификации нашего формата
 const uint32_t MAGIC_NUMBER = 0x48534146;
-const uint16_t VERSION = 1;
+const uint16_t VERSION = 8;
+
+const uint64_t HEADER_SIZE = 56;
+// Блок проверки: чтение одного термина проверяет не больше пары блоков
+const uint32_t CHECKSUM_BLOCK_SIZE = 64 * 1024;
+const uint64_t DICTIONARY_HEADER_SIZE = 24;
+const uint64_t KGRAM_HEADER_SIZE = 8;
+const uint64_t KGRAM_ENTRY_SIZE = 12;
+const size_t KGRAM_LENGTH = 3;
+// Сколько самых частых терминов запоминается для прогрева
+const size_t FREQUENT_TERMS = 4096;
+
+namespace {
+
+void append_varint(std::string& out, uint32_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+// Список документов: первый ID и разности соседних ID в varint
+void encode_postings(const std::vector<uint32_t>& doc_ids, std::string& out) {
+    out.clear();
+    uint32_t previous = 0;
 
-BinaryIndexWriter::BinaryIndexWriter(const std::string& filename) {
-    file.open(filename, std::ios::binary | std::ios::out);
-    if (!file) {
-        throw std::runtime_error("Cannot open file for writing: " + filename);
+    for (uint32_t doc_id : doc_ids) {
+        append_varint(out, doc_id - previous);
+        previous = doc_id;
     }
 }
 
-BinaryIndexWriter::~BinaryIndexWriter() {
-    if (file.is_open()) {
-        file.close();
+// Разбирает count чисел varint из [p, end); false, если данные повреждены
+bool decode_varints(const uint8_t* p, const uint8_t* end, uint32_t count, uint32_t* out,
+                    bool delta) {
+    uint32_t previous = 0;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t value = 0;
+        int shift = 0;
+
+        while (true) {
+            if (p == end || shift > 28) {
+                return false;
+            }
+            uint8_t byte = *p++;
+            value |= uint32_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                break;
+            }
+            shift += 7;
+        }
+
+        previous = delta ? previous + value : value;
+        out[i] = previous;
     }
+
+    return p == end;
+}
+
+uint32_t pack_gram(std::string_view gram) {
+    return (uint32_t(uint8_t(gram[0])) << 16) |
+           (uint32_t(uint8_t(gram[1])) << 8) |
+           uint32_t(uint8_t(gram[2]));
 }
 
-void BinaryIndexWriter::write_header(uint32_t doc_count, uint32_t term_count) {
+// Триграммы строки, обрамленной '$' там, где нет '*'
+std::vector<uint32_t> pattern_grams(const std::string& pattern) {
+    std::string padded;
+    if (pattern.empty() || pattern.front() != '*') {
+        padded += '$';
+    }
+    padded += pattern;
+    if (pattern.empty() || pattern.back() != '*') {
+        padded += '$';
+    }
+
+    std::vector<uint32_t> grams;
+    size_t start = 0;
+
+    while (start <= padded.size()) {
+        size_t end = padded.find('*', start);
+        if (end == std::string::npos) {
+            end = padded.size();
+        }
+
+        for (size_t i = start; i + KGRAM_LENGTH <= end; ++i) {
+            grams.push_back(pack_gram(std::string_view(padded).substr(i, KGRAM_LENGTH)));
+        }
+
+        start = end + 1;
+    }
+
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    return grams;
+}
+
+}  // namespace
+
+BinaryIndexWriter::BinaryIndexWriter(const std::string& filename) : file(filename) {
+}
+
+BinaryIndexWriter::~BinaryIndexWriter() {
+}
+
+void BinaryIndexWriter::write_header(uint32_t doc_count, uint32_t term_count,
+                                     uint64_t store_id) {
     write_uint32(MAGIC_NUMBER);          // magic
     write_uint16(VERSION);               // version
     write_uint16(0);                     // flags (reserved)
     write_uint32(doc_count);             // document count
     write_uint32(term_count);            // term count
 
-    write_uint64(0);
-    write_uint64(0);
+    write_uint64(0);                     // forward offset
+    write_uint64(0);                     // inverted offset
+    write_uint64(0);                     // sections offset
+    write_uint64(0);                     // checksums offset
+    write_uint64(store_id);              // content store id
+}
+
+void BinaryIndexWriter::write_forward_index(const ForwardIndex& index) {
+    // Колонки читаются из отображенного файла как массивы uint32_t
+    write_padding(8);
+    uint64_t forward_offset = get_position();
+
+    uint32_t doc_count = static_cast<uint32_t>(index.size());
+
+    write_uint32(doc_count);
+    write_uint32(ForwardIndex::FIELD_COUNT);
+    write_uint64(index.strings_size());
+
+    if (doc_count == 0) {
+        write_uint32(0);
+    } else {
+        file.write(reinterpret_cast<const char*>(index.offsets()),
+                   (uint64_t(doc_count) * ForwardIndex::FIELD_COUNT + 1) * sizeof(uint32_t));
+        file.write(reinterpret_cast<const char*>(index.doc_lengths()),
+                   uint64_t(doc_count) * sizeof(uint32_t));
+        file.write(index.strings(), index.strings_size());
+    }
+
+    add_section(SectionId::FORWARD, forward_offset);
+    file.patch(16, &forward_offset, sizeof(forward_offset));
+}
+
+void BinaryIndexWriter::begin_inverted_index(uint32_t term_count) {
+    inverted_offset = get_position();
+    expected_terms = term_count;
+    write_uint32(term_count);
+
+    dictionary_terms.clear();
+    dictionary_terms.reserve(term_count);
+    hot_lists.clear();
+    frequent_lists.clear();
+}
+
+void BinaryIndexWriter::add_term(const std::string& term, const std::vector<uint32_t>& doc_ids,
+                                 const std::vector<uint32_t>& frequencies) {
+    // Словарь ищет термины бинарным поиском: порядок обязателен
+    if (!dictionary_terms.empty() && !(dictionary_terms.back().first < term)) {
+        throw std::runtime_error("Terms are not sorted and unique: " + term);
+    }
+    if (dictionary_terms.size() >= expected_terms) {
+        throw std::runtime_error("More terms than announced in begin_inverted_index");
+    }
+
+    if (frequencies.empty()) {
+        ones.assign(doc_ids.size(), 1);
+    } else if (frequencies.size() != doc_ids.size()) {
+        throw std::runtime_error("Term frequencies do not match postings: " + term);
+    }
+    const auto& term_frequencies = frequencies.empty() ? ones : frequencies;
+
+    write_string(term);
+
+    TermInfo info;
+    info.doc_freq = static_cast<uint32_t>(doc_ids.size());
+    info.postings_offset = get_position();
+    dictionary_terms.emplace_back(term, info);
+
+    encode_postings(doc_ids, encoded_ids);
+    encoded_frequencies.clear();
+    for (uint32_t frequency : term_frequencies) {
+        append_varint(encoded_frequencies, frequency);
+    }
+
+    if (encoded_ids.size() > UINT32_MAX || encoded_frequencies.size() > UINT32_MAX) {
+        throw std::runtime_error("Postings list too large: " + term);
+    }
+
+    write_uint32(static_cast<uint32_t>(doc_ids.size()));
+    write_uint32(static_cast<uint32_t>(encoded_ids.size()));
+    write_uint32(static_cast<uint32_t>(encoded_frequencies.size()));
+    file.write(encoded_ids.data(), encoded_ids.size());
+    file.write(encoded_frequencies.data(), encoded_frequencies.size());
+    postings_bytes += encoded_ids.size() + encoded_frequencies.size();
+
+    // Термины идут по возрастанию, поэтому при равном doc_freq остается
+    // более ранний
+    auto rarer = [](const FrequentList& a, const FrequentList& b) {
+        return a.doc_freq > b.doc_freq;
+    };
+    FrequentList frequent{info.doc_freq, info.postings_offset,
+                          get_position() - info.postings_offset};
+    if (frequent_lists.size() < FREQUENT_TERMS) {
+        frequent_lists.push_back(frequent);
+        std::push_heap(frequent_lists.begin(), frequent_lists.end(), rarer);
+    } else if (frequent.doc_freq > frequent_lists.front().doc_freq) {
+        std::pop_heap(frequent_lists.begin(), frequent_lists.end(), rarer);
+        frequent_lists.back() = frequent;
+        std::push_heap(frequent_lists.begin(), frequent_lists.end(), rarer);
+    }
+
+    if (hot_tier_size == 0 || doc_ids.size() <= hot_tier_size) {
+        return;
+    }
+
+    // Верхний уровень: документы с наибольшей частотой (при равенстве - меньший ID)
+    std::vector<uint32_t> order(doc_ids.size());
+    for (uint32_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    auto by_frequency = [&](uint32_t a, uint32_t b) {
+        return term_frequencies[a] != term_frequencies[b]
+                   ? term_frequencies[a] > term_frequencies[b]
+                   : a < b;
+    };
+    std::nth_element(order.begin(), order.begin() + hot_tier_size, order.end(), by_frequency);
+
+    HotList hot;
+    hot.postings_offset = info.postings_offset;
+    hot.max_rest_frequency = term_frequencies[order[hot_tier_size]];
+    for (size_t i = hot_tier_size + 1; i < order.size(); ++i) {
+        hot.max_rest_frequency = std::max(hot.max_rest_frequency, term_frequencies[order[i]]);
+    }
+
+    order.resize(hot_tier_size);
+    std::sort(order.begin(), order.end());
+    for (uint32_t i : order) {
+        hot.doc_ids.push_back(doc_ids[i]);
+        hot.frequencies.push_back(term_frequencies[i]);
+    }
+
+    hot_lists.push_back(std::move(hot));
+}
+
+void BinaryIndexWriter::end_inverted_index() {
+    if (dictionary_terms.size() != expected_terms) {
+        throw std::runtime_error("Fewer terms than announced in begin_inverted_index");
+    }
+
+    add_section(SectionId::INVERTED, inverted_offset);
+
+    // Обновляем заголовок
+    file.patch(24, &inverted_offset, sizeof(inverted_offset));
+}
+
+void BinaryIndexWriter::write_dictionary(uint32_t block_size) {
+    if (block_size == 0) {
+        throw std::runtime_error("Dictionary block size must be positive");
+    }
+
+    uint64_t dictionary_offset = get_position();
+
+    uint32_t term_count = static_cast<uint32_t>(dictionary_terms.size());
+    uint32_t block_count = (term_count + block_size - 1) / block_size;
+
+    uint64_t total_postings = 0;
+    for (const auto& [term, info] : dictionary_terms) {
+        total_postings += info.doc_freq;
+    }
+
+    write_uint32(term_count);
+    write_uint32(block_size);
+    write_uint32(block_count);
     write_uint32(0);
+    write_uint64(total_postings);
+
+    // Место под таблицу смещений блоков заполняем после записи блоков
+    uint64_t offsets_pos = get_position();
+    for (uint32_t b = 0; b < block_count; ++b) {
+        write_uint32(0);
+    }
+
+    uint64_t blocks_pos = get_position();
+    std::vector<uint32_t> block_offsets;
+    block_offsets.reserve(block_count);
+
+    for (uint32_t i = 0; i < term_count; ++i) {
+        const auto& [term, info] = dictionary_terms[i];
+
+        size_t prefix = 0;
+        uint64_t postings = info.postings_offset;
+
+        if (i % block_size == 0) {
+            block_offsets.push_back(static_cast<uint32_t>(get_position() - blocks_pos));
+        } else {
+            const auto& [prev_term, prev_info] = dictionary_terms[i - 1];
+            size_t max_prefix = std::min({prev_term.size(), term.size(), size_t(255)});
+            while (prefix < max_prefix && prev_term[prefix] == term[prefix]) {
+                prefix++;
+            }
+            postings -= prev_info.postings_offset;
+        }
+
+        if (term.size() - prefix > 255) {
+            throw std::runtime_error("Term too long for dictionary: " + term);
+        }
+
+        write_uint8(static_cast<uint8_t>(prefix));
+        write_uint8(static_cast<uint8_t>(term.size() - prefix));
+        file.write(term.data() + prefix, term.size() - prefix);
+        write_varint(info.doc_freq);
+        write_varint(postings);
+    }
+
+    file.patch(offsets_pos, block_offsets.data(), block_offsets.size() * sizeof(uint32_t));
+
+    add_section(SectionId::DICTIONARY, dictionary_offset);
+}
+
+void BinaryIndexWriter::write_kgram_index() {
+    uint64_t kgram_offset = get_position();
+
+    std::unordered_map<uint32_t, std::vector<uint32_t>> gram_lists;
+
+    for (uint32_t ordinal = 0; ordinal < dictionary_terms.size(); ++ordinal) {
+        std::string padded = "$" + dictionary_terms[ordinal].first + "$";
+
+        for (size_t i = 0; i + KGRAM_LENGTH <= padded.size(); ++i) {
+            auto& list = gram_lists[pack_gram(std::string_view(padded).substr(i, KGRAM_LENGTH))];
+            if (list.empty() || list.back() != ordinal) {
+                list.push_back(ordinal);
+            }
+        }
+    }
+
+    std::vector<uint32_t> grams;
+    grams.reserve(gram_lists.size());
+    for (const auto& [gram, list] : gram_lists) {
+        grams.push_back(gram);
+    }
+    std::sort(grams.begin(), grams.end());
+
+    write_uint32(static_cast<uint32_t>(grams.size()));
     write_uint32(0);
+
+    uint32_t list_offset = 0;
+    for (uint32_t gram : grams) {
+        write_uint8(static_cast<uint8_t>(gram >> 16));
+        write_uint8(static_cast<uint8_t>(gram >> 8));
+        write_uint8(static_cast<uint8_t>(gram));
+        write_uint8(0);
+
+        uint32_t list_size = static_cast<uint32_t>(gram_lists[gram].size());
+        write_uint32(list_offset);
+        write_uint32(list_size);
+        list_offset += list_size;
+    }
+
+    for (uint32_t gram : grams) {
+        const auto& list = gram_lists[gram];
+        file.write(reinterpret_cast<const char*>(list.data()), list.size() * sizeof(uint32_t));
+    }
+
+    add_section(SectionId::KGRAMS, kgram_offset);
 }
 
-void BinaryIndexWriter::write_forward_index(const std::vector<ForwardIndexEntry>& entries) {
-    uint64_t forward_offset = get_position();
+void BinaryIndexWriter::write_facets(const FacetIndex& facets) {
+    // Карты читаются словами по 8 байт
+    write_padding(8);
+    uint64_t facets_offset = get_position();
+
+    const auto& names = FacetIndex::field_names();
+    size_t word_count = (uint64_t(facets.get_doc_count()) + 63) / 64;
+
+    write_uint32(static_cast<uint32_t>(names.size()));
+    write_uint32(facets.get_doc_count());
+
+    for (const auto& name : names) {
+        const auto& values = facets.values(name);
+
+        write_string(name);
+        write_uint32(static_cast<uint32_t>(values.size()));
+
+        // Значение: вид (0 - карта, 1 - список ID), затем карта словами
+        // или uint32 количество и ID по возрастанию
+        for (const auto& [value, facet] : values) {
+            write_string(value);
+
+            std::vector<uint32_t> doc_ids;
+            if (facet.bitmap) {
+                if (FacetIndex::is_sparse(facet.bitmap->count(), facets.get_doc_count())) {
+                    doc_ids = facet.bitmap->to_vector();
+                } else {
+                    write_uint8(0);
+                    write_padding(8);
+                    file.write(reinterpret_cast<const char*>(facet.bitmap->data()),
+                               word_count * sizeof(uint64_t));
+                    continue;
+                }
+            } else {
+                doc_ids.assign(facet.doc_ids, facet.doc_ids + facet.id_count);
+            }
+
+            write_uint8(1);
+            write_uint32(static_cast<uint32_t>(doc_ids.size()));
+            write_padding(4);
+            file.write(reinterpret_cast<const char*>(doc_ids.data()),
+                       doc_ids.size() * sizeof(uint32_t));
+        }
+    }
 
-    write_uint32(static_cast<uint32_t>(entries.size()));
+    add_section(SectionId::FACETS, facets_offset);
+}
 
-    for (const auto& entry : entries) {
-        // ID
-        write_string(entry.id);
+void BinaryIndexWriter::set_hot_tier_size(uint32_t size) {
+    hot_tier_size = size;
+}
 
-        // URL
-        write_string(entry.url);
+void BinaryIndexWriter::write_hot_tier() {
+    write_padding(8);
+    uint64_t tier_offset = get_position();
 
-        // Заголовок
-        write_string(entry.title);
+    write_uint32(static_cast<uint32_t>(hot_lists.size()));
+    write_uint32(hot_tier_size);
 
-        // Длина документа
-        write_uint32(entry.doc_length);
+    // Термины записаны по порядку, поэтому postings_offset уже возрастают
+    uint64_t list_offset = tier_offset + 8 + hot_lists.size() * 16;
+    for (const auto& hot : hot_lists) {
+        write_uint64(hot.postings_offset);
+        write_uint64(list_offset);
+        list_offset += 8 + hot.doc_ids.size() * 2 * sizeof(uint32_t);
+    }
 
-        // Checksum
-        write_uint32(entry.checksum);
+    for (const auto& hot : hot_lists) {
+        write_uint32(static_cast<uint32_t>(hot.doc_ids.size()));
+        write_uint32(hot.max_rest_frequency);
+        file.write(reinterpret_cast<const char*>(hot.doc_ids.data()),
+                   hot.doc_ids.size() * sizeof(uint32_t));
+        file.write(reinterpret_cast<const char*>(hot.frequencies.data()),
+                   hot.frequencies.size() * sizeof(uint32_t));
     }
 
-    uint64_t current_pos = get_position();
-    file.seekp(16, std::ios::beg);
-    write_uint64(forward_offset);
-    file.seekp(current_pos, std::ios::beg);
+    hot_lists.clear();
+    add_section(SectionId::HOT_TIER, tier_offset);
 }
 
-void BinaryIndexWriter::write_inverted_index(const std::vector<std::pair<std::string, std::vector<uint32_t>>>& entries) {
-    uint64_t inverted_offset = get_position();
+void BinaryIndexWriter::write_frequent_terms() {
+    write_padding(8);
+    uint64_t frequent_offset = get_position();
 
-    std::vector<std::pair<std::string, std::vector<uint32_t>>> sorted_entries = entries;
-    std::sort(sorted_entries.begin(), sorted_entries.end(),
-              [](const auto& a, const auto& b) { return a.first < b.first; });
+    // По убыванию doc_freq, при равенстве - в порядке терминов
+    std::sort(frequent_lists.begin(), frequent_lists.end(),
+              [](const FrequentList& a, const FrequentList& b) {
+                  return a.doc_freq != b.doc_freq ? a.doc_freq > b.doc_freq
+                                                  : a.postings_offset < b.postings_offset;
+              });
+
+    write_uint32(static_cast<uint32_t>(frequent_lists.size()));
+    write_uint32(0);
+    for (const auto& frequent : frequent_lists) {
+        write_uint64(frequent.postings_offset);
+        write_uint64(frequent.postings_length);
+    }
+
+    frequent_lists.clear();
+    add_section(SectionId::FREQUENT_TERMS, frequent_offset);
+}
 
-    write_uint32(static_cast<uint32_t>(sorted_entries.size()));
+void BinaryIndexWriter::write_doc_values(const std::map<std::string, NumericColumn>& columns) {
+    write_padding(8);
+    uint64_t values_offset = get_position();
 
-    for (const auto& entry : sorted_entries) {
-        write_string(entry.first);
+    uint32_t doc_count = columns.empty() ? 0 : static_cast<uint32_t>(columns.begin()->second.size());
 
-        write_uint32(static_cast<uint32_t>(entry.second.size()));
+    write_uint32(static_cast<uint32_t>(columns.size()));
+    write_uint32(doc_count);
 
-        for (uint32_t doc_id : entry.second) {
-            write_uint32(doc_id);
+    for (const auto& [name, column] : columns) {
+        if (column.size() != doc_count) {
+            throw std::runtime_error("Numeric columns have different sizes");
         }
+
+        write_string(name);
+        write_uint32(column.get_bit_width());
+        write_uint32(column.get_min());
+        write_uint32(column.get_max());
+        write_padding(8);
+        file.write(reinterpret_cast<const char*>(column.packed_data()), column.packed_size());
     }
 
-    // Обновляем заголовок
-    uint64_t current_pos = get_position();
-    file.seekp(24, std::ios::beg);
-    write_uint64(inverted_offset);
-    file.seekp(current_pos, std::ios::beg);
+    add_section(SectionId::DOC_VALUES, values_offset);
+}
+
+void BinaryIndexWriter::finish() {
+    uint64_t sections_offset = get_position();
+
+    write_uint32(static_cast<uint32_t>(sections.size()));
+    for (const auto& section : sections) {
+        write_uint32(static_cast<uint32_t>(section.id));
+        write_uint64(section.offset);
+        write_uint64(section.length);
+    }
+
+    write_padding(8);
+    uint64_t checksums_offset = get_position();
+
+    file.patch(32, &sections_offset, sizeof(sections_offset));
+    file.patch(40, &checksums_offset, sizeof(checksums_offset));
+
+    // Все смещения в файле уже записаны, данные больше не меняются
+    auto block_crcs = file.block_checksums(HEADER_SIZE, checksums_offset, CHECKSUM_BLOCK_SIZE);
+    uint32_t header_crc = file.block_checksums(0, HEADER_SIZE, HEADER_SIZE)[0];
+
+    write_uint32(CHECKSUM_BLOCK_SIZE);
+    write_uint32(static_cast<uint32_t>(block_crcs.size()));
+    write_uint32(header_crc);
+    write_uint32(0);
+    file.write(block_crcs.data(), block_crcs.size() * sizeof(uint32_t));
+
+    file.commit();
+}
+
+void BinaryIndexWriter::add_section(SectionId id, uint64_t offset) {
+    sections.push_back({id, offset, get_position() - offset});
 }
 
-uint64_t BinaryIndexWriter::get_position() const {
-    return file.tellp();
+uint64_t BinaryIndexWriter::get_position() {
+    return file.position();
 }
 
 void BinaryIndexWriter::write_string(const std::string& str, bool length_first) {
@@ -122,41 +579,94 @@ void BinaryIndexWriter::write_uint64(uint64_t value) {
     file.write(reinterpret_cast<const char*>(&value), sizeof(value));
 }
 
-BinaryIndexReader::BinaryIndexReader(const std::string& filename) {
-    file.open(filename, std::ios::binary | std::ios::in);
-    if (!file) {
+void BinaryIndexWriter::write_padding(uint64_t alignment) {
+    uint64_t position = get_position();
+    while (position % alignment != 0) {
+        write_uint8(0);
+        position++;
+    }
+}
+
+void BinaryIndexWriter::write_varint(uint64_t value) {
+    while (value >= 0x80) {
+        write_uint8(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    write_uint8(static_cast<uint8_t>(value));
+}
+
+BinaryIndexReader::BinaryIndexReader(const std::string& filename, bool verify_checksums)
+    : verify_checksums(verify_checksums) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
         throw std::runtime_error("Cannot open file for reading: " + filename);
     }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot read file: " + filename);
+    }
+
+    data_size = static_cast<size_t>(st.st_size);
+    void* mapped = ::mmap(nullptr, data_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (mapped == MAP_FAILED) {
+        throw std::runtime_error("Cannot map file: " + filename);
+    }
+
+    data = static_cast<const uint8_t*>(mapped);
 }
 
 BinaryIndexReader::~BinaryIndexReader() {
-    if (file.is_open()) {
-        file.close();
+    if (data) {
+        ::munmap(const_cast<uint8_t*>(data), data_size);
     }
 }
 
 bool BinaryIndexReader::read_header(uint32_t& doc_count, uint32_t& term_count) {
-    file.seekg(0, std::ios::beg);
+    if (data_size < HEADER_SIZE) {
+        std::cerr << "Index file is too small" << std::endl;
+        return false;
+    }
 
-    uint32_t magic = read_uint32();
+    uint64_t pos = 0;
+
+    uint32_t magic = read_uint32(pos);
     if (magic != MAGIC_NUMBER) {
         std::cerr << "Invalid file format. Magic: " << std::hex << magic << std::dec << std::endl;
         return false;
     }
 
-    uint16_t version = read_uint16();
+    uint16_t version = read_uint16(pos);
     if (version != VERSION) {
         std::cerr << "Unsupported version: " << version << std::endl;
         return false;
     }
 
-    read_uint16();
-    total_docs = read_uint32();
-    total_terms = read_uint32();
-    forward_offset = read_uint64();
-    inverted_offset = read_uint64();
-    read_uint32();
-    read_uint32();
+    read_uint16(pos);
+    total_docs = read_uint32(pos);
+    total_terms = read_uint32(pos);
+    forward_offset = read_uint64(pos);
+    inverted_offset = read_uint64(pos);
+    sections_offset = read_uint64(pos);
+    checksums_offset = read_uint64(pos);
+    store_id = read_uint64(pos);
+
+    if (sections_offset == 0 || checksums_offset == 0) {
+        std::cerr << "Index file is incomplete (no section table)" << std::endl;
+        return false;
+    }
+
+    if (verify_checksums && !read_checksums()) {
+        return false;
+    }
+
+    read_dictionary_header();
+    read_kgram_header();
+    read_hot_tier_header();
+    read_frequent_terms_header();
 
     doc_count = total_docs;
     term_count = total_terms;
@@ -164,168 +674,938 @@ bool BinaryIndexReader::read_header(uint32_t& doc_count, uint32_t& term_count) {
     return true;
 }
 
-std::vector<ForwardIndexEntry> BinaryIndexReader::read_forward_index() {
+bool BinaryIndexReader::find_section(SectionId id, uint64_t& offset, uint64_t& length) const {
+    uint64_t pos = sections_offset;
+    uint32_t count = read_uint32(pos);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t section_id = read_uint32(pos);
+        uint64_t section_offset = read_uint64(pos);
+        uint64_t section_length = read_uint64(pos);
+
+        if (section_id == static_cast<uint32_t>(id)) {
+            check_range(section_offset, section_length);
+            offset = section_offset;
+            length = section_length;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void BinaryIndexReader::read_dictionary_header() {
+    uint64_t offset = 0, length = 0;
+    if (!find_section(SectionId::DICTIONARY, offset, length)) {
+        throw std::runtime_error("Dictionary section not found");
+    }
+
+    uint64_t pos = offset;
+    dict_term_count = read_uint32(pos);
+    dict_block_size = read_uint32(pos);
+    dict_block_count = read_uint32(pos);
+    read_uint32(pos);
+    dict_total_postings = read_uint64(pos);
+
+    dict_offsets_pos = offset + DICTIONARY_HEADER_SIZE;
+    dict_end_pos = offset + length;
+    dict_blocks_pos = dict_offsets_pos + uint64_t(dict_block_count) * sizeof(uint32_t);
+    check_range(dict_offsets_pos, uint64_t(dict_block_count) * sizeof(uint32_t));
+}
+
+void BinaryIndexReader::read_kgram_header() {
+    uint64_t offset = 0, length = 0;
+    kgram_count = 0;
+
+    // Индекс триграмм необязателен: без него шаблоны раскрываются перебором
+    if (!find_section(SectionId::KGRAMS, offset, length)) {
+        return;
+    }
+
+    uint64_t pos = offset;
+    kgram_count = read_uint32(pos);
+    read_uint32(pos);
+
+    kgram_table_pos = offset + KGRAM_HEADER_SIZE;
+    kgram_lists_pos = kgram_table_pos + uint64_t(kgram_count) * KGRAM_ENTRY_SIZE;
+    check_range(kgram_table_pos, uint64_t(kgram_count) * KGRAM_ENTRY_SIZE);
+}
+
+ForwardIndex BinaryIndexReader::read_forward_index() const {
     if (forward_offset == 0) {
         throw std::runtime_error("Forward index offset not set");
     }
 
-    file.seekg(forward_offset, std::ios::beg);
-    uint32_t doc_count = read_uint32();
+    if (forward_offset % sizeof(uint32_t) != 0) {
+        throw std::runtime_error("Forward index is not aligned");
+    }
+
+    uint64_t pos = forward_offset;
+    uint32_t doc_count = read_uint32(pos);
+    uint32_t field_count = read_uint32(pos);
+    uint64_t strings_size = read_uint64(pos);
+
+    if (field_count != ForwardIndex::FIELD_COUNT) {
+        throw std::runtime_error("Unsupported forward index layout");
+    }
 
-    std::vector<ForwardIndexEntry> entries;
-    entries.reserve(doc_count);
+    uint64_t offsets_pos = pos;
+    uint64_t lengths_pos = offsets_pos + (uint64_t(doc_count) * field_count + 1) * sizeof(uint32_t);
+    uint64_t strings_pos = lengths_pos + uint64_t(doc_count) * sizeof(uint32_t);
+    check_range(offsets_pos, strings_pos + strings_size - offsets_pos);
 
-    for (uint32_t i = 0; i < doc_count; ++i) {
-        ForwardIndexEntry entry;
+    const uint32_t* offsets = reinterpret_cast<const uint32_t*>(data + offsets_pos);
+    if (offsets[uint64_t(doc_count) * field_count] != strings_size) {
+        throw std::runtime_error("Forward index is corrupted");
+    }
 
-        // ID
-        entry.id = read_string(true);
+    // Документы не разбираются: колонки читаются по ID при обращении
+    return ForwardIndex::view(doc_count, offsets,
+                              reinterpret_cast<const uint32_t*>(data + lengths_pos),
+                              reinterpret_cast<const char*>(data + strings_pos),
+                              strings_size);
+}
 
-        // URL
-        entry.url = read_string(false);
+FacetIndex BinaryIndexReader::read_facets() const {
+    FacetIndex facets;
+    facets.reset(total_docs);
 
-        // Title
-        entry.title = read_string(false);
+    uint64_t offset = 0, length = 0;
+    if (!find_section(SectionId::FACETS, offset, length)) {
+        return facets;
+    }
 
-        // Document length
-        entry.doc_length = read_uint32();
+    uint64_t pos = offset;
+    uint32_t field_count = read_uint32(pos);
+    uint32_t doc_count = read_uint32(pos);
 
-        // Checksum
-        entry.checksum = read_uint32();
+    if (doc_count != total_docs) {
+        throw std::runtime_error("Facet section does not match the index");
+    }
 
-        entries.push_back(entry);
+    uint64_t word_count = (uint64_t(doc_count) + 63) / 64;
+
+    for (uint32_t f = 0; f < field_count; ++f) {
+        std::string name = read_string(pos, true);
+        uint32_t value_count = read_uint32(pos);
+
+        // Карты и списки не копируются: значения указывают в отображение
+        for (uint32_t v = 0; v < value_count; ++v) {
+            std::string value = read_string(pos, true);
+            uint8_t kind = read_uint8(pos);
+
+            if (kind == 0) {
+                pos = (pos + 7) / 8 * 8;
+                check_range(pos, word_count * sizeof(uint64_t));
+                facets.set(name, value, Bitmap::view(
+                    doc_count, reinterpret_cast<const uint64_t*>(data + pos)));
+                pos += word_count * sizeof(uint64_t);
+            } else if (kind == 1) {
+                uint32_t id_count = read_uint32(pos);
+                pos = (pos + 3) / 4 * 4;
+                check_range(pos, uint64_t(id_count) * sizeof(uint32_t));
+                facets.set(name, value, reinterpret_cast<const uint32_t*>(data + pos), id_count);
+                pos += uint64_t(id_count) * sizeof(uint32_t);
+            } else {
+                throw std::runtime_error("Malformed facet section in index file");
+            }
+        }
     }
 
-    forward_cache = entries;
-    return entries;
+    return facets;
+}
+
+std::map<std::string, NumericColumn> BinaryIndexReader::read_doc_values() const {
+    std::map<std::string, NumericColumn> columns;
+
+    uint64_t offset = 0, length = 0;
+    if (!find_section(SectionId::DOC_VALUES, offset, length)) {
+        return columns;
+    }
+
+    uint64_t pos = offset;
+    uint32_t column_count = read_uint32(pos);
+    uint32_t doc_count = read_uint32(pos);
+
+    if (column_count > 0 && doc_count != total_docs) {
+        throw std::runtime_error("Doc values section does not match the index");
+    }
+
+    for (uint32_t c = 0; c < column_count; ++c) {
+        std::string name = read_string(pos, true);
+        uint32_t bit_width = read_uint32(pos);
+        uint32_t min_value = read_uint32(pos);
+        uint32_t max_value = read_uint32(pos);
+        pos = (pos + 7) / 8 * 8;
+
+        NumericColumn column = NumericColumn::view(doc_count, bit_width, min_value, max_value,
+                                                   data + pos);
+        check_range(pos, column.packed_size());
+        pos += column.packed_size();
+
+        columns.emplace(name, std::move(column));
+    }
+
+    return columns;
 }
 
-std::vector<std::pair<std::string, std::vector<uint32_t>>> BinaryIndexReader::read_inverted_index() {
+std::vector<std::pair<std::string, std::vector<uint32_t>>> BinaryIndexReader::read_inverted_index() const {
     if (inverted_offset == 0) {
         throw std::runtime_error("Inverted index offset not set");
     }
 
-    file.seekg(inverted_offset, std::ios::beg);
-    uint32_t term_count = read_uint32();
+    uint64_t pos = inverted_offset;
+    uint32_t term_count = read_uint32(pos);
 
     std::vector<std::pair<std::string, std::vector<uint32_t>>> entries;
     entries.reserve(term_count);
 
     for (uint32_t i = 0; i < term_count; ++i) {
-        std::string term = read_string(true);
-        uint32_t doc_count = read_uint32();
-
-        std::vector<uint32_t> doc_ids;
-        doc_ids.reserve(doc_count);
+        std::string term = read_string(pos, true);
 
-        for (uint32_t j = 0; j < doc_count; ++j) {
-            doc_ids.push_back(read_uint32());
-        }
+        TermInfo info;
+        info.postings_offset = pos;
+        info.doc_freq = read_uint32(pos);
+        uint32_t ids_length = read_uint32(pos);
+        uint32_t frequencies_length = read_uint32(pos);
 
-        entries.emplace_back(term, std::move(doc_ids));
+        entries.emplace_back(term, read_postings(info));
+        pos += uint64_t(ids_length) + frequencies_length;
     }
 
     return entries;
 }
 
-std::vector<uint32_t> BinaryIndexReader::find_term(const std::string& term) {
-    // Если индекс еще не построен, строим его
-    if (term_positions.empty()) {
-        build_term_index();
-    }
+namespace {
+
+thread_local uint64_t decoded_bytes = 0;
 
-    // Бинарный поиск по термину
-    auto it = std::lower_bound(term_positions.begin(), term_positions.end(), term,
-                               [](const auto& a, const std::string& b) {
-                                   return a.first < b;
-                               });
+}  // namespace
 
-    if (it == term_positions.end() || it->first != term) {
+uint64_t BinaryIndexReader::thread_decoded_bytes() {
+    return decoded_bytes;
+}
+
+std::vector<uint32_t> BinaryIndexReader::find_term(const std::string& term) const {
+    TermInfo info;
+    if (!lookup_term(term, info)) {
         return {};  // Термин не найден
     }
 
-    file.seekg(it->second, std::ios::beg);
+    return read_postings(info);
+}
 
-    read_string(true);
-    uint32_t doc_count = read_uint32();
+template <typename List>
+void BinaryIndexReader::decode_postings(const TermInfo& info, List& doc_ids,
+                                        std::vector<uint32_t>* frequencies) const {
+    uint64_t pos = info.postings_offset;
+    uint32_t doc_count = read_uint32(pos);
+    uint32_t ids_length = read_uint32(pos);
+    uint32_t frequencies_length = read_uint32(pos);
+    check_range(pos, uint64_t(ids_length) + frequencies_length);
+
+    // Границы проверены один раз, дальше разбор идет по указателю
+    const uint8_t* ids = data + pos;
+    decoded_bytes += 12 + ids_length + (frequencies ? frequencies_length : 0);
+    doc_ids.resize(doc_count);
+    if (!decode_varints(ids, ids + ids_length, doc_count, doc_ids.data(), true)) {
+        throw std::runtime_error("Malformed postings list in index file");
+    }
 
+    if (frequencies) {
+        const uint8_t* encoded = ids + ids_length;
+        frequencies->resize(doc_count);
+        if (!decode_varints(encoded, encoded + frequencies_length, doc_count,
+                            frequencies->data(), false)) {
+            throw std::runtime_error("Malformed postings list in index file");
+        }
+    }
+}
+
+std::vector<uint32_t> BinaryIndexReader::read_postings(const TermInfo& info) const {
     std::vector<uint32_t> doc_ids;
-    doc_ids.reserve(doc_count);
+    decode_postings(info, doc_ids, nullptr);
+    return doc_ids;
+}
 
-    for (uint32_t i = 0; i < doc_count; ++i) {
-        doc_ids.push_back(read_uint32());
+void BinaryIndexReader::read_postings(const TermInfo& info,
+                                      std::pmr::vector<uint32_t>& doc_ids) const {
+    decode_postings(info, doc_ids, nullptr);
+}
+
+WeightedPostings BinaryIndexReader::read_weighted_postings(const TermInfo& info) const {
+    WeightedPostings postings;
+    decode_postings(info, postings.doc_ids, &postings.frequencies);
+    postings.doc_freq = info.doc_freq;
+    return postings;
+}
+
+void BinaryIndexReader::read_hot_tier_header() {
+    uint64_t offset = 0, length = 0;
+    hot_count = 0;
+    hot_tier_size = 0;
+
+    if (!find_section(SectionId::HOT_TIER, offset, length)) {
+        return;
     }
 
-    return doc_ids;
+    uint64_t pos = offset;
+    hot_count = read_uint32(pos);
+    hot_tier_size = read_uint32(pos);
+    hot_table_pos = pos;
+    check_range(hot_table_pos, uint64_t(hot_count) * 16);
 }
 
-ForwardIndexEntry BinaryIndexReader::get_document_info(uint32_t doc_id) {
-    if (forward_cache.empty()) {
-        read_forward_index();
+void BinaryIndexReader::read_frequent_terms_header() {
+    uint64_t offset = 0, length = 0;
+    frequent_count = 0;
+
+    if (!find_section(SectionId::FREQUENT_TERMS, offset, length)) {
+        return;
     }
 
-    if (doc_id >= forward_cache.size()) {
-        throw std::out_of_range("Document ID out of range");
+    uint64_t pos = offset;
+    frequent_count = read_uint32(pos);
+    read_uint32(pos);
+    frequent_table_pos = pos;
+    check_range(frequent_table_pos, uint64_t(frequent_count) * 16);
+}
+
+bool BinaryIndexReader::read_hot_postings(const TermInfo& info, WeightedPostings& postings) const {
+    uint32_t lo = 0, hi = hot_count;
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        uint64_t pos = hot_table_pos + uint64_t(mid) * 16;
+        uint64_t postings_offset = read_uint64(pos);
+
+        if (postings_offset < info.postings_offset) {
+            lo = mid + 1;
+        } else if (postings_offset > info.postings_offset) {
+            hi = mid;
+        } else {
+            uint64_t list_pos = read_uint64(pos);
+            pos = list_pos;
+            uint32_t count = read_uint32(pos);
+            postings.max_rest_frequency = read_uint32(pos);
+            postings.doc_freq = info.doc_freq;
+            check_range(pos, uint64_t(count) * 2 * sizeof(uint32_t));
+            decoded_bytes += 8 + uint64_t(count) * 2 * sizeof(uint32_t);
+
+            postings.doc_ids.resize(count);
+            postings.frequencies.resize(count);
+            std::memcpy(postings.doc_ids.data(), data + pos, count * sizeof(uint32_t));
+            std::memcpy(postings.frequencies.data(), data + pos + count * sizeof(uint32_t),
+                        count * sizeof(uint32_t));
+            return true;
+        }
     }
 
-    return forward_cache[doc_id];
+    return false;
 }
 
-void BinaryIndexReader::build_term_index() {
-    if (inverted_offset == 0) {
-        read_header(total_docs, total_terms);
+std::string_view BinaryIndexReader::block_first_term(uint32_t block) const {
+    uint64_t pos = dict_offsets_pos + uint64_t(block) * sizeof(uint32_t);
+    pos = dict_blocks_pos + read_uint32(pos);
+
+    read_uint8(pos);  // prefix_len, у первого термина блока всегда 0
+    uint8_t length = read_uint8(pos);
+    check_range(pos, length);
+
+    return std::string_view(reinterpret_cast<const char*>(data + pos), length);
+}
+
+uint32_t BinaryIndexReader::find_block(std::string_view term) const {
+    // Последний блок, первый термин которого <= term
+    uint32_t lo = 0, hi = dict_block_count;
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (block_first_term(mid) <= term) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
     }
+    return lo;
+}
 
-    file.seekg(inverted_offset, std::ios::beg);
-    uint32_t term_count = read_uint32();
+template<typename Callback>
+void BinaryIndexReader::scan_terms(std::string_view from, Callback&& callback) const {
+    if (dict_block_count == 0) {
+        return;
+    }
 
-    term_positions.clear();
-    term_positions.reserve(term_count);
+    uint32_t block = find_block(from);
+    uint64_t pos = dict_offsets_pos + uint64_t(block) * sizeof(uint32_t);
+    pos = dict_blocks_pos + read_uint32(pos);
 
-    for (uint32_t i = 0; i < term_count; ++i) {
-        uint64_t position = file.tellg();
-        std::string term = read_string(true);
-        term_positions.emplace_back(term, position);
+    std::string term;
+    TermInfo info;
+
+    for (uint32_t i = block * dict_block_size; i < dict_term_count; ++i) {
+        uint8_t prefix = read_uint8(pos);
+        uint8_t suffix = read_uint8(pos);
+        check_range(pos, suffix);
+
+        term.resize(prefix);
+        term.append(reinterpret_cast<const char*>(data + pos), suffix);
+        pos += suffix;
+
+        info.doc_freq = static_cast<uint32_t>(read_varint(pos));
+        uint64_t postings = read_varint(pos);
+        info.postings_offset = (i % dict_block_size == 0) ? postings
+                                                          : info.postings_offset + postings;
+
+        if (term < from) {
+            continue;
+        }
 
-        // Пропускаем данные для этого термина
-        uint32_t doc_count = read_uint32();
-        file.seekg(doc_count * sizeof(uint32_t), std::ios::cur);
+        if (!callback(term, info)) {
+            return;
+        }
     }
 }
 
-std::string BinaryIndexReader::read_string(bool length_first) {
+bool BinaryIndexReader::lookup_term(const std::string& term, TermInfo& info) const {
+    bool found = false;
+
+    scan_terms(term, [&](const std::string& current, const TermInfo& current_info) {
+        if (current == term) {
+            info = current_info;
+            found = true;
+        }
+        return false;
+    });
+
+    return found;
+}
+
+std::vector<std::pair<std::string, TermInfo>> BinaryIndexReader::terms_with_prefix(
+    const std::string& prefix, size_t limit) const {
+
+    std::vector<std::pair<std::string, TermInfo>> result;
+
+    scan_terms(prefix, [&](const std::string& term, const TermInfo& info) {
+        if (result.size() >= limit || term.compare(0, prefix.size(), prefix) != 0) {
+            return false;
+        }
+        result.emplace_back(term, info);
+        return true;
+    });
+
+    return result;
+}
+
+std::vector<std::pair<std::string, TermInfo>> BinaryIndexReader::terms_in_range(
+    const std::string& from, const std::string& to, size_t limit) const {
+
+    std::vector<std::pair<std::string, TermInfo>> result;
+
+    scan_terms(from, [&](const std::string& term, const TermInfo& info) {
+        if (result.size() >= limit || (!to.empty() && term >= to)) {
+            return false;
+        }
+        result.emplace_back(term, info);
+        return true;
+    });
+
+    return result;
+}
+
+bool BinaryIndexReader::term_at(uint32_t ordinal, std::string& term, TermInfo& info) const {
+    if (ordinal >= dict_term_count) {
+        return false;
+    }
+
+    uint32_t block = ordinal / dict_block_size;
+    uint64_t pos = dict_offsets_pos + uint64_t(block) * sizeof(uint32_t);
+    pos = dict_blocks_pos + read_uint32(pos);
+
+    term.clear();
+
+    for (uint32_t i = block * dict_block_size; i <= ordinal; ++i) {
+        uint8_t prefix = read_uint8(pos);
+        uint8_t suffix = read_uint8(pos);
+        check_range(pos, suffix);
+
+        term.resize(prefix);
+        term.append(reinterpret_cast<const char*>(data + pos), suffix);
+        pos += suffix;
+
+        info.doc_freq = static_cast<uint32_t>(read_varint(pos));
+        uint64_t postings = read_varint(pos);
+        info.postings_offset = (i % dict_block_size == 0) ? postings
+                                                          : info.postings_offset + postings;
+    }
+
+    return true;
+}
+
+uint64_t BinaryIndexReader::prefetch_dictionary() const {
+    uint64_t bytes = 0;
+    if (dict_block_count > 0) {
+        bytes += prefetch_range(dict_offsets_pos, dict_end_pos - dict_offsets_pos);
+    }
+
+    uint64_t offset = 0, length = 0;
+    if (find_section(SectionId::HOT_TIER, offset, length)) {
+        bytes += prefetch_range(offset, length);
+    }
+    return bytes;
+}
+
+uint64_t BinaryIndexReader::prefetch_frequent_postings(size_t rank) const {
+    if (rank >= frequent_count) {
+        return 0;
+    }
+
+    uint64_t pos = frequent_table_pos + uint64_t(rank) * 16;
+    uint64_t postings_offset = read_uint64(pos);
+    uint64_t postings_length = read_uint64(pos);
+    return prefetch_range(postings_offset, postings_length);
+}
+
+std::vector<uint32_t> BinaryIndexReader::kgram_ordinals(std::string_view gram) const {
+    uint32_t packed = pack_gram(gram);
+
+    uint32_t lo = 0, hi = kgram_count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        uint64_t pos = kgram_table_pos + uint64_t(mid) * KGRAM_ENTRY_SIZE;
+        uint32_t current = (uint32_t(data[pos]) << 16) | (uint32_t(data[pos + 1]) << 8) |
+                           uint32_t(data[pos + 2]);
+
+        if (current < packed) {
+            lo = mid + 1;
+        } else if (current > packed) {
+            hi = mid;
+        } else {
+            pos += 4;
+            uint32_t list_offset = read_uint32(pos);
+            uint32_t list_size = read_uint32(pos);
+
+            uint64_t list_pos = kgram_lists_pos + uint64_t(list_offset) * sizeof(uint32_t);
+            check_range(list_pos, uint64_t(list_size) * sizeof(uint32_t));
+
+            std::vector<uint32_t> ordinals(list_size);
+            std::memcpy(ordinals.data(), data + list_pos, list_size * sizeof(uint32_t));
+            return ordinals;
+        }
+    }
+
+    return {};
+}
+
+std::vector<std::pair<std::string, TermInfo>> BinaryIndexReader::terms_matching(
+    const std::string& pattern, size_t limit) const {
+
+    size_t star = pattern.find('*');
+
+    if (star == std::string::npos) {
+        TermInfo info;
+        if (limit > 0 && lookup_term(pattern, info)) {
+            return {{pattern, info}};
+        }
+        return {};
+    }
+
+    if (star == pattern.size() - 1) {
+        return terms_with_prefix(pattern.substr(0, star), limit);
+    }
+
+    std::vector<std::pair<std::string, TermInfo>> result;
+    std::vector<uint32_t> grams = pattern_grams(pattern);
+
+    if (grams.empty() || kgram_count == 0) {
+        // Слишком короткие куски шаблона: перебираем термины с общим префиксом
+        std::string prefix = pattern.substr(0, star);
+
+        scan_terms(prefix, [&](const std::string& term, const TermInfo& info) {
+            if (result.size() >= limit || term.compare(0, prefix.size(), prefix) != 0) {
+                return false;
+            }
+            if (wildcard_match(pattern, term)) {
+                result.emplace_back(term, info);
+            }
+            return true;
+        });
+
+        return result;
+    }
+
+    // Пересекаем списки триграмм, начиная с самого короткого
+    std::vector<std::vector<uint32_t>> lists;
+    lists.reserve(grams.size());
+
+    for (uint32_t gram : grams) {
+        char bytes[KGRAM_LENGTH] = {char(gram >> 16), char(gram >> 8), char(gram)};
+        lists.push_back(kgram_ordinals(std::string_view(bytes, KGRAM_LENGTH)));
+        if (lists.back().empty()) {
+            return result;
+        }
+    }
+
+    std::sort(lists.begin(), lists.end(),
+              [](const auto& a, const auto& b) { return a.size() < b.size(); });
+
+    std::vector<uint32_t> candidates = std::move(lists[0]);
+    for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+        std::vector<uint32_t> next;
+        std::set_intersection(candidates.begin(), candidates.end(),
+                              lists[i].begin(), lists[i].end(),
+                              std::back_inserter(next));
+        candidates = std::move(next);
+    }
+
+    // Триграммы дают надмножество, окончательная проверка по шаблону
+    std::string term;
+    TermInfo info;
+
+    for (uint32_t ordinal : candidates) {
+        if (result.size() >= limit) {
+            break;
+        }
+        if (term_at(ordinal, term, info) && wildcard_match(pattern, term)) {
+            result.emplace_back(term, info);
+        }
+    }
+
+    return result;
+}
+
+std::vector<std::pair<std::string, TermInfo>> BinaryIndexReader::fuzzy_terms(
+    const std::string& query, uint32_t max_edits, size_t limit) const {
+
+    /*
+     * Обход отсортированного словаря как неявного бора: строки таблицы
+     * Левенштейна для общего с предыдущим термином префикса переиспользуются,
+     * а если на глубине d минимум строки превысил max_edits, все термины
+     * с этим префиксом пропускаются переходом к следующему за ним блоку.
+     */
+    struct Candidate {
+        std::string term;
+        TermInfo info;
+        uint32_t distance;
+    };
+
+    std::vector<Candidate> candidates;
+    if (dict_block_count == 0 || limit == 0) {
+        return {};
+    }
+
+    const size_t width = query.size() + 1;
+    std::vector<uint32_t> rows(width);
+    for (size_t j = 0; j < width; ++j) {
+        rows[j] = static_cast<uint32_t>(j);
+    }
+
+    // Строки таблицы посчитаны для первых valid_rows символов term: буфер
+    // декодирования не меняет общий с предыдущим термином префикс
+    size_t valid_rows = 0;
+
+    // Пропускаем термины, начинающиеся с dead_prefix (skip_depth символов)
+    size_t skip_depth = 0;
+    std::string dead_prefix;
+
+    std::string term;
+    TermInfo info;
+    uint32_t block = 0;
+
+    while (block < dict_block_count) {
+        // Границы блока проверяются один раз, дальше разбор по указателю
+        uint64_t offset_pos = dict_offsets_pos + uint64_t(block) * sizeof(uint32_t);
+        uint64_t begin = dict_blocks_pos + read_uint32(offset_pos);
+        uint64_t end = dict_end_pos;
+        if (block + 1 < dict_block_count) {
+            end = dict_blocks_pos + read_uint32(offset_pos);
+        }
+        if (end < begin) {
+            throw std::runtime_error("Malformed dictionary block");
+        }
+        check_range(begin, end - begin);
+
+        const uint8_t* p = data + begin;
+        const uint8_t* block_end = data + end;
+
+        uint32_t first = block * dict_block_size;
+        uint32_t last = std::min(first + dict_block_size, dict_term_count);
+
+        // Начало блока хранит термин целиком
+        valid_rows = 0;
+
+        for (uint32_t i = first; i < last; ++i) {
+            if (block_end - p < 2) {
+                throw std::runtime_error("Malformed dictionary block");
+            }
+            uint8_t prefix = *p++;
+            uint8_t suffix = *p++;
+            if (block_end - p < suffix) {
+                throw std::runtime_error("Malformed dictionary block");
+            }
+
+            // Общий префикс не короче мертвого - термин можно не собирать
+            bool skip = skip_depth > 0 && i != first && prefix >= skip_depth;
+
+            if (!skip) {
+                term.resize(prefix);
+                term.append(reinterpret_cast<const char*>(p), suffix);
+            }
+            p += suffix;
+
+            // doc_freq нужен для ранжирования, смещение списка не декодируем:
+            // для отобранных терминов оно берется из словаря в конце
+            uint32_t doc_freq = 0;
+            for (int shift = 0; p < block_end; shift += 7) {
+                uint8_t byte = *p++;
+                doc_freq |= uint32_t(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) {
+                    break;
+                }
+            }
+            while (p < block_end && (*p++ & 0x80)) {
+            }
+
+            if (skip) {
+                continue;
+            }
+
+            if (skip_depth > 0) {
+                if (i == first && term.compare(0, skip_depth, dead_prefix) == 0) {
+                    continue;
+                }
+                skip_depth = 0;
+            }
+
+            valid_rows = std::min<size_t>(valid_rows, prefix);
+
+            if (rows.size() < (term.size() + 1) * width) {
+                rows.resize((term.size() + 1) * width);
+            }
+
+            size_t dead_depth = 0;
+            for (size_t d = valid_rows + 1; d <= term.size(); ++d) {
+                const uint32_t* prev = &rows[(d - 1) * width];
+                uint32_t* row = &rows[d * width];
+                const char c = term[d - 1];
+
+                row[0] = static_cast<uint32_t>(d);
+                uint32_t row_min = row[0];
+
+                for (size_t j = 1; j < width; ++j) {
+                    uint32_t best = prev[j - 1] + (c == query[j - 1] ? 0 : 1);
+                    uint32_t insert = prev[j] + 1;
+                    uint32_t remove = row[j - 1] + 1;
+                    best = insert < best ? insert : best;
+                    best = remove < best ? remove : best;
+                    row[j] = best;
+                    row_min = best < row_min ? best : row_min;
+                }
+
+                if (row_min > max_edits) {
+                    dead_depth = d;
+                    break;
+                }
+            }
+
+            if (dead_depth > 0) {
+                valid_rows = dead_depth;
+                skip_depth = dead_depth;
+                dead_prefix.assign(term, 0, dead_depth);
+                continue;
+            }
+
+            valid_rows = term.size();
+
+            uint32_t distance = rows[term.size() * width + query.size()];
+            if (distance <= max_edits) {
+                info.doc_freq = doc_freq;
+                candidates.push_back({term, info, distance});
+            }
+        }
+
+        uint32_t next = block + 1;
+
+        // Длинный пропуск - бинарным поиском по блокам
+        if (skip_depth > 0 && next + 1 < dict_block_count) {
+            std::string skip_to = dead_prefix;
+            while (!skip_to.empty() && uint8_t(skip_to.back()) == 0xFF) {
+                skip_to.pop_back();
+            }
+            if (skip_to.empty()) {
+                break;
+            }
+            skip_to.back() = static_cast<char>(uint8_t(skip_to.back()) + 1);
+
+            if (block_first_term(next + 1) <= skip_to) {
+                next = find_block(skip_to);
+            }
+        }
+
+        block = next;
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+        if (a.info.doc_freq != b.info.doc_freq) {
+            return a.info.doc_freq > b.info.doc_freq;
+        }
+        return a.distance < b.distance;
+    });
+
+    std::vector<std::pair<std::string, TermInfo>> result;
+    for (size_t i = 0; i < candidates.size() && result.size() < limit; ++i) {
+        if (lookup_term(candidates[i].term, info)) {
+            result.emplace_back(std::move(candidates[i].term), info);
+        }
+    }
+
+    return result;
+}
+
+bool BinaryIndexReader::read_checksums() {
+    uint64_t pos = checksums_offset;
+    checksum_block_size = read_uint32(pos);
+    checksum_block_count = read_uint32(pos);
+    uint32_t header_crc = read_uint32(pos);
+    read_uint32(pos);
+    checksum_table_pos = pos;
+
+    uint64_t covered = checksums_offset - HEADER_SIZE;
+    if (checksum_block_size == 0 || checksums_offset < HEADER_SIZE ||
+        checksum_block_count != (covered + checksum_block_size - 1) / checksum_block_size) {
+        std::cerr << "Invalid checksum table in index file" << std::endl;
+        return false;
+    }
+    check_range(checksum_table_pos, uint64_t(checksum_block_count) * sizeof(uint32_t));
+
+    if (crc32c(data, HEADER_SIZE) != header_crc) {
+        std::cerr << "Index header checksum mismatch" << std::endl;
+        return false;
+    }
+
+    verified_blocks = std::make_unique<std::atomic<uint8_t>[]>(checksum_block_count);
+    for (uint32_t i = 0; i < checksum_block_count; ++i) {
+        verified_blocks[i].store(0, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void BinaryIndexReader::verify_range(uint64_t pos, uint64_t length) const {
+    uint64_t end = std::min(pos + length, checksums_offset);
+    pos = std::max(pos, HEADER_SIZE);
+    if (pos >= end) {
+        return;
+    }
+
+    uint64_t first = (pos - HEADER_SIZE) / checksum_block_size;
+    uint64_t last = (end - 1 - HEADER_SIZE) / checksum_block_size;
+
+    for (uint64_t block = first; block <= last; ++block) {
+        // Повторная проверка из другого потока безопасна, просто лишняя
+        if (!verified_blocks[block].load(std::memory_order_acquire)) {
+            verify_block(block);
+        }
+    }
+}
+
+void BinaryIndexReader::verify_block(uint64_t block) const {
+    uint64_t start = HEADER_SIZE + block * checksum_block_size;
+    uint64_t size = std::min<uint64_t>(checksum_block_size, checksums_offset - start);
+
+    uint32_t expected;
+    std::memcpy(&expected, data + checksum_table_pos + block * sizeof(uint32_t), sizeof(expected));
+
+    if (crc32c(data + start, size) != expected) {
+        throw std::runtime_error("Checksum mismatch in index file at offset " +
+                                 std::to_string(start));
+    }
+
+    verified_blocks[block].store(1, std::memory_order_release);
+}
+
+void BinaryIndexReader::check_range(uint64_t pos, uint64_t length) const {
+    if (pos > data_size || length > data_size - pos) {
+        throw std::runtime_error("Unexpected end of index file");
+    }
+    if (verified_blocks) {
+        verify_range(pos, length);
+    }
+}
+
+uint64_t BinaryIndexReader::prefetch_range(uint64_t pos, uint64_t length) const {
+    if (pos >= data_size || length == 0) {
+        return 0;
+    }
+    length = std::min<uint64_t>(length, data_size - pos);
+
+    // Отображение начинается с границы страницы, адрес выравнивается вниз
+    static const uint64_t page_size = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+    uint64_t begin = pos - pos % page_size;
+    uint64_t end = pos + length;
+
+    if (::madvise(const_cast<uint8_t*>(data) + begin, end - begin, MADV_WILLNEED) != 0) {
+        return 0;
+    }
+    return end - begin;
+}
+
+std::string BinaryIndexReader::read_string(uint64_t& pos, bool length_first) const {
     size_t length = 0;
     if (length_first) {
-        length = read_uint8();
+        length = read_uint8(pos);
     } else {
-        length = read_uint16();
+        length = read_uint16(pos);
     }
 
-    std::string str(length, '\0');
-    file.read(&str[0], length);
+    check_range(pos, length);
+    std::string str(reinterpret_cast<const char*>(data + pos), length);
+    pos += length;
     return str;
 }
 
-uint32_t BinaryIndexReader::read_uint32() {
+uint32_t BinaryIndexReader::read_uint32(uint64_t& pos) const {
     uint32_t value;
-    file.read(reinterpret_cast<char*>(&value), sizeof(value));
+    check_range(pos, sizeof(value));
+    std::memcpy(&value, data + pos, sizeof(value));
+    pos += sizeof(value);
     return value;
 }
 
-uint16_t BinaryIndexReader::read_uint16() {
+uint16_t BinaryIndexReader::read_uint16(uint64_t& pos) const {
     uint16_t value;
-    file.read(reinterpret_cast<char*>(&value), sizeof(value));
+    check_range(pos, sizeof(value));
+    std::memcpy(&value, data + pos, sizeof(value));
+    pos += sizeof(value);
     return value;
 }
 
-uint8_t BinaryIndexReader::read_uint8() {
-    uint8_t value;
-    file.read(reinterpret_cast<char*>(&value), sizeof(value));
-    return value;
+uint8_t BinaryIndexReader::read_uint8(uint64_t& pos) const {
+    check_range(pos, 1);
+    return data[pos++];
 }
 
-uint64_t BinaryIndexReader::read_uint64() {
+uint64_t BinaryIndexReader::read_uint64(uint64_t& pos) const {
     uint64_t value;
-    file.read(reinterpret_cast<char*>(&value), sizeof(value));
+    check_range(pos, sizeof(value));
+    std::memcpy(&value, data + pos, sizeof(value));
+    pos += sizeof(value);
     return value;
-}
\ No newline at end of file
+}
+
+uint64_t BinaryIndexReader::read_varint(uint64_t& pos) const {
+    uint64_t value = 0;
+    int shift = 0;
+
+    while (true) {
+        uint8_t byte = read_uint8(pos);
+        value |= uint64_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+        shift += 7;
+        if (shift > 63) {
+            throw std::runtime_error("Malformed varint in index file");
+        }
+    }
+
+    return value;
+}
@@ -1,35 +1,114 @@
 #include "boolean_index.hpp"
+#include "term_matching.hpp"
+#include "metrics.hpp"
 #include <chrono>
 #include <algorithm>
 #include <iostream>
 #include <cstring>
+#include <numeric>
+#include <functional>
+#include <memory_resource>
+#include <string_view>
 
 BooleanIndexBuilder::BooleanIndexBuilder() {
 }
 
+void BooleanIndexBuilder::set_dedup_mode(DedupMode mode) {
+    dedup_mode = mode;
+}
+
+void BooleanIndexBuilder::set_document_order(DocumentOrder order) {
+    document_order = order;
+}
+
+void BooleanIndexBuilder::set_hot_tier_size(uint32_t tier_size) {
+    hot_tier_size = tier_size;
+}
+
+void BooleanIndexBuilder::set_verify_checksums(bool enabled) {
+    verify_checksums = enabled;
+}
+
 void BooleanIndexBuilder::build_from_documents(const std::vector<Document>& documents) {
-    auto start_time = std::chrono::high_resolution_clock::now();
+    begin_build(documents.size());
+
+    for (const auto& doc : documents) {
+        add_document(doc);
+    }
+
+    complete_build(&documents);
+}
+
+void BooleanIndexBuilder::begin_build(size_t expected_documents) {
+    build_start = std::chrono::high_resolution_clock::now();
 
     // Очищаем существующие данные
     forward_index.clear();
+    content_store.clear();
     inverted_index.clear();
+    posting_frequencies.clear();
+    duplicates.clear();
+    reader.reset();
 
     // Резервируем память
-    forward_index.reserve(documents.size());
+    forward_index.reserve(expected_documents);
+    facets.reset(static_cast<uint32_t>(expected_documents));
+    numeric_columns.clear();
+    numeric_columns["words"];
 
-    stats.total_documents = documents.size();
     stats.total_terms = 0;
     stats.total_postings = 0;
     stats.avg_term_length = 0.0;
     stats.avg_doc_length = 0.0;
+}
 
-    for (size_t i = 0; i < documents.size(); ++i) {
-        process_document(documents[i], static_cast<uint32_t>(i));
+void BooleanIndexBuilder::add_document(const Document& doc) {
+    uint32_t doc_id = static_cast<uint32_t>(forward_index.size());
+
+    // Число документов заранее неизвестно: карты фильтров растут вдвое
+    if (doc_id >= facets.get_doc_count()) {
+        facets.resize(std::max<uint32_t>(doc_id + 1, facets.get_doc_count() * 2));
     }
 
+    process_document(doc, doc_id);
+}
+
+void BooleanIndexBuilder::finish_build() {
+    complete_build(nullptr);
+}
+
+void BooleanIndexBuilder::complete_build(const std::vector<Document>* documents) {
+    facets.resize(static_cast<uint32_t>(forward_index.size()));
+    stats.scratch_peak_bytes = scratch.peak_bytes();
+
     // Сортируем постинги для каждого термина
     sort_and_unique_postings();
 
+    for (auto& [field, column] : numeric_columns) {
+        column.pack();
+    }
+
+    // Новый порядок документов: без удаленных дубликатов и, если нужно,
+    // отсортированный; индекс перенумеровывается один раз
+    std::vector<uint32_t> order(forward_index.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    stats.duplicate_documents = 0;
+    if (dedup_mode != DedupMode::NONE) {
+        order = remove_duplicates();
+    }
+
+    if (document_order == DocumentOrder::URL) {
+        sort_by_url(order);
+    }
+
+    if (order.size() != forward_index.size() ||
+        !std::is_sorted(order.begin(), order.end())) {
+        remap_documents(documents, order);
+    }
+
+    stats.total_documents = forward_index.size();
+
     size_t total_term_chars = 0;
     size_t total_doc_terms = 0;
 
@@ -38,8 +117,8 @@ void BooleanIndexBuilder::build_from_documents(const std::vector<Document>& docu
         stats.total_postings += postings.size();
     }
 
-    for (const auto& doc : forward_index) {
-        total_doc_terms += doc.doc_length;
+    for (uint32_t i = 0; i < forward_index.size(); ++i) {
+        total_doc_terms += forward_index.get_doc_length(i);
     }
 
     if (!inverted_index.empty()) {
@@ -51,10 +130,20 @@ void BooleanIndexBuilder::build_from_documents(const std::vector<Document>& docu
     }
 
     stats.total_terms = inverted_index.size();
+    stats.content_raw_bytes = content_store.get_raw_size();
 
     auto end_time = std::chrono::high_resolution_clock::now();
-    stats.indexing_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        end_time - start_time).count();
+    stats.indexing_time_ms = std::chrono::duration<double, std::milli>(
+        end_time - build_start).count();
+
+    auto& metrics = MetricsRegistry::global();
+    metrics.histogram("index_build_duration_seconds", "Index build time").record(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - build_start).count());
+    metrics.counter("index_build_documents_total", "Documents indexed").add(stats.total_documents);
+    if (stats.indexing_time_ms > 0) {
+        metrics.gauge("index_build_documents_per_second", "Throughput of the last index build")
+            .set(stats.total_documents * 1000.0 / stats.indexing_time_ms);
+    }
 
     std::cout << "Index built: " << stats.total_documents << " documents, "
               << stats.total_terms << " unique terms, "
@@ -62,36 +151,162 @@ void BooleanIndexBuilder::build_from_documents(const std::vector<Document>& docu
 }
 
 void BooleanIndexBuilder::process_document(const Document& doc, uint32_t doc_id) {
-    ForwardIndexEntry forward_entry;
-    forward_entry.id = doc.id;
-    forward_entry.url = doc.url;
-    forward_entry.title = doc.title;
-    forward_entry.doc_length = 0;
-    forward_entry.checksum = 0;
+    analyzer.analyze(doc.content, document_terms);
+
+    // Частоты терминов документа: узлы и корзины в арене, ключи ссылаются
+    // на буфер терминов; все освобождается сбросом арены в конце
+    ScratchArena::Scope scope(scratch);
+    std::pmr::unordered_map<std::string_view, uint32_t> term_frequencies(&scratch);
+    term_frequencies.reserve(document_terms.size());
+
+    for (const auto& term : document_terms) {
+        term_frequencies[term]++;
+    }
 
-    auto tokenization_result = tokenizer.tokenize(doc.content);
+    // Добавляем термины в обратный индекс (ключ копируется только для нового термина)
+    for (const auto& [term, freq] : term_frequencies) {
+        term_key.assign(term);
+        inverted_index[term_key].push_back(doc_id);
+        posting_frequencies[term_key].push_back(freq);
+    }
 
-    // Для каждого токена
-    std::unordered_map<std::string, uint32_t> term_frequencies;
+    forward_index.add(doc.id, doc.url, doc.title,
+                      static_cast<uint32_t>(term_frequencies.size()));
+    content_store.add(doc.content);
 
-    for (const auto& token : tokenization_result.tokens) {
-        std::string term = normalize_term(token);
+    facets.add("source", doc_id, doc.source);
+    facets.add("category", doc_id, doc.category);
 
-        if (term.length() < 2 || term.length() > 50) {
-            continue;
+    // Источник без word_count: считаем термины после анализа
+    uint32_t word_count = doc.word_count > 0 ? static_cast<uint32_t>(doc.word_count)
+                                             : static_cast<uint32_t>(document_terms.size());
+    numeric_columns["words"].add(word_count);
+
+    if (dedup_mode != DedupMode::NONE) {
+        duplicates.add(document_terms);
+    }
+}
+
+std::vector<uint32_t> BooleanIndexBuilder::remove_duplicates() {
+    auto cluster_ids = duplicates.clusters();
+
+    // Номера кластеров идут по первым документам
+    std::vector<uint32_t> representatives;
+    for (uint32_t doc_id = 0; doc_id < cluster_ids.size(); ++doc_id) {
+        if (cluster_ids[doc_id] == representatives.size()) {
+            representatives.push_back(doc_id);
         }
+    }
 
-        term_frequencies[term]++;
+    stats.duplicate_documents = cluster_ids.size() - representatives.size();
+
+    if (dedup_mode == DedupMode::DROP) {
+        return representatives;
     }
 
-    // Добавляем термины в обратный индекс
-    forward_entry.doc_length = static_cast<uint32_t>(term_frequencies.size());
+    NumericColumn& clusters = numeric_columns["cluster"];
+    clusters.clear();
+    for (uint32_t cluster_id : cluster_ids) {
+        clusters.add(cluster_id);
+    }
+    clusters.pack();
 
-    for (const auto& [term, freq] : term_frequencies) {
-        inverted_index[term].push_back(doc_id);
+    std::vector<uint32_t> all(cluster_ids.size());
+    std::iota(all.begin(), all.end(), 0);
+    return all;
+}
+
+void BooleanIndexBuilder::sort_by_url(std::vector<uint32_t>& order) const {
+    auto url_key = [](std::string_view url) {
+        size_t scheme = url.find("://");
+        if (scheme != std::string_view::npos) {
+            url.remove_prefix(scheme + 3);
+        }
+        if (url.substr(0, 4) == "www.") {
+            url.remove_prefix(4);
+        }
+        return url;
+    };
+
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return url_key(forward_index.get_url(a)) < url_key(forward_index.get_url(b));
+    });
+}
+
+void BooleanIndexBuilder::remap_documents(const std::vector<Document>* documents,
+                                          const std::vector<uint32_t>& order) {
+    const uint32_t REMOVED = UINT32_MAX;
+
+    std::vector<uint32_t> new_ids(forward_index.size(), REMOVED);
+    for (uint32_t i = 0; i < order.size(); ++i) {
+        new_ids[order[i]] = i;
+    }
+
+    forward_index.reorder(order);
+    facets.reorder(order);
+
+    for (auto& [field, column] : numeric_columns) {
+        column.reorder(order);
     }
 
-    forward_index.push_back(forward_entry);
+    // Если исходные тексты еще в памяти, хранилище собирается заново
+    // (соседние документы попадают в один блок); при потоковом построении
+    // переставляются только положения текстов в блоках
+    if (documents) {
+        content_store.clear();
+        for (uint32_t doc_id : order) {
+            content_store.add((*documents)[doc_id].content);
+        }
+    } else {
+        content_store.reorder(order);
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> remapped;
+
+    for (auto it = inverted_index.begin(); it != inverted_index.end();) {
+        auto& postings = it->second;
+        auto& frequencies = posting_frequencies[it->first];
+
+        // Частоты переставляются вместе с документами
+        remapped.clear();
+        for (size_t i = 0; i < postings.size(); ++i) {
+            if (new_ids[postings[i]] != REMOVED) {
+                remapped.emplace_back(new_ids[postings[i]], frequencies[i]);
+            }
+        }
+
+        if (remapped.empty()) {
+            posting_frequencies.erase(it->first);
+            it = inverted_index.erase(it);
+            continue;
+        }
+
+        std::sort(remapped.begin(), remapped.end());
+        postings.resize(remapped.size());
+        frequencies.resize(remapped.size());
+        for (size_t i = 0; i < remapped.size(); ++i) {
+            postings[i] = remapped[i].first;
+            frequencies[i] = remapped[i].second;
+        }
+        ++it;
+    }
+}
+
+const FacetIndex& BooleanIndexBuilder::get_facets() const {
+    return facets;
+}
+
+const NumericColumn* BooleanIndexBuilder::get_numeric_column(const std::string& field) const {
+    auto it = numeric_columns.find(field);
+    return it != numeric_columns.end() ? &it->second : nullptr;
+}
+
+bool BooleanIndexBuilder::has_content() const {
+    return !content_store.empty();
+}
+
+std::string BooleanIndexBuilder::get_content(uint32_t doc_id) const {
+    return content_store.get(doc_id);
 }
 
 std::string BooleanIndexBuilder::normalize_term(const std::string& term) {
@@ -100,83 +315,155 @@ std::string BooleanIndexBuilder::normalize_term(const std::string& term) {
                    [](unsigned char c) { return std::tolower(c); });
 
     // Применяем стемминг
-    return stemmer.stem(normalized);
+    return analyzer.normalize_token(normalized);
+}
+
+Analyzer& BooleanIndexBuilder::get_analyzer() {
+    return analyzer;
 }
 
 void BooleanIndexBuilder::sort_and_unique_postings() {
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+
     for (auto& [term, postings] : inverted_index) {
-        // Сортируем и удаляем дубликаты
-        std::sort(postings.begin(), postings.end());
-        auto last = std::unique(postings.begin(), postings.end());
-        postings.erase(last, postings.end());
+        auto& frequencies = posting_frequencies[term];
+
+        // Документы добавляются по порядку ID, обычно список уже готов
+        if (std::adjacent_find(postings.begin(), postings.end(),
+                               std::greater_equal<uint32_t>()) == postings.end()) {
+            continue;
+        }
+
+        // Сортируем и объединяем повторы, суммируя частоты
+        pairs.clear();
+        for (size_t i = 0; i < postings.size(); ++i) {
+            pairs.emplace_back(postings[i], frequencies[i]);
+        }
+        std::sort(pairs.begin(), pairs.end());
+
+        postings.clear();
+        frequencies.clear();
+        for (const auto& [doc_id, freq] : pairs) {
+            if (!postings.empty() && postings.back() == doc_id) {
+                frequencies.back() += freq;
+            } else {
+                postings.push_back(doc_id);
+                frequencies.push_back(freq);
+            }
+        }
     }
 }
 
 void BooleanIndexBuilder::save_index(const std::string& filename) {
     std::cout << "Saving index to " << filename << "..." << std::endl;
 
+    // Тексты документов - в отдельном файле рядом с индексом. Он пишется
+    // первым: новая версия индекса появляется уже вместе со своим хранилищем.
+    // Индекс хранит идентификатор хранилища, поэтому при сбое между двумя
+    // записями старый индекс не примет новое хранилище
+    content_store.save(filename + ".store");
+    stats.content_stored_bytes = content_store.get_stored_size();
+
     BinaryIndexWriter writer(filename);
 
     writer.write_header(static_cast<uint32_t>(forward_index.size()),
-                       static_cast<uint32_t>(inverted_index.size()));
-
-    std::vector<ForwardIndexEntry> forward_entries;
-    for (size_t i = 0; i < forward_index.size(); ++i) {
-        forward_entries.push_back(forward_index[i]);
-        forward_entries.back().checksum = i;
+                       static_cast<uint32_t>(inverted_index.size()),
+                       content_store.get_store_id());
+
+    writer.write_forward_index(forward_index);
+
+    // Списки передаются писателю по ссылке в порядке терминов: сортируются
+    // указатели на записи, копии списков не создаются
+    using Entry = std::pair<const std::string, std::vector<uint32_t>>;
+    std::vector<const Entry*> sorted_entries;
+    sorted_entries.reserve(inverted_index.size());
+    for (const auto& entry : inverted_index) {
+        sorted_entries.push_back(&entry);
     }
+    std::sort(sorted_entries.begin(), sorted_entries.end(),
+              [](const Entry* a, const Entry* b) { return a->first < b->first; });
 
-    writer.write_forward_index(forward_entries);
-
-    std::vector<std::pair<std::string, std::vector<uint32_t>>> inverted_entries;
-    inverted_entries.reserve(inverted_index.size());
-
-    for (const auto& [term, postings] : inverted_index) {
-        inverted_entries.emplace_back(term, postings);
+    writer.set_hot_tier_size(hot_tier_size);
+    writer.begin_inverted_index(static_cast<uint32_t>(sorted_entries.size()));
+    for (const Entry* entry : sorted_entries) {
+        writer.add_term(entry->first, entry->second, posting_frequencies.at(entry->first));
     }
-
-    writer.write_inverted_index(inverted_entries);
+    writer.end_inverted_index();
+    stats.postings_bytes = writer.get_postings_bytes();
+    writer.write_dictionary();
+    writer.write_kgram_index();
+    writer.write_facets(facets);
+    writer.write_doc_values(numeric_columns);
+    writer.write_frequent_terms();
+    if (hot_tier_size > 0) {
+        writer.write_hot_tier();
+    }
+    writer.finish();
 
     std::cout << "Index saved successfully." << std::endl;
 }
 
 bool BooleanIndexBuilder::load_index(const std::string& filename) {
     std::cout << "Loading index from " << filename << "..." << std::endl;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    auto& metrics = MetricsRegistry::global();
 
     try {
-        BinaryIndexReader reader(filename);
+        auto new_reader = std::make_unique<BinaryIndexReader>(filename, verify_checksums);
 
         uint32_t doc_count, term_count;
-        if (!reader.read_header(doc_count, term_count)) {
+        if (!new_reader->read_header(doc_count, term_count)) {
+            metrics.counter("index_load_errors_total", "Failed index loads").add();
             return false;
         }
 
-        forward_index = reader.read_forward_index();
-
-        auto inverted_entries = reader.read_inverted_index();
+        // Прямой индекс ссылается на отображенный файл и не копируется
+        forward_index = new_reader->read_forward_index();
+        facets = new_reader->read_facets();
+        numeric_columns = new_reader->read_doc_values();
 
+        // Обратный индекс не загружается: поиск идет через словарь файла
         inverted_index.clear();
-        inverted_index.reserve(inverted_entries.size());
-
-        for (auto& entry : inverted_entries) {
-            inverted_index[entry.first] = std::move(entry.second);
-        }
+        posting_frequencies.clear();
+        reader = std::move(new_reader);
 
         stats.total_documents = forward_index.size();
-        stats.total_terms = inverted_index.size();
-        stats.total_postings = 0;
+        stats.total_terms = reader->get_term_count();
+        stats.total_postings = reader->get_total_postings();
 
-        for (const auto& [term, postings] : inverted_index) {
-            stats.total_postings += postings.size();
+        stats.duplicate_documents = 0;
+        const NumericColumn* clusters = get_numeric_column("cluster");
+        if (clusters && clusters->size() > 0) {
+            stats.duplicate_documents = clusters->size() - (uint64_t(clusters->get_max()) + 1);
         }
 
+        // Без хранилища поиск работает, но без сниппетов
+        if (content_store.open(filename + ".store")) {
+            if (content_store.get_store_id() != reader->get_store_id() ||
+                content_store.size() != forward_index.size()) {
+                std::cerr << "Content store does not match the index, ignoring it" << std::endl;
+                content_store.clear();
+            }
+        }
+        stats.content_raw_bytes = content_store.get_raw_size();
+        stats.content_stored_bytes = content_store.get_stored_size();
+
         std::cout << "Index loaded: " << stats.total_documents << " documents, "
                   << stats.total_terms << " unique terms" << std::endl;
 
+        metrics.histogram("index_load_duration_seconds", "Index load time").record(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::high_resolution_clock::now() - start_time).count());
+        metrics.gauge("index_documents", "Documents in the last loaded index")
+            .set(static_cast<double>(stats.total_documents));
+        metrics.gauge("index_terms", "Unique terms in the last loaded index")
+            .set(static_cast<double>(stats.total_terms));
+
         return true;
 
     } catch (const std::exception& e) {
         std::cerr << "Error loading index: " << e.what() << std::endl;
+        metrics.counter("index_load_errors_total", "Failed index loads").add();
         return false;
     }
 }
@@ -185,7 +472,7 @@ BooleanIndexBuilder::Statistics BooleanIndexBuilder::get_statistics() const {
     return stats;
 }
 
-const std::vector<ForwardIndexEntry>& BooleanIndexBuilder::get_forward_index() const {
+const ForwardIndex& BooleanIndexBuilder::get_forward_index() const {
     return forward_index;
 }
 
@@ -193,6 +480,149 @@ const std::unordered_map<std::string, std::vector<uint32_t>>& BooleanIndexBuilde
     return inverted_index;
 }
 
+BooleanIndexBuilder::PostingsList BooleanIndexBuilder::get_postings(
+    const std::string& term, std::pmr::memory_resource* resource) const {
+
+    PostingsList postings(resource);
+
+    if (reader) {
+        TermInfo info;
+        if (reader->lookup_term(term, info)) {
+            reader->read_postings(info, postings);
+        }
+        return postings;
+    }
+
+    auto it = inverted_index.find(term);
+    if (it != inverted_index.end()) {
+        postings.assign(it->second.begin(), it->second.end());
+    }
+
+    return postings;
+}
+
+BooleanIndexBuilder::PrefetchStats BooleanIndexBuilder::prefetch_frequent_terms(
+    size_t limit, std::chrono::steady_clock::time_point deadline) const {
+
+    PrefetchStats prefetched;
+    if (!reader) {
+        return prefetched;
+    }
+
+    prefetched.bytes = reader->prefetch_dictionary();
+
+    // Положения списков записаны при построении: словарь не разбирается,
+    // и срок проверяется перед каждым списком
+    size_t count = std::min(limit, reader->get_frequent_term_count());
+    for (size_t rank = 0; rank < count; ++rank) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+        prefetched.bytes += reader->prefetch_frequent_postings(rank);
+        prefetched.terms++;
+    }
+
+    return prefetched;
+}
+
+WeightedPostings BooleanIndexBuilder::get_weighted_postings(const std::string& term,
+                                                            bool hot) const {
+    WeightedPostings postings;
+
+    if (reader) {
+        TermInfo info;
+        if (reader->lookup_term(term, info) &&
+            !(hot && reader->read_hot_postings(info, postings))) {
+            postings = reader->read_weighted_postings(info);
+        }
+        return postings;
+    }
+
+    // Индекс в памяти: верхний уровень есть только в файле
+    auto it = inverted_index.find(term);
+    if (it != inverted_index.end()) {
+        postings.doc_ids = it->second;
+        postings.frequencies = posting_frequencies.at(term);
+        postings.doc_freq = static_cast<uint32_t>(it->second.size());
+    }
+
+    return postings;
+}
+
+BooleanIndexBuilder::PostingsLists BooleanIndexBuilder::get_matching_postings(
+    const std::string& pattern, size_t limit, std::pmr::memory_resource* resource) const {
+
+    PostingsLists result(resource);
+
+    if (reader) {
+        for (const auto& [term, info] : reader->terms_matching(pattern, limit)) {
+            result.emplace_back();
+            reader->read_postings(info, result.back());
+        }
+        return result;
+    }
+
+    // Индекс в памяти не отсортирован: перебираем все термины
+    std::vector<const std::string*> terms;
+    for (const auto& [term, postings] : inverted_index) {
+        if (wildcard_match(pattern, term)) {
+            terms.push_back(&term);
+        }
+    }
+
+    std::sort(terms.begin(), terms.end(),
+              [](const auto* a, const auto* b) { return *a < *b; });
+
+    for (size_t i = 0; i < terms.size() && i < limit; ++i) {
+        const auto& postings = inverted_index.at(*terms[i]);
+        result.emplace_back(postings.begin(), postings.end());
+    }
+
+    return result;
+}
+
+std::vector<std::string> BooleanIndexBuilder::get_fuzzy_terms(
+    const std::string& term, uint32_t max_edits, size_t limit) const {
+
+    std::vector<std::string> result;
+
+    if (reader) {
+        for (auto& [candidate, info] : reader->fuzzy_terms(term, max_edits, limit)) {
+            result.push_back(std::move(candidate));
+        }
+        return result;
+    }
+
+    std::vector<std::pair<uint32_t, decltype(inverted_index)::const_iterator>> candidates;
+    for (auto it = inverted_index.begin(); it != inverted_index.end(); ++it) {
+        uint32_t distance = bounded_edit_distance(term, it->first, max_edits);
+        if (distance <= max_edits) {
+            candidates.emplace_back(distance, it);
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+        if (a.second->second.size() != b.second->second.size()) {
+            return a.second->second.size() > b.second->second.size();
+        }
+        return a.first < b.first;
+    });
+
+    for (size_t i = 0; i < candidates.size() && i < limit; ++i) {
+        result.push_back(candidates[i].second->first);
+    }
+
+    return result;
+}
+
+bool BooleanIndexBuilder::has_term(const std::string& term) const {
+    if (reader) {
+        TermInfo info;
+        return reader->lookup_term(term, info);
+    }
+    return inverted_index.count(term) > 0;
+}
+
 std::vector<std::pair<std::string, std::vector<uint32_t>>> BooleanIndexBuilder::get_sorted_entries() const {
     std::vector<std::pair<std::string, std::vector<uint32_t>>> entries;
     entries.reserve(inverted_index.size());
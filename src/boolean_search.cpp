@@ -1,11 +1,73 @@
 #include "boolean_search.hpp"
+#include "bitmap.hpp"
+#include "doc_iterator.hpp"
+#include "metrics.hpp"
 #include <chrono>
 #include <algorithm>
 #include <iostream>
 #include <cctype>
 #include <sstream>
+#include <iomanip>
+#include <queue>
+#include <functional>
+#include <cmath>
+#include <unordered_map>
 
-BooleanSearch::BooleanSearch(const BooleanIndexBuilder& index) : index(index) {
+namespace {
+
+// Операции, для которых пишется задержка по виду запроса
+enum QueryOperation { OP_SEARCH, OP_PAGE, OP_COUNT, OP_EXISTS, QUERY_OPERATIONS };
+
+struct SearchMetrics {
+    Counter& errors;
+    Counter& posting_lists;
+    Counter& postings;
+    LatencyHistogram& ranked_hot;
+    LatencyHistogram& ranked_full;
+
+    // Гистограммы регистрируются при первом запросе такого вида
+    std::atomic<LatencyHistogram*> latency[QUERY_OPERATIONS][QUERY_SHAPES] = {};
+
+    SearchMetrics()
+        : errors(MetricsRegistry::global().counter(
+              "search_query_errors_total", "Queries that failed to parse or evaluate")),
+          posting_lists(MetricsRegistry::global().counter(
+              "search_posting_lists_read_total", "Posting lists read by queries")),
+          postings(MetricsRegistry::global().counter(
+              "search_postings_read_total", "Postings read by queries")),
+          ranked_hot(MetricsRegistry::global().histogram(
+              "search_ranked_duration_seconds", "Ranked query latency by index tier",
+              "tier=\"hot\"")),
+          ranked_full(MetricsRegistry::global().histogram(
+              "search_ranked_duration_seconds", "Ranked query latency by index tier",
+              "tier=\"full\"")) {}
+
+    void record(QueryOperation operation, const QueryNode& plan,
+                std::chrono::high_resolution_clock::duration duration) {
+        static const char* const names[] = {"search", "page", "count", "exists"};
+        QueryShape shape = plan_shape(plan);
+
+        auto& slot = latency[operation][static_cast<int>(shape)];
+        LatencyHistogram* histogram = slot.load(std::memory_order_acquire);
+        if (!histogram) {
+            histogram = &MetricsRegistry::global().histogram(
+                "search_query_duration_seconds", "Query latency by operation and query shape",
+                std::string("op=\"") + names[operation] + "\",shape=\"" + shape_name(shape) + "\"");
+            slot.store(histogram, std::memory_order_release);
+        }
+        histogram->record(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    }
+};
+
+SearchMetrics& search_metrics() {
+    static SearchMetrics metrics;
+    return metrics;
+}
+
+}  // namespace
+
+BooleanSearch::BooleanSearch(const BooleanIndexBuilder& index)
+    : index(index), highlighter(analyzer) {
     init_all_documents();
 }
 
@@ -20,27 +82,818 @@ void BooleanSearch::init_all_documents() {
 
 std::vector<uint32_t> BooleanSearch::search(const std::string& query) {
     auto start_time = std::chrono::high_resolution_clock::now();
+    ScratchArena::Scope scope(scratch);
+
+    // С журналом медленных запросов профиль узлов собирается всегда:
+    // медленный запрос становится известен только в конце
+    QueryProfile profile;
+    profiling = query_log && !nested_search;
 
     try {
-        auto tokens = tokenize_query(query);
+        size_t token_count = 0;
+        auto plan = parse_query(query, token_count);
+        auto parsed_time = std::chrono::high_resolution_clock::now();
 
-        size_t pos = 0;
-        auto result = parse_expression(tokens, pos);
+        ScratchList storage(&scratch);
+        auto matches = evaluate_plan(*plan, storage, profiling ? &profile.root : nullptr);
+        std::vector<uint32_t> result(matches.begin(), matches.end());
+        collapse_clusters(result);
 
         auto end_time = std::chrono::high_resolution_clock::now();
 
+        if (profiling) {
+            profiling = false;
+            log_query(query, *plan, profile, result.size(), parsed_time - start_time,
+                      end_time - parsed_time);
+        }
+
         last_stats.query = query;
         last_stats.result_count = result.size();
-        last_stats.processing_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        last_stats.processing_time_ms = std::chrono::duration<double, std::milli>(
             end_time - start_time).count();
-        last_stats.terms_processed = tokens.size();
+        last_stats.terms_processed = token_count;
+        last_stats.terms_expanded = expanded_terms;
+        last_stats.scratch_bytes = scratch.used_bytes();
+
+        if (record_metrics && !nested_search) {
+            search_metrics().record(OP_SEARCH, *plan, end_time - start_time);
+        }
 
         return result;
 
+    } catch (const std::exception& e) {
+        profiling = false;
+        std::cerr << "Search error: " << e.what() << std::endl;
+        if (record_metrics) {
+            search_metrics().errors.add();
+        }
+        return {};
+    }
+}
+
+void BooleanSearch::log_query(const std::string& query, const QueryNode& plan,
+                              QueryProfile& profile, size_t result_count,
+                              std::chrono::nanoseconds parse_time,
+                              std::chrono::nanoseconds eval_time) {
+    uint64_t total_ns = (parse_time + eval_time).count();
+    auto reason = query_log->classify(total_ns);
+    if (reason == SlowQueryLog::Reason::NONE) {
+        return;
+    }
+
+    profile.query = query;
+    profile.plan = plan_to_string(plan);
+    profile.result_count = result_count;
+    profile.parse_ns = parse_time.count();
+    profile.eval_ns = eval_time.count();
+    profile.total_ns = total_ns;
+    query_log->submit(reason, std::move(profile));
+}
+
+std::vector<BooleanSearch::RankedDoc> BooleanSearch::search_ranked(const std::string& query,
+                                                                   size_t k) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    ScratchArena::Scope scope(scratch);
+    std::vector<RankedDoc> ranked;
+
+    try {
+        expanded_terms = 0;
+        auto tokens = tokenize_query(query);
+
+        last_stats.full_tier_used = !rank_hot_tier(tokens, k, ranked);
+        if (last_stats.full_tier_used) {
+            nested_search = true;
+            auto doc_ids = search(query);
+            nested_search = false;
+            ranked = rank_results(doc_ids, highlight_terms(tokens), k);
+        }
+
+        auto end_time = std::chrono::high_resolution_clock::now();
+
+        last_stats.query = query;
+        last_stats.result_count = ranked.size();
+        last_stats.processing_time_ms = std::chrono::duration<double, std::milli>(
+            end_time - start_time).count();
+        last_stats.terms_processed = tokens.size() - 1;
+        last_stats.terms_expanded = expanded_terms;
+        last_stats.scratch_bytes = scratch.used_bytes();
+
+        if (record_metrics) {
+            auto& metrics = search_metrics();
+            (last_stats.full_tier_used ? metrics.ranked_full : metrics.ranked_hot).record(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count());
+        }
+
     } catch (const std::exception& e) {
         std::cerr << "Search error: " << e.what() << std::endl;
+        if (record_metrics) {
+            search_metrics().errors.add();
+        }
         return {};
     }
+
+    return ranked;
+}
+
+double BooleanSearch::term_weight(uint32_t frequency, uint32_t doc_freq) const {
+    double idf = std::log(1.0 + double(all_documents.size()) / std::max<uint32_t>(doc_freq, 1));
+    return (1.0 + std::log(double(std::max<uint32_t>(frequency, 1)))) * idf;
+}
+
+bool BooleanSearch::rank_hot_tier(const std::vector<QueryToken>& tokens, size_t k,
+                                  std::vector<RankedDoc>& ranked) {
+    // Свернутые дубликаты меняют выдачу - считаем по полному пути
+    if (k == 0 || collapse_column()) {
+        return false;
+    }
+
+    // Только простые термины через AND (или пробел) либо только через OR
+    size_t term_tokens = 0, and_count = 0, or_count = 0;
+    bool compound = false;
+
+    for (const auto& token : tokens) {
+        if (token.type == TokenType::END) {
+            break;
+        }
+        if (token.type == TokenType::AND || token.type == TokenType::OR) {
+            ++(token.type == TokenType::AND ? and_count : or_count);
+            continue;
+        }
+        if (token.type != TokenType::TERM || token.value.find_first_of("*~") != std::string::npos ||
+            is_filter_term(token.value)) {
+            return false;
+        }
+        // Исправление опечатки (--fuzzy) раскрывается в несколько терминов
+        for (const auto& term : token.terms) {
+            if (fuzzy_fallback && !index.has_term(term)) {
+                return false;
+            }
+        }
+
+        ++term_tokens;
+        compound = compound || token.terms.size() > 1;
+    }
+
+    // Те же термины, что берет полный путь (rank_results)
+    auto terms = highlight_terms(tokens);
+
+    // OR без неявных AND (пробелов) и без составных слов (они пересекаются)
+    bool or_mode = or_count > 0;
+    if (terms.empty() || (or_mode && (and_count > 0 || compound || or_count + 1 != term_tokens))) {
+        return false;
+    }
+
+    std::vector<WeightedPostings> lists;
+    for (const auto& term : terms) {
+        lists.push_back(index.get_weighted_postings(term, true));
+        // Для пустого списка возможна замена опечатки - это полный путь
+        if (lists.back().doc_ids.empty() && fuzzy_fallback) {
+            return false;
+        }
+    }
+
+    // Граница веса документов вне списка верхнего уровня
+    std::pmr::vector<double> rest_bound(lists.size(), 0.0, &scratch);
+    bool any_complete = false;
+    double unseen_bound = 0.0;
+
+    for (size_t i = 0; i < lists.size(); ++i) {
+        if (lists[i].max_rest_frequency == 0) {
+            any_complete = true;
+        } else {
+            rest_bound[i] = term_weight(lists[i].max_rest_frequency, lists[i].doc_freq);
+            unseen_bound += rest_bound[i];
+        }
+    }
+
+    // Документ вне всех списков: в AND он не проходит, если хоть один список полный
+    bool unseen_possible = unseen_bound > 0.0 && (or_mode || !any_complete);
+
+    // Маска списков, в которых встретился документ
+    if (lists.size() > 64) {
+        return false;
+    }
+
+    struct Candidate {
+        double score = 0.0;
+        uint64_t seen_mask = 0;
+    };
+
+    std::pmr::unordered_map<uint32_t, Candidate> candidates(&scratch);
+    for (size_t i = 0; i < lists.size(); ++i) {
+        for (size_t j = 0; j < lists[i].doc_ids.size(); ++j) {
+            auto& candidate = candidates[lists[i].doc_ids[j]];
+            candidate.score += term_weight(lists[i].frequencies[j], lists[i].doc_freq);
+            candidate.seen_mask |= uint64_t(1) << i;
+        }
+    }
+
+    std::pmr::vector<RankedDoc> exact(&scratch);
+    std::pmr::vector<double> partial_bounds(&scratch);
+
+    for (const auto& [doc_id, candidate] : candidates) {
+        double upper = candidate.score;
+        bool complete = true;
+        bool excluded = false;
+
+        for (size_t i = 0; i < lists.size(); ++i) {
+            if (candidate.seen_mask & (uint64_t(1) << i)) {
+                continue;
+            }
+            if (lists[i].max_rest_frequency == 0) {
+                // Полный список без документа: в AND документ не подходит
+                excluded = excluded || !or_mode;
+            } else {
+                upper += rest_bound[i];
+                complete = false;
+            }
+        }
+
+        if (excluded) {
+            continue;
+        }
+        if (complete) {
+            exact.push_back({doc_id, candidate.score});
+        } else {
+            partial_bounds.push_back(upper);
+        }
+    }
+
+    auto better = [](const RankedDoc& a, const RankedDoc& b) {
+        return a.score != b.score ? a.score > b.score : a.doc_id < b.doc_id;
+    };
+
+    size_t top = std::min(k, exact.size());
+    std::partial_sort(exact.begin(), exact.begin() + top, exact.end(), better);
+    exact.resize(top);
+
+    // Меньше k точных документов - гарантия только если других совпадений нет
+    if (top < k) {
+        if (!partial_bounds.empty() || unseen_possible) {
+            return false;
+        }
+        ranked.assign(exact.begin(), exact.end());
+        return true;
+    }
+
+    // Никакой другой документ не может обогнать или сравняться с k-м
+    double threshold = exact.back().score;
+    if (unseen_possible && unseen_bound >= threshold) {
+        return false;
+    }
+    for (double upper : partial_bounds) {
+        if (upper >= threshold) {
+            return false;
+        }
+    }
+
+    ranked.assign(exact.begin(), exact.end());
+    return true;
+}
+
+std::vector<BooleanSearch::RankedDoc> BooleanSearch::rank_results(
+    const std::vector<uint32_t>& doc_ids, const std::vector<std::string>& terms, size_t k) {
+
+    std::vector<RankedDoc> ranked;
+    ranked.reserve(doc_ids.size());
+    for (uint32_t doc_id : doc_ids) {
+        ranked.push_back({doc_id, 0.0});
+    }
+
+    // Результат отсортирован по ID (при сворачивании дубликатов тоже),
+    // поэтому веса добавляются слиянием с полным списком термина
+    for (const auto& term : terms) {
+        auto postings = index.get_weighted_postings(term, false);
+
+        size_t j = 0;
+        for (auto& doc : ranked) {
+            while (j < postings.doc_ids.size() && postings.doc_ids[j] < doc.doc_id) {
+                ++j;
+            }
+            if (j == postings.doc_ids.size()) {
+                break;
+            }
+            if (postings.doc_ids[j] == doc.doc_id) {
+                doc.score += term_weight(postings.frequencies[j], postings.doc_freq);
+            }
+        }
+    }
+
+    size_t top = std::min(k, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + top, ranked.end(),
+                      [](const RankedDoc& a, const RankedDoc& b) {
+                          return a.score != b.score ? a.score > b.score : a.doc_id < b.doc_id;
+                      });
+    ranked.resize(top);
+    return ranked;
+}
+
+BooleanSearch::Page BooleanSearch::search_page(const std::string& query,
+                                               const std::string& cursor,
+                                               size_t limit) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    ScratchArena::Scope scope(scratch);
+    Page page;
+
+    try {
+        size_t token_count = 0;
+        uint64_t fingerprint = 0;
+        auto plan = parse_query(query, token_count, &fingerprint);
+        uint32_t start = cursor.empty() ? 0 : decode_cursor(cursor, fingerprint);
+
+        if (collapse_column()) {
+            // Документ скрыт, если раньше в выдаче есть документ его кластера,
+            // в том числе на прошлых страницах: сворачивается вся выдача
+            ScratchList storage(&scratch);
+            auto matches = evaluate_plan(*plan, storage);
+            std::vector<uint32_t> results(matches.begin(), matches.end());
+            collapse_clusters(results);
+            page = slice_page(results, fingerprint, start, limit);
+        } else {
+            // Продолжаем обход итераторов с документа после последнего показанного
+            auto iterator = make_iterator(*plan, static_cast<uint32_t>(all_documents.size()));
+
+            uint32_t doc = iterator->advance(start);
+            while (doc != DocIterator::END && page.doc_ids.size() < limit) {
+                page.doc_ids.push_back(doc);
+                doc = iterator->next();
+            }
+
+            if (doc != DocIterator::END && !page.doc_ids.empty()) {
+                page.next_cursor = encode_cursor(fingerprint, page.doc_ids.back());
+            }
+        }
+
+        auto end_time = std::chrono::high_resolution_clock::now();
+
+        last_stats.query = query;
+        last_stats.result_count = page.doc_ids.size();
+        last_stats.processing_time_ms = std::chrono::duration<double, std::milli>(
+            end_time - start_time).count();
+        last_stats.terms_processed = token_count;
+        last_stats.terms_expanded = expanded_terms;
+
+        if (record_metrics) {
+            search_metrics().record(OP_PAGE, *plan, end_time - start_time);
+        }
+
+    } catch (const std::exception& e) {
+        std::cerr << "Search error: " << e.what() << std::endl;
+        if (record_metrics) {
+            search_metrics().errors.add();
+        }
+        return {};
+    }
+
+    return page;
+}
+
+BooleanSearch::Page BooleanSearch::slice_page(const std::vector<uint32_t>& results,
+                                              uint64_t fingerprint, uint32_t start,
+                                              size_t limit) {
+    Page page;
+    auto first = std::lower_bound(results.begin(), results.end(), start);
+    auto last = first + std::min<size_t>(limit, results.end() - first);
+    page.doc_ids.assign(first, last);
+
+    if (last != results.end() && !page.doc_ids.empty()) {
+        page.next_cursor = encode_cursor(fingerprint, page.doc_ids.back());
+    }
+    return page;
+}
+
+size_t BooleanSearch::count(const std::string& query) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    ScratchArena::Scope scope(scratch);
+
+    try {
+        size_t token_count = 0;
+        auto plan = parse_query(query, token_count);
+
+        // Со сверткой считаются кластеры, как в выдаче search_page
+        size_t result = 0;
+        if (const NumericColumn* clusters = collapse_column()) {
+            ScratchList storage(&scratch);
+            result = collapsed_matches(evaluate_plan(*plan, storage), *clusters).count();
+        } else {
+            result = count_plan(*plan);
+        }
+
+        auto end_time = std::chrono::high_resolution_clock::now();
+
+        last_stats.query = query;
+        last_stats.result_count = result;
+        last_stats.processing_time_ms = std::chrono::duration<double, std::milli>(
+            end_time - start_time).count();
+        last_stats.terms_processed = token_count;
+        last_stats.terms_expanded = expanded_terms;
+
+        if (record_metrics) {
+            search_metrics().record(OP_COUNT, *plan, end_time - start_time);
+        }
+
+        return result;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Search error: " << e.what() << std::endl;
+        if (record_metrics) {
+            search_metrics().errors.add();
+        }
+        return 0;
+    }
+}
+
+bool BooleanSearch::exists(const std::string& query) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    ScratchArena::Scope scope(scratch);
+
+    try {
+        size_t token_count = 0;
+        auto plan = parse_query(query, token_count);
+
+        // Итераторы останавливаются на первом документе. Свертка не
+        // влияет: первый документ каждого кластера остается в выдаче
+        bool found = !plan->postings.empty();
+        if (plan->type != QueryNode::Type::TERM) {
+            auto iterator = make_iterator(*plan, static_cast<uint32_t>(all_documents.size()));
+            found = iterator->next() != DocIterator::END;
+        }
+
+        if (record_metrics) {
+            search_metrics().record(OP_EXISTS, *plan,
+                                    std::chrono::high_resolution_clock::now() - start_time);
+        }
+        return found;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Search error: " << e.what() << std::endl;
+        if (record_metrics) {
+            search_metrics().errors.add();
+        }
+        return false;
+    }
+}
+
+std::map<std::string, std::vector<BooleanSearch::FacetCount>> BooleanSearch::facet_counts(
+    const std::string& query) {
+
+    ScratchArena::Scope scope(scratch);
+    std::map<std::string, std::vector<FacetCount>> result;
+
+    try {
+        size_t token_count = 0;
+        auto plan = parse_query(query, token_count);
+
+        // Результат - одна битовая карта, счетчики - popcount пересечений.
+        // Со сверткой в карте только показанные документы
+        Bitmap matches;
+        if (const NumericColumn* clusters = collapse_column()) {
+            ScratchList storage(&scratch);
+            matches = collapsed_matches(evaluate_plan(*plan, storage), *clusters);
+        } else {
+            matches = evaluate_bitmap(*plan);
+        }
+        const auto& facets = index.get_facets();
+
+        for (const auto& field : FacetIndex::field_names()) {
+            auto& counts = result[field];
+
+            for (const auto& [value, facet] : facets.values(field)) {
+                size_t count = 0;
+                if (facet.bitmap) {
+                    count = matches.count_and(*facet.bitmap);
+                } else {
+                    for (uint32_t i = 0; i < facet.id_count; ++i) {
+                        count += matches.test(facet.doc_ids[i]);
+                    }
+                }
+                if (count > 0) {
+                    counts.push_back({value, count});
+                }
+            }
+
+            std::sort(counts.begin(), counts.end(), [](const auto& a, const auto& b) {
+                return a.count != b.count ? a.count > b.count : a.value < b.value;
+            });
+        }
+
+    } catch (const std::exception& e) {
+        std::cerr << "Search error: " << e.what() << std::endl;
+        if (record_metrics) {
+            search_metrics().errors.add();
+        }
+    }
+
+    return result;
+}
+
+size_t BooleanSearch::count_plan(const QueryNode& node) {
+    size_t doc_count = all_documents.size();
+
+    switch (node.type) {
+        case QueryNode::Type::TERM:
+            return node.postings.size();
+
+        case QueryNode::Type::FILTER:
+            return node.filter ? node.filter->count() : node.postings.size();
+
+        case QueryNode::Type::NOT:
+            return doc_count - count_plan(*node.children[0]);
+
+        case QueryNode::Type::AND:
+        case QueryNode::Type::OR:
+            break;
+    }
+
+    // !A & !B = N - |A | B|
+    if (node.type == QueryNode::Type::AND && node.children.size() == 2 &&
+        node.children[0]->type == QueryNode::Type::NOT &&
+        node.children[1]->type == QueryNode::Type::NOT &&
+        node.children[0]->children[0]->type == QueryNode::Type::TERM &&
+        node.children[1]->children[0]->type == QueryNode::Type::TERM) {
+        const auto& a = node.children[0]->children[0]->postings;
+        const auto& b = node.children[1]->children[0]->postings;
+        return doc_count - (a.size() + b.size() - count_intersection(a, b));
+    }
+
+    // Частые случаи из двух терминов: |A & B|, |A | B|, |A & !B|
+    if (node.children.size() == 2 && node.children[0]->type == QueryNode::Type::TERM) {
+        const auto& a = node.children[0]->postings;
+        const QueryNode& right = *node.children[1];
+
+        if (right.type == QueryNode::Type::TERM) {
+            size_t common = count_intersection(a, right.postings);
+            return node.type == QueryNode::Type::AND
+                ? common
+                : a.size() + right.postings.size() - common;
+        }
+
+        if (node.type == QueryNode::Type::AND && right.type == QueryNode::Type::NOT &&
+            right.children[0]->type == QueryNode::Type::TERM) {
+            return a.size() - count_intersection(a, right.children[0]->postings);
+        }
+    }
+
+    // Редкие пересечения выгоднее пройти итераторами, плотные - битовыми картами
+    auto iterator = make_iterator(node, static_cast<uint32_t>(doc_count));
+    if (node.type == QueryNode::Type::AND && iterator->cost() * 32 < doc_count) {
+        size_t result = 0;
+        while (iterator->next() != DocIterator::END) {
+            result++;
+        }
+        return result;
+    }
+
+    return evaluate_bitmap(node).count();
+}
+
+Bitmap BooleanSearch::evaluate_bitmap(const QueryNode& node) {
+    Bitmap result(all_documents.size());
+
+    switch (node.type) {
+        case QueryNode::Type::TERM:
+            result.set_all(node.postings);
+            break;
+
+        case QueryNode::Type::FILTER:
+            if (node.filter) {
+                result = *node.filter;
+            } else {
+                result.set_all(node.postings);
+            }
+            break;
+
+        case QueryNode::Type::NOT:
+            result = evaluate_bitmap(*node.children[0]);
+            result.flip();
+            break;
+
+        case QueryNode::Type::OR:
+            for (const auto& child : node.children) {
+                if (child->type == QueryNode::Type::TERM) {
+                    result.set_all(child->postings);
+                } else {
+                    result.or_with(evaluate_bitmap(*child));
+                }
+            }
+            break;
+
+        case QueryNode::Type::AND: {
+            bool first = true;
+            for (const auto& child : node.children) {
+                if (child->type == QueryNode::Type::NOT) {
+                    continue;
+                }
+                if (first) {
+                    result = evaluate_bitmap(*child);
+                    first = false;
+                } else {
+                    result.and_with(evaluate_bitmap(*child));
+                }
+            }
+
+            if (first) {
+                result.flip();  // Только отрицания: начинаем со всех документов
+            }
+
+            for (const auto& child : node.children) {
+                if (child->type == QueryNode::Type::NOT) {
+                    result.and_not(evaluate_bitmap(*child->children[0]));
+                }
+            }
+            break;
+        }
+    }
+
+    return result;
+}
+
+size_t BooleanSearch::count_intersection(ListView a, ListView b) {
+    const auto& small = a.size() <= b.size() ? a : b;
+    const auto& large = a.size() <= b.size() ? b : a;
+    size_t result = 0;
+
+    // Сильно разные по длине списки - бинарным поиском по длинному
+    if (small.size() * 16 < large.size()) {
+        auto it = large.begin();
+        for (uint32_t doc_id : small) {
+            it = std::lower_bound(it, large.end(), doc_id);
+            if (it == large.end()) {
+                break;
+            }
+            if (*it == doc_id) {
+                result++;
+            }
+        }
+        return result;
+    }
+
+    size_t i = 0, j = 0;
+    while (i < small.size() && j < large.size()) {
+        if (small[i] == large[j]) {
+            result++;
+            i++;
+            j++;
+        } else if (small[i] < large[j]) {
+            i++;
+        } else {
+            j++;
+        }
+    }
+
+    return result;
+}
+
+uint64_t BooleanSearch::query_fingerprint(const std::vector<QueryToken>& tokens) const {
+    // FNV-1a от типов токенов и терминов после анализатора: пробелы
+    // и регистр запроса на отпечаток не влияют
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](unsigned char c) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    };
+
+    for (const auto& token : tokens) {
+        mix(static_cast<unsigned char>(token.type));
+        if (token.analyzed) {
+            for (const auto& term : token.terms) {
+                for (unsigned char c : term) {
+                    mix(c);
+                }
+                mix(0);
+            }
+        } else {
+            for (unsigned char c : token.value) {
+                mix(c);
+            }
+        }
+        mix(0xFF);
+    }
+
+    // Курсор другого индекса не принимаем
+    return hash ^ (uint64_t(all_documents.size()) * 0x9E3779B97F4A7C15ULL);
+}
+
+std::string BooleanSearch::encode_cursor(uint64_t fingerprint, uint32_t last_doc) {
+    std::ostringstream out;
+    out << std::hex << std::setw(16) << std::setfill('0') << fingerprint
+        << ':' << last_doc;
+    return out.str();
+}
+
+uint32_t BooleanSearch::decode_cursor(const std::string& cursor, uint64_t fingerprint) {
+    size_t colon = cursor.find(':');
+    if (colon != 16 || colon + 1 >= cursor.size()) {
+        throw std::runtime_error("Invalid cursor");
+    }
+
+    uint64_t cursor_fingerprint = 0;
+    uint64_t last_doc = 0;
+    try {
+        size_t parsed = 0;
+        cursor_fingerprint = std::stoull(cursor.substr(0, colon), &parsed, 16);
+        last_doc = std::stoull(cursor.substr(colon + 1), &parsed, 16);
+        if (parsed != cursor.size() - colon - 1) {
+            throw std::runtime_error("Invalid cursor");
+        }
+    } catch (const std::logic_error&) {
+        throw std::runtime_error("Invalid cursor");
+    }
+
+    if (cursor_fingerprint != fingerprint) {
+        throw std::runtime_error("Cursor does not match the query");
+    }
+
+    if (last_doc >= DocIterator::END) {
+        throw std::runtime_error("Invalid cursor");
+    }
+
+    return static_cast<uint32_t>(last_doc) + 1;
+}
+
+QueryPlan BooleanSearch::parse_query(const std::string& query, size_t& token_count,
+                                     uint64_t* fingerprint) {
+    expanded_terms = 0;
+    auto tokens = tokenize_query(query);
+    token_count = tokens.size();
+    if (fingerprint) {
+        *fingerprint = query_fingerprint(tokens);
+    }
+
+    // Остался только END: запрос из одних стоп-слов ("the", "!the",
+    // "(the)"). Они не индексируются, результат пустой
+    if (tokens.size() == 1) {
+        return std::make_unique<QueryNode>(QueryNode::Type::TERM);
+    }
+
+    size_t pos = 0;
+    return parse_expression(tokens, pos);
+}
+
+BooleanSearch::ListView BooleanSearch::evaluate_plan(const QueryNode& node, ScratchList& storage,
+                                                     QueryProfile::Node* profile) {
+    if (profile) {
+        static const char* const names[] = {"TERM", "FILTER", "AND", "OR", "NOT"};
+        profile->operation = names[static_cast<int>(node.type)];
+        profile->label = node.label;
+        profile->lists_read = node.fetch.lists;
+        profile->postings_read = node.fetch.postings;
+        profile->bytes_decoded = node.fetch.bytes_decoded;
+        profile->fetch_ns = node.fetch.ns;
+        profile->children.resize(node.children.size());
+    }
+
+    auto start_time = profile ? std::chrono::steady_clock::now()
+                              : std::chrono::steady_clock::time_point();
+    auto child = [&](size_t i, ScratchList& list) {
+        return evaluate_plan(*node.children[i], list, profile ? &profile->children[i] : nullptr);
+    };
+
+    ListView result;
+    switch (node.type) {
+        case QueryNode::Type::TERM:
+            result = node.postings;
+            break;
+
+        case QueryNode::Type::FILTER:
+            if (node.filter) {
+                storage.clear();
+                node.filter->append_to(storage);
+                result = storage;
+            } else {
+                result = node.postings;
+            }
+            break;
+
+        case QueryNode::Type::NOT: {
+            ScratchList operand(&scratch);
+            storage = complement_set(child(0, operand));
+            result = storage;
+            break;
+        }
+
+        case QueryNode::Type::OR:
+        case QueryNode::Type::AND: {
+            // Накопленный результат - в storage, только пока он не лист
+            ScratchList operand(&scratch);
+            result = child(0, storage);
+            for (size_t i = 1; i < node.children.size(); ++i) {
+                ListView next = child(i, operand);
+                storage = node.type == QueryNode::Type::AND
+                              ? intersect_sets(result, next, profile ? &profile->skips : nullptr)
+                              : union_sets(result, next);
+                result = storage;
+            }
+            break;
+        }
+    }
+
+    if (profile) {
+        profile->output_size = result.size();
+        profile->eval_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_time).count();
+    }
+    return result;
 }
 
 std::vector<BooleanSearch::QueryToken> BooleanSearch::tokenize_query(const std::string& query) {
@@ -90,6 +943,14 @@ std::vector<BooleanSearch::QueryToken> BooleanSearch::tokenize_query(const std::
             }
             tokens.emplace_back(TokenType::OR);
             i++;
+        } else if (c == '[' && !current_term.empty() && current_term.back() == ':') {
+            // Диапазон words:[500 TO 2000] - один токен вместе с пробелами
+            size_t close = query.find(']', i);
+            if (close == std::string::npos) {
+                throw std::runtime_error("Missing ']' in range query");
+            }
+            current_term += query.substr(i, close - i + 1);
+            i = close;
         } else {
             current_term += c;
         }
@@ -99,14 +960,67 @@ std::vector<BooleanSearch::QueryToken> BooleanSearch::tokenize_query(const std::
         tokens.emplace_back(TokenType::TERM, current_term);
     }
 
+    drop_stop_terms(tokens);
+
     // Добавляем END токен
     tokens.emplace_back(TokenType::END);
 
     return tokens;
 }
 
-std::vector<uint32_t> BooleanSearch::parse_expression(const std::vector<QueryToken>& tokens,
-                                                      size_t& pos) {
+void BooleanSearch::drop_stop_terms(std::vector<QueryToken>& tokens) {
+    // Стоп-слова не попадают в индекс, поэтому убираем их из запроса
+    // вместе с относящимися к ним операторами. Опустевшие скобки
+    // убираются так же, как выброшенный термин. Термины анализируются
+    // здесь один раз, результат остается в токене
+    std::vector<QueryToken> result;
+    result.reserve(tokens.size());
+
+    auto drop_operand = [&](size_t& i) {
+        while (!result.empty() && result.back().type == TokenType::NOT) {
+            result.pop_back();
+        }
+
+        if (!result.empty() && (result.back().type == TokenType::AND ||
+                                result.back().type == TokenType::OR)) {
+            result.pop_back();
+        } else if (i + 1 < tokens.size() && (tokens[i + 1].type == TokenType::AND ||
+                                             tokens[i + 1].type == TokenType::OR)) {
+            i++;
+        }
+    };
+
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        auto& token = tokens[i];
+
+        if (token.type == TokenType::RPAREN && !result.empty() &&
+            result.back().type == TokenType::LPAREN) {
+            result.pop_back();
+            drop_operand(i);
+            continue;
+        }
+
+        bool plain = token.type == TokenType::TERM &&
+                     token.value.find_first_of("*~") == std::string::npos &&
+                     !is_filter_term(token.value);
+
+        if (plain) {
+            token.terms = analyzer.analyze_query_term(token.value);
+            token.analyzed = true;
+        }
+
+        if (!plain || !token.terms.empty()) {
+            result.push_back(std::move(token));
+            continue;
+        }
+
+        drop_operand(i);
+    }
+
+    tokens = std::move(result);
+}
+
+QueryPlan BooleanSearch::parse_expression(const std::vector<QueryToken>& tokens, size_t& pos) {
     auto left = parse_term(tokens, pos);
 
     while (pos < tokens.size()) {
@@ -114,8 +1028,7 @@ std::vector<uint32_t> BooleanSearch::parse_expression(const std::vector<QueryTok
 
         if (token.type == TokenType::OR) {
             pos++;
-            auto right = parse_term(tokens, pos);
-            left = union_sets(left, right);
+            left = combine(QueryNode::Type::OR, std::move(left), parse_term(tokens, pos));
         } else {
             break;
         }
@@ -124,21 +1037,20 @@ std::vector<uint32_t> BooleanSearch::parse_expression(const std::vector<QueryTok
     return left;
 }
 
-std::vector<uint32_t> BooleanSearch::parse_term(const std::vector<QueryToken>& tokens,
-                                                size_t& pos) {
+QueryPlan BooleanSearch::parse_term(const std::vector<QueryToken>& tokens, size_t& pos) {
     auto left = parse_factor(tokens, pos);
 
     while (pos < tokens.size()) {
         auto token = tokens[pos];
 
-        if (token.type == TokenType::AND || token.type == TokenType::TERM) {
+        if (token.type == TokenType::AND || token.type == TokenType::TERM ||
+            token.type == TokenType::NOT || token.type == TokenType::LPAREN) {
             // Неявное AND (пробел между терминами)
             if (token.type == TokenType::AND) {
                 pos++;
             }
 
-            auto right = parse_factor(tokens, pos);
-            left = intersect_sets(left, right);
+            left = combine(QueryNode::Type::AND, std::move(left), parse_factor(tokens, pos));
         } else {
             break;
         }
@@ -147,18 +1059,18 @@ std::vector<uint32_t> BooleanSearch::parse_term(const std::vector<QueryToken>& t
     return left;
 }
 
-std::vector<uint32_t> BooleanSearch::parse_factor(const std::vector<QueryToken>& tokens,
-                                                  size_t& pos) {
+QueryPlan BooleanSearch::parse_factor(const std::vector<QueryToken>& tokens, size_t& pos) {
     if (pos >= tokens.size()) {
         throw std::runtime_error("Unexpected end of query");
     }
 
-    auto token = tokens[pos];
+    const auto& token = tokens[pos];
 
     if (token.type == TokenType::NOT) {
         pos++;
-        auto operand = parse_factor(tokens, pos);
-        return complement_set(operand);
+        auto node = std::make_unique<QueryNode>(QueryNode::Type::NOT);
+        node->children.push_back(parse_factor(tokens, pos));
+        return node;
     } else if (token.type == TokenType::LPAREN) {
         pos++;
         auto result = parse_expression(tokens, pos);
@@ -171,15 +1083,33 @@ std::vector<uint32_t> BooleanSearch::parse_factor(const std::vector<QueryToken>&
         return result;
     } else if (token.type == TokenType::TERM) {
         pos++;
-        return get_postings(normalize_term(token.value));
+        return fetch_term_node(token);
     } else {
         throw std::runtime_error("Unexpected token in query");
     }
 }
 
-std::vector<uint32_t> BooleanSearch::intersect_sets(const std::vector<uint32_t>& a,
-                                                    const std::vector<uint32_t>& b) {
-    std::vector<uint32_t> result;
+QueryPlan BooleanSearch::combine(QueryNode::Type type, QueryPlan left, QueryPlan right) {
+    // Цепочки одной операции собираются в один узел: (AND a b c)
+    if (left->type != type) {
+        auto node = std::make_unique<QueryNode>(type);
+        node->children.push_back(std::move(left));
+        left = std::move(node);
+    }
+
+    if (right->type == type) {
+        for (auto& child : right->children) {
+            left->children.push_back(std::move(child));
+        }
+    } else {
+        left->children.push_back(std::move(right));
+    }
+
+    return left;
+}
+
+BooleanSearch::ScratchList BooleanSearch::intersect_sets(ListView a, ListView b, size_t* skipped) {
+    ScratchList result(&scratch);
     result.reserve(std::min(a.size(), b.size()));
 
     size_t i = 0, j = 0;
@@ -195,12 +1125,14 @@ std::vector<uint32_t> BooleanSearch::intersect_sets(const std::vector<uint32_t>&
         }
     }
 
+    if (skipped) {
+        *skipped += i + j - 2 * result.size();
+    }
     return result;
 }
 
-std::vector<uint32_t> BooleanSearch::union_sets(const std::vector<uint32_t>& a,
-                                                const std::vector<uint32_t>& b) {
-    std::vector<uint32_t> result;
+BooleanSearch::ScratchList BooleanSearch::union_sets(ListView a, ListView b) {
+    ScratchList result(&scratch);
     result.reserve(a.size() + b.size());
 
     size_t i = 0, j = 0;
@@ -231,8 +1163,8 @@ std::vector<uint32_t> BooleanSearch::union_sets(const std::vector<uint32_t>& a,
     return result;
 }
 
-std::vector<uint32_t> BooleanSearch::complement_set(const std::vector<uint32_t>& a) {
-    std::vector<uint32_t> result;
+BooleanSearch::ScratchList BooleanSearch::complement_set(ListView a) {
+    ScratchList result(&scratch);
     result.reserve(all_documents.size() - a.size());
 
     size_t i = 0, j = 0;
@@ -256,22 +1188,284 @@ std::vector<uint32_t> BooleanSearch::complement_set(const std::vector<uint32_t>&
     return result;
 }
 
-std::string BooleanSearch::normalize_term(const std::string& term) {
+BooleanSearch::ScratchList BooleanSearch::union_many(
+    const BooleanIndexBuilder::PostingsLists& lists) {
+
+    ScratchList result(&scratch);
+    if (lists.empty()) {
+        return result;
+    }
+
+    if (lists.size() == 1) {
+        result.assign(lists[0].begin(), lists[0].end());
+        return result;
+    }
+
+    size_t total = 0;
+    for (const auto& list : lists) {
+        total += list.size();
+    }
+
+    // Плотное объединение дешевле собрать в битовой карте
+    if (total * 32 >= all_documents.size()) {
+        Bitmap bitmap(all_documents.size());
+        for (const auto& list : lists) {
+            bitmap.set_all(list);
+        }
+        bitmap.append_to(result);
+        return result;
+    }
+
+    // Разреженное - k-путевым слиянием
+    using Cursor = std::pair<uint32_t, size_t>;  // (doc_id, номер списка)
+    std::priority_queue<Cursor, std::pmr::vector<Cursor>, std::greater<Cursor>> heap{
+        std::greater<Cursor>(), std::pmr::vector<Cursor>(&scratch)};
+    std::pmr::vector<size_t> positions(lists.size(), 0, &scratch);
+
+    for (size_t i = 0; i < lists.size(); ++i) {
+        if (!lists[i].empty()) {
+            heap.emplace(lists[i][0], i);
+        }
+    }
+
+    result.reserve(total);
+
+    while (!heap.empty()) {
+        auto [doc_id, list] = heap.top();
+        heap.pop();
+
+        if (result.empty() || result.back() != doc_id) {
+            result.push_back(doc_id);
+        }
+
+        if (++positions[list] < lists[list].size()) {
+            heap.emplace(lists[list][positions[list]], list);
+        }
+    }
+
+    return result;
+}
+
+std::string BooleanSearch::normalize_term(const std::string& term) const {
     std::string normalized = term;
     std::transform(normalized.begin(), normalized.end(), normalized.begin(),
                    [](unsigned char c) { return std::tolower(c); });
     return normalized;
 }
 
-std::vector<uint32_t> BooleanSearch::get_postings(const std::string& term) {
-    const auto& inverted_index = index.get_inverted_index();
-    auto it = inverted_index.find(term);
+BooleanSearch::ScratchList BooleanSearch::get_postings(const std::string& term) {
+    auto postings = index.get_postings(term, &scratch);
+    fetched_lists++;
+    fetched_postings += postings.size();
+    if (record_metrics) {
+        search_metrics().posting_lists.add();
+        search_metrics().postings.add(postings.size());
+    }
+    return postings;
+}
+
+BooleanSearch::ScratchList BooleanSearch::get_wildcard_postings(const std::string& pattern) {
+    auto lists = index.get_matching_postings(pattern, max_expansions, &scratch);
+    expanded_terms += lists.size();
+    add_fetched(lists);
+    return union_many(lists);
+}
+
+BooleanSearch::ScratchList BooleanSearch::get_expanded_postings(
+    const std::vector<std::string>& terms) {
+
+    BooleanIndexBuilder::PostingsLists lists(&scratch);
+    lists.reserve(terms.size());
+    for (const auto& term : terms) {
+        lists.push_back(index.get_postings(term, &scratch));
+    }
+
+    expanded_terms += lists.size();
+    add_fetched(lists);
+    return union_many(lists);
+}
+
+std::vector<std::string> BooleanSearch::fuzzy_terms(const std::string& term,
+                                                    uint32_t max_edits) const {
+    return index.get_fuzzy_terms(term, max_edits, max_fuzzy_expansions);
+}
+
+std::vector<std::string> BooleanSearch::fallback_terms(const std::string& term) const {
+    // Обычно опечатка одна, вторая правка - только для длинных слов
+    auto terms = fuzzy_terms(term, 1);
+    if (terms.empty() && term.size() > 4) {
+        terms = fuzzy_terms(term, 2);
+    }
+    return terms;
+}
+
+uint32_t BooleanSearch::fuzzy_edits(const std::string& value, size_t tilde) {
+    // desgn~1 - не больше одной правки, desgn~ - двух
+    if (tilde + 1 < value.size() && std::isdigit(static_cast<unsigned char>(value[tilde + 1]))) {
+        return std::min<uint32_t>(2, value[tilde + 1] - '0');
+    }
+    return 2;
+}
+
+void BooleanSearch::add_fetched(const BooleanIndexBuilder::PostingsLists& lists) {
+    size_t postings = 0;
+    for (const auto& list : lists) {
+        postings += list.size();
+    }
+
+    fetched_lists += lists.size();
+    fetched_postings += postings;
+    if (record_metrics) {
+        search_metrics().posting_lists.add(lists.size());
+        search_metrics().postings.add(postings);
+    }
+}
+
+bool BooleanSearch::is_filter_term(const std::string& value) const {
+    size_t colon = value.find(':');
+    if (colon == std::string::npos || colon == 0) {
+        return false;
+    }
+
+    std::string field = normalize_term(value.substr(0, colon));
+    return index.get_facets().has_field(field) || index.get_numeric_column(field) != nullptr;
+}
+
+bool BooleanSearch::parse_range(const std::string& text, uint32_t& low, uint32_t& high) {
+    // [500 TO 2000], [* TO 2000], [500 TO *] или одно число 500
+    auto parse_bound = [](const std::string& bound, uint32_t open_value, uint32_t& result) {
+        if (bound == "*") {
+            result = open_value;
+            return true;
+        }
+        if (bound.empty() || bound.size() > 10 ||
+            !std::all_of(bound.begin(), bound.end(), [](unsigned char c) { return std::isdigit(c); })) {
+            return false;
+        }
+        result = static_cast<uint32_t>(std::min<uint64_t>(std::stoull(bound), UINT32_MAX));
+        return true;
+    };
+
+    if (text.size() < 2 || text.front() != '[' || text.back() != ']') {
+        if (!parse_bound(text, 0, low) || text == "*") {
+            return false;
+        }
+        high = low;
+        return true;
+    }
+
+    std::istringstream stream(text.substr(1, text.size() - 2));
+    std::string from, to_keyword, to, extra;
+    stream >> from >> to_keyword >> to;
+
+    std::transform(to_keyword.begin(), to_keyword.end(), to_keyword.begin(),
+                   [](unsigned char c) { return std::toupper(c); });
+
+    return !(stream >> extra) && to_keyword == "TO" &&
+           parse_bound(from, 0, low) && parse_bound(to, UINT32_MAX, high);
+}
 
-    if (it != inverted_index.end()) {
-        return it->second;
+QueryPlan BooleanSearch::fetch_term_node(const QueryToken& token) {
+    if (!profiling) {
+        return make_term_node(token);
     }
 
-    return {};
+    size_t lists = fetched_lists;
+    size_t postings = fetched_postings;
+    uint64_t bytes = BinaryIndexReader::thread_decoded_bytes();
+    auto start_time = std::chrono::steady_clock::now();
+
+    auto node = make_term_node(token);
+
+    node->fetch.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_time).count();
+    node->fetch.lists = fetched_lists - lists;
+    node->fetch.postings = fetched_postings - postings;
+    node->fetch.bytes_decoded = BinaryIndexReader::thread_decoded_bytes() - bytes;
+    return node;
+}
+
+QueryPlan BooleanSearch::make_term_node(const QueryToken& token) {
+    const std::string& value = token.value;
+
+    // Фильтр по полю: source:wikipedia
+    if (is_filter_term(value)) {
+        size_t colon = value.find(':');
+        std::string field = normalize_term(value.substr(0, colon));
+
+        // Числовой диапазон: проход по упакованной колонке дает битовую карту
+        if (const NumericColumn* column = index.get_numeric_column(field)) {
+            uint32_t low = 0, high = 0;
+            if (!parse_range(value.substr(colon + 1), low, high)) {
+                throw std::runtime_error("Invalid range in query: " + value);
+            }
+
+            auto node = std::make_unique<QueryNode>(
+                QueryNode::Type::FILTER,
+                field + ":[" + std::to_string(low) + " TO " + std::to_string(high) + "]");
+            node->filter = std::make_shared<Bitmap>(column->range(low, high));
+            return node;
+        }
+        std::string field_value = FacetIndex::normalize_value(value.substr(colon + 1));
+
+        // Частое значение - карта в отображенном файле, редкое - список ID;
+        // нет значения - пустой список
+        auto node = std::make_unique<QueryNode>(QueryNode::Type::FILTER, field + ":" + field_value,
+                                                &scratch);
+        if (const FacetIndex::Value* facet = index.get_facets().find(field, field_value)) {
+            if (facet->bitmap) {
+                node->filter = facet->bitmap;
+            } else {
+                node->postings.assign(facet->doc_ids, facet->doc_ids + facet->id_count);
+            }
+        }
+        return node;
+    }
+
+    auto node = std::make_unique<QueryNode>(QueryNode::Type::TERM, "", &scratch);
+
+    // Шаблоны не стеммируются, только приводятся к нижнему регистру
+    if (value.find('*') != std::string::npos) {
+        node->label = normalize_term(value);
+        node->postings = get_wildcard_postings(node->label);
+        return node;
+    }
+
+    size_t tilde = value.find('~');
+    if (tilde != std::string::npos && tilde > 0) {
+        uint32_t max_edits = fuzzy_edits(value, tilde);
+        auto terms = analyzer.analyze_query_term(value.substr(0, tilde));
+        if (!terms.empty()) {
+            node->label = terms[0] + "~" + std::to_string(max_edits);
+            node->postings = get_expanded_postings(fuzzy_terms(terms[0], max_edits));
+        }
+        return node;
+    }
+
+    // Слово может дать несколько терминов (например, через дефис) - пересекаем
+    std::vector<std::string> analyzed;
+    if (!token.analyzed) {
+        analyzed = analyzer.analyze_query_term(value);
+    }
+    const auto& terms = token.analyzed ? token.terms : analyzed;
+
+    for (size_t i = 0; i < terms.size(); ++i) {
+        node->label += (i == 0 ? "" : "+") + terms[i];
+
+        auto postings = get_postings(terms[i]);
+
+        if (postings.empty() && fuzzy_fallback) {
+            postings = get_expanded_postings(fallback_terms(terms[i]));
+        }
+
+        if (i == 0) {
+            node->postings = std::move(postings);
+        } else {
+            node->postings = intersect_sets(node->postings, postings);
+        }
+    }
+
+    return node;
 }
 
 std::vector<BooleanSearch::SearchResult> BooleanSearch::format_results(
@@ -281,6 +1475,7 @@ std::vector<BooleanSearch::SearchResult> BooleanSearch::format_results(
     const auto& forward_index = index.get_forward_index();
 
     size_t end = std::min(offset + limit, doc_ids.size());
+    results.reserve(end > offset ? end - offset : 0);
 
     for (size_t i = offset; i < end; ++i) {
         uint32_t doc_id = doc_ids[i];
@@ -289,21 +1484,122 @@ std::vector<BooleanSearch::SearchResult> BooleanSearch::format_results(
             continue;
         }
 
-        const auto& doc_info = forward_index[doc_id];
+        std::string_view title = forward_index.get_title(doc_id);
 
         SearchResult result;
         result.doc_id = doc_id;
-        result.title = doc_info.title.empty() ? "Untitled Document" : doc_info.title;
-        result.url = doc_info.url;
+        result.title = title.empty() ? "Untitled Document" : std::string(title);
+        result.url = std::string(forward_index.get_url(doc_id));
 
         result.relevance = 1.0 / (i + 1);
 
-        results.push_back(result);
+        results.push_back(std::move(result));
     }
 
     return results;
 }
 
+void BooleanSearch::add_snippets(std::vector<SearchResult>& results, const std::string& query) {
+    if (!index.has_content() || results.empty()) {
+        return;
+    }
+
+    auto terms = highlight_terms(query);
+
+    for (auto& result : results) {
+        // Один блок хранилища на документ
+        result.snippet = highlighter.snippet(index.get_content(result.doc_id), terms);
+    }
+}
+
+std::vector<std::string> BooleanSearch::highlight_terms(const std::string& query) {
+    try {
+        return highlight_terms(tokenize_query(query));
+    } catch (const std::exception&) {
+        return {};
+    }
+}
+
+std::vector<std::string> BooleanSearch::highlight_terms(const std::vector<QueryToken>& tokens) {
+    std::vector<std::string> terms;
+
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        if (tokens[i].type != TokenType::TERM ||
+            tokens[i].value.find('*') != std::string::npos ||
+            is_filter_term(tokens[i].value) ||
+            (i > 0 && tokens[i - 1].type == TokenType::NOT)) {
+            continue;
+        }
+
+        auto add_term = [&terms](std::string term) {
+            if (std::find(terms.begin(), terms.end(), term) == terms.end()) {
+                terms.push_back(std::move(term));
+            }
+        };
+
+        // Нечеткий термин (term~) подсвечивается терминами словаря, которые
+        // нашел план, а не написанием из запроса
+        const std::string& value = tokens[i].value;
+        size_t tilde = value.find('~');
+        if (!tokens[i].analyzed && tilde != std::string::npos && tilde > 0) {
+            auto analyzed = analyzer.analyze_query_term(value.substr(0, tilde));
+            if (!analyzed.empty()) {
+                for (auto& term : fuzzy_terms(analyzed[0], fuzzy_edits(value, tilde))) {
+                    add_term(std::move(term));
+                }
+            }
+            continue;
+        }
+
+        for (const auto& term : tokens[i].terms) {
+            if (fuzzy_fallback && !index.has_term(term)) {
+                for (auto& corrected : fallback_terms(term)) {
+                    add_term(std::move(corrected));
+                }
+            } else {
+                add_term(term);
+            }
+        }
+    }
+
+    return terms;
+}
+
+QueryProfile BooleanSearch::explain(const std::string& query) {
+    QueryProfile profile;
+    profile.query = query;
+
+    auto start_time = std::chrono::steady_clock::now();
+    ScratchArena::Scope scope(scratch);
+    profiling = true;
+
+    try {
+        size_t token_count = 0;
+        auto plan = parse_query(query, token_count);
+        auto parsed_time = std::chrono::steady_clock::now();
+        profile.plan = plan_to_string(*plan);
+
+        ScratchList storage(&scratch);
+        auto matches = evaluate_plan(*plan, storage, &profile.root);
+        std::vector<uint32_t> result(matches.begin(), matches.end());
+        collapse_clusters(result);
+        auto end_time = std::chrono::steady_clock::now();
+
+        profile.result_count = result.size();
+        profile.parse_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            parsed_time - start_time).count();
+        profile.eval_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            end_time - parsed_time).count();
+    } catch (const std::exception& e) {
+        profile.error = e.what();
+    }
+
+    profiling = false;
+    profile.total_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_time).count();
+    return profile;
+}
+
 std::vector<std::pair<std::string, std::vector<uint32_t>>> BooleanSearch::batch_search(
     const std::vector<std::string>& queries) {
 
@@ -320,4 +1616,75 @@ std::vector<std::pair<std::string, std::vector<uint32_t>>> BooleanSearch::batch_
 
 BooleanSearch::SearchStats BooleanSearch::get_last_stats() const {
     return last_stats;
+}
+
+size_t BooleanSearch::get_scratch_peak() const {
+    return scratch.peak_bytes();
+}
+
+void BooleanSearch::set_query_log(SlowQueryLog* log) {
+    query_log = log;
+}
+
+void BooleanSearch::set_max_expansions(size_t limit) {
+    max_expansions = limit;
+}
+
+void BooleanSearch::set_fuzzy_fallback(bool enabled) {
+    fuzzy_fallback = enabled;
+}
+
+void BooleanSearch::set_record_metrics(bool enabled) {
+    record_metrics = enabled;
+}
+
+void BooleanSearch::set_collapse_duplicates(bool enabled) {
+    collapse_duplicates = enabled;
+}
+
+const NumericColumn* BooleanSearch::collapse_column() const {
+    const NumericColumn* clusters = index.get_numeric_column("cluster");
+    if (!collapse_duplicates || !clusters || clusters->size() == 0) {
+        return nullptr;
+    }
+    return clusters;
+}
+
+void BooleanSearch::collapse_clusters(std::vector<uint32_t>& doc_ids) const {
+    const NumericColumn* clusters = collapse_column();
+    if (!clusters) {
+        return;
+    }
+
+    Bitmap seen(uint64_t(clusters->get_max()) + 1);
+    size_t kept = 0;
+
+    for (uint32_t doc_id : doc_ids) {
+        uint32_t cluster_id = clusters->get(doc_id);
+        if (!seen.test(cluster_id)) {
+            seen.set(cluster_id);
+            doc_ids[kept++] = doc_id;
+        }
+    }
+
+    doc_ids.resize(kept);
+}
+
+Bitmap BooleanSearch::collapsed_matches(ListView doc_ids, const NumericColumn& clusters) const {
+    Bitmap seen(uint64_t(clusters.get_max()) + 1);
+    Bitmap shown(all_documents.size());
+
+    for (uint32_t doc_id : doc_ids) {
+        uint32_t cluster_id = clusters.get(doc_id);
+        if (!seen.test(cluster_id)) {
+            seen.set(cluster_id);
+            shown.set(doc_id);
+        }
+    }
+
+    return shown;
+}
+
+Analyzer& BooleanSearch::get_analyzer() {
+    return analyzer;
 }
\ No newline at end of file
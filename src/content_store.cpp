@@ -0,0 +1,300 @@
+#include "content_store.hpp"
+#include "file_writer.hpp"
+#include "lz_codec.hpp"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const uint32_t STORE_MAGIC = 0x52545346;  // "FSTR"
+const uint16_t STORE_VERSION = 2;
+const uint64_t STORE_HEADER_SIZE = 40;
+const uint64_t BLOCK_HEADER_SIZE = 9;
+
+const uint8_t CODEC_RAW = 0;
+const uint8_t CODEC_LZ = 1;
+
+template<typename T>
+T load(const uint8_t* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+template<typename T>
+void append(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+}  // namespace
+
+ContentStore::ContentStore(uint32_t block_size) : block_size(block_size) {
+}
+
+ContentStore::~ContentStore() {
+    unmap();
+}
+
+void ContentStore::clear() {
+    unmap();
+    own_blocks.clear();
+    own_block_offsets.clear();
+    own_locations.clear();
+    pending.clear();
+    block_count = 0;
+    doc_count = 0;
+    store_id = 0;
+    raw_bytes = 0;
+    stored_bytes = 0;
+    attach_own();
+}
+
+void ContentStore::add(std::string_view content) {
+    if (mapped) {
+        throw std::runtime_error("Cannot add documents to a mapped content store");
+    }
+
+    if (content.size() > UINT32_MAX) {
+        throw std::runtime_error("Document is too large for the content store");
+    }
+
+    // Большой документ не смешиваем с уже набранным блоком
+    if (!pending.empty() && pending.size() + content.size() > block_size) {
+        flush_block();
+    }
+
+    own_locations.push_back({block_count,
+                             static_cast<uint32_t>(pending.size()),
+                             static_cast<uint32_t>(content.size())});
+    pending.append(content.data(), content.size());
+    raw_bytes += content.size();
+    doc_count++;
+
+    if (pending.size() >= block_size) {
+        flush_block();
+    }
+
+    attach_own();
+}
+
+void ContentStore::reorder(const std::vector<uint32_t>& order) {
+    if (mapped) {
+        throw std::runtime_error("Content store is read-only");
+    }
+
+    std::vector<DocLocation> reordered;
+    reordered.reserve(order.size());
+    raw_bytes = 0;
+    for (uint32_t doc_id : order) {
+        reordered.push_back(own_locations.at(doc_id));
+        raw_bytes += reordered.back().length;
+    }
+
+    own_locations = std::move(reordered);
+    doc_count = static_cast<uint32_t>(own_locations.size());
+    attach_own();
+}
+
+void ContentStore::flush_block() {
+    if (pending.empty()) {
+        return;
+    }
+
+    uint64_t block_start = own_blocks.size();
+    own_block_offsets.push_back(block_start);
+
+    own_blocks.push_back(static_cast<char>(CODEC_LZ));
+    append<uint32_t>(own_blocks, static_cast<uint32_t>(pending.size()));
+    append<uint32_t>(own_blocks, 0);
+
+    uint64_t data_start = own_blocks.size();
+    lz_compress(pending.data(), pending.size(), own_blocks);
+    uint64_t compressed = own_blocks.size() - data_start;
+
+    // Несжимаемые данные храним как есть
+    if (compressed >= pending.size()) {
+        own_blocks.resize(data_start);
+        own_blocks.append(pending);
+        own_blocks[block_start] = static_cast<char>(CODEC_RAW);
+        compressed = pending.size();
+    }
+
+    uint32_t stored = static_cast<uint32_t>(compressed);
+    std::memcpy(&own_blocks[block_start + 5], &stored, sizeof(stored));
+
+    stored_bytes += compressed;
+    block_count++;
+    pending.clear();
+}
+
+void ContentStore::attach_own() {
+    blocks_data = reinterpret_cast<const uint8_t*>(own_blocks.data());
+    blocks_size = own_blocks.size();
+    block_offsets = own_block_offsets.data();
+    locations = own_locations.data();
+}
+
+void ContentStore::save(const std::string& filename) {
+    if (mapped) {
+        throw std::runtime_error("Content store is read-only");
+    }
+
+    flush_block();
+    attach_own();
+
+    // Как и индекс, публикуется только полностью записанный файл
+    FileWriter file(filename);
+
+    uint64_t block_table_offset = STORE_HEADER_SIZE + own_blocks.size();
+    uint64_t padding = (8 - block_table_offset % 8) % 8;
+    block_table_offset += padding;
+    uint64_t doc_table_offset = block_table_offset + uint64_t(block_count) * sizeof(uint64_t);
+
+    // Идентификатор новый при каждой записи, даже для тех же документов:
+    // индекс от прошлой записи с этим хранилищем не совпадет
+    std::random_device device;
+    store_id = (uint64_t(device()) << 32 | device()) ^
+               static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+
+    std::string header;
+    append<uint32_t>(header, STORE_MAGIC);
+    append<uint16_t>(header, STORE_VERSION);
+    append<uint16_t>(header, 0);
+    append<uint32_t>(header, doc_count);
+    append<uint32_t>(header, block_count);
+    append<uint64_t>(header, block_table_offset);
+    append<uint64_t>(header, doc_table_offset);
+    append<uint64_t>(header, store_id);
+    file.write(header.data(), header.size());
+
+    file.write(own_blocks.data(), own_blocks.size());
+    file.write("\0\0\0\0\0\0\0", padding);
+
+    for (uint64_t offset : own_block_offsets) {
+        uint64_t absolute = STORE_HEADER_SIZE + offset;
+        file.write(&absolute, sizeof(absolute));
+    }
+
+    file.write(own_locations.data(), own_locations.size() * sizeof(DocLocation));
+    file.commit();
+
+    stored_bytes = doc_table_offset + own_locations.size() * sizeof(DocLocation);
+}
+
+bool ContentStore::open(const std::string& filename) {
+    clear();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < STORE_HEADER_SIZE) {
+        ::close(fd);
+        throw std::runtime_error("Content store is too small: " + filename);
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (map == MAP_FAILED) {
+        throw std::runtime_error("Cannot map content store: " + filename);
+    }
+
+    mapped = static_cast<const uint8_t*>(map);
+    mapped_size = size;
+
+    uint32_t magic = load<uint32_t>(mapped);
+    uint16_t version = load<uint16_t>(mapped + 4);
+    uint32_t docs = load<uint32_t>(mapped + 8);
+    uint32_t blocks = load<uint32_t>(mapped + 12);
+    uint64_t block_table_offset = load<uint64_t>(mapped + 16);
+    uint64_t doc_table_offset = load<uint64_t>(mapped + 24);
+    uint64_t id = load<uint64_t>(mapped + 32);
+
+    if (magic != STORE_MAGIC || version != STORE_VERSION ||
+        block_table_offset % 8 != 0 ||
+        doc_table_offset != block_table_offset + uint64_t(blocks) * sizeof(uint64_t) ||
+        doc_table_offset + uint64_t(docs) * sizeof(DocLocation) > mapped_size) {
+        unmap();
+        throw std::runtime_error("Invalid content store: " + filename);
+    }
+
+    blocks_data = mapped;
+    blocks_size = block_table_offset;
+    block_offsets = reinterpret_cast<const uint64_t*>(mapped + block_table_offset);
+    locations = reinterpret_cast<const DocLocation*>(mapped + doc_table_offset);
+    block_count = blocks;
+    doc_count = docs;
+    store_id = id;
+    stored_bytes = mapped_size;
+    raw_bytes = 0;
+    for (uint32_t i = 0; i < doc_count; ++i) {
+        raw_bytes += locations[i].length;
+    }
+
+    return true;
+}
+
+std::string ContentStore::get(uint32_t doc_id) const {
+    if (doc_id >= doc_count) {
+        throw std::out_of_range("Document ID out of range");
+    }
+
+    const DocLocation& location = locations[doc_id];
+
+    // Последний блок при построении еще не сжат
+    if (!mapped && location.block == block_count) {
+        return pending.substr(location.offset, location.length);
+    }
+
+    if (location.block >= block_count) {
+        throw std::runtime_error("Corrupted content store");
+    }
+
+    uint64_t block_pos = block_offsets[location.block];
+    if (block_pos + BLOCK_HEADER_SIZE > blocks_size) {
+        throw std::runtime_error("Corrupted content store");
+    }
+
+    const uint8_t* block = blocks_data + block_pos;
+    uint8_t codec = block[0];
+    uint32_t raw_size = load<uint32_t>(block + 1);
+    uint32_t stored_size = load<uint32_t>(block + 5);
+
+    if (block_pos + BLOCK_HEADER_SIZE + stored_size > blocks_size ||
+        uint64_t(location.offset) + location.length > raw_size) {
+        throw std::runtime_error("Corrupted content store");
+    }
+
+    const char* payload = reinterpret_cast<const char*>(block + BLOCK_HEADER_SIZE);
+
+    if (codec == CODEC_RAW) {
+        return std::string(payload + location.offset, location.length);
+    }
+
+    if (codec != CODEC_LZ) {
+        throw std::runtime_error("Unknown content store codec");
+    }
+
+    std::string raw(raw_size, '\0');
+    lz_decompress(payload, stored_size, &raw[0], raw_size);
+    return raw.substr(location.offset, location.length);
+}
+
+void ContentStore::unmap() {
+    if (mapped) {
+        ::munmap(const_cast<uint8_t*>(mapped), mapped_size);
+        mapped = nullptr;
+        mapped_size = 0;
+    }
+}
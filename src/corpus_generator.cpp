@@ -0,0 +1,260 @@
+#include "corpus_generator.hpp"
+#include "tokenizer.hpp"
+#include "zipf_analyzer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+const char* const SOURCES[] = {"vogue", "elle", "wikipedia", "harpers_bazaar", "fashionista",
+                               "wwd", "blog"};
+const char* const CATEGORIES[] = {"designers", "trends", "brands", "models", "history",
+                                  "streetwear", "accessories", "beauty"};
+const char* const SUFFIXES[] = {"", "", "", "", "s", "ing", "ed", "er", "ly", "ness",
+                                "ment", "ation", "ful", "ive", "al", "ity"};
+
+}  // namespace
+
+CorpusModel CorpusModel::fit(const std::vector<Document>& sample) {
+    CorpusModel model;
+
+    Tokenizer tokenizer;
+    std::vector<std::string> tokens;
+    std::vector<double> log_lengths;
+    size_t min_length = SIZE_MAX;
+    size_t max_length = 0;
+
+    for (const auto& doc : sample) {
+        auto result = tokenizer.tokenize(doc.content);
+        if (result.tokens.empty()) {
+            continue;
+        }
+
+        log_lengths.push_back(std::log(static_cast<double>(result.tokens.size())));
+        min_length = std::min(min_length, result.tokens.size());
+        max_length = std::max(max_length, result.tokens.size());
+        tokens.insert(tokens.end(), std::make_move_iterator(result.tokens.begin()),
+                      std::make_move_iterator(result.tokens.end()));
+    }
+
+    if (log_lengths.size() < 2) {
+        throw std::runtime_error("Not enough documents to fit a corpus model");
+    }
+
+    double sum = 0.0;
+    for (double value : log_lengths) {
+        sum += value;
+    }
+    model.length_mu = sum / log_lengths.size();
+
+    double variance = 0.0;
+    for (double value : log_lengths) {
+        variance += (value - model.length_mu) * (value - model.length_mu);
+    }
+    model.length_sigma = std::sqrt(variance / (log_lengths.size() - 1));
+    model.min_length = min_length;
+    model.max_length = max_length;
+
+    ZipfAnalyzer analyzer;
+    auto analysis = analyzer.analyze(tokens);
+    auto fit = analyzer.fit_mandelbrot(analysis);
+    model.vocabulary_size = analysis.unique_tokens;
+    model.zipf_alpha = fit.alpha;
+    model.zipf_shift = fit.B;
+
+    return model;
+}
+
+QueryMix QueryMix::parse(const std::string& text) {
+    QueryMix mix{0, 0, 0, 0, 0};
+
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            throw std::runtime_error("Invalid query mix entry: " + item);
+        }
+
+        std::string kind = item.substr(0, eq);
+        unsigned weight = static_cast<unsigned>(std::stoul(item.substr(eq + 1)));
+        if (kind == "term") {
+            mix.term = weight;
+        } else if (kind == "and") {
+            mix.and_terms = weight;
+        } else if (kind == "or") {
+            mix.or_terms = weight;
+        } else if (kind == "not") {
+            mix.not_terms = weight;
+        } else if (kind == "wildcard") {
+            mix.wildcard = weight;
+        } else {
+            throw std::runtime_error("Unknown query kind: " + kind);
+        }
+    }
+
+    if (mix.term + mix.and_terms + mix.or_terms + mix.not_terms + mix.wildcard == 0) {
+        throw std::runtime_error("Query mix is empty");
+    }
+    return mix;
+}
+
+CorpusGenerator::CorpusGenerator(const CorpusModel& model, uint64_t seed)
+    : model(model), random(seed), length_distribution(model.length_mu, model.length_sigma) {
+    if (model.vocabulary_size == 0 || model.vocabulary_size > UINT32_MAX) {
+        throw std::runtime_error("Invalid vocabulary size");
+    }
+    if (model.min_length == 0 || model.min_length > model.max_length) {
+        throw std::runtime_error("Invalid document length range");
+    }
+
+    build_vocabulary();
+    build_alias_table();
+}
+
+void CorpusGenerator::build_vocabulary() {
+    std::uniform_int_distribution<int> length(2, 7);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::uniform_int_distribution<size_t> suffix(0, std::size(SUFFIXES) - 1);
+
+    // Частые слова короче, как в естественном языке
+    vocabulary.reserve(model.vocabulary_size);
+    for (size_t i = 0; i < model.vocabulary_size; ++i) {
+        size_t size = length(random) + (i < 100 ? 0 : 1) + (i < 10000 ? 0 : 1);
+        std::string word(size, ' ');
+        for (auto& c : word) {
+            c = static_cast<char>(letter(random));
+        }
+        vocabulary.push_back(word + SUFFIXES[suffix(random)]);
+    }
+}
+
+void CorpusGenerator::build_alias_table() {
+    size_t n = vocabulary.size();
+    std::vector<double> weights(n);
+    double total = 0.0;
+    for (size_t r = 0; r < n; ++r) {
+        weights[r] = 1.0 / std::pow(r + 1 + model.zipf_shift, model.zipf_alpha);
+        total += weights[r];
+    }
+
+    // Вероятности, умноженные на n: меньше 1 - ячейка дополняется
+    // псевдонимом из списка больших
+    alias_probability.assign(n, 0.0);
+    alias.assign(n, 0);
+    std::vector<uint32_t> small, large;
+    for (size_t r = 0; r < n; ++r) {
+        weights[r] = weights[r] * n / total;
+        (weights[r] < 1.0 ? small : large).push_back(static_cast<uint32_t>(r));
+    }
+
+    while (!small.empty() && !large.empty()) {
+        uint32_t s = small.back();
+        small.pop_back();
+        uint32_t l = large.back();
+
+        alias_probability[s] = weights[s];
+        alias[s] = l;
+        weights[l] -= 1.0 - weights[s];
+        if (weights[l] < 1.0) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    // Остатки из-за погрешности округления
+    for (uint32_t r : large) {
+        alias_probability[r] = 1.0;
+    }
+    for (uint32_t r : small) {
+        alias_probability[r] = 1.0;
+    }
+}
+
+size_t CorpusGenerator::next_rank() {
+    uint64_t bits = random();
+    size_t cell = static_cast<size_t>((bits >> 32) * vocabulary.size() >> 32);
+    double coin = (bits & 0xFFFFFFFF) * (1.0 / 4294967296.0);
+    return coin < alias_probability[cell] ? cell : alias[cell];
+}
+
+const std::string& CorpusGenerator::next_word() {
+    return vocabulary[next_rank()];
+}
+
+void CorpusGenerator::append_text(std::string& text, size_t words) {
+    for (size_t i = 0; i < words; ++i) {
+        if (i > 0) {
+            text += (i % 14 == 0) ? ". " : " ";
+        }
+        text += next_word();
+    }
+}
+
+void CorpusGenerator::next_document(Document& doc) {
+    std::uniform_int_distribution<size_t> source(0, std::size(SOURCES) - 1);
+    std::uniform_int_distribution<size_t> category(0, std::size(CATEGORIES) - 1);
+    std::uniform_int_distribution<size_t> title_length(3, 10);
+
+    size_t number = documents_generated++;
+    doc.id = "synthetic-" + std::to_string(number);
+    doc.source = SOURCES[source(random)];
+    doc.category = CATEGORIES[category(random)];
+    doc.url = "https://" + doc.source + ".example.com/" + doc.category + "/" +
+              std::to_string(number);
+
+    doc.title.clear();
+    append_text(doc.title, title_length(random));
+
+    size_t words = static_cast<size_t>(std::llround(length_distribution(random)));
+    words = std::clamp(words, model.min_length, model.max_length);
+
+    doc.content.clear();
+    append_text(doc.content, words);
+    doc.word_count = static_cast<int>(words);
+    doc.tokens.clear();
+    doc.stemmed_tokens.clear();
+}
+
+std::string CorpusGenerator::next_query(const QueryMix& mix) {
+    unsigned total = mix.term + mix.and_terms + mix.or_terms + mix.not_terms + mix.wildcard;
+    unsigned roll = std::uniform_int_distribution<unsigned>(0, total - 1)(random);
+    std::uniform_int_distribution<int> extra(0, 3);
+
+    if (roll < mix.term) {
+        return next_word();
+    }
+    roll -= mix.term;
+
+    if (roll < mix.and_terms) {
+        std::string query = next_word() + " && " + next_word();
+        if (extra(random) == 0) {
+            query += " && " + next_word();
+        }
+        return query;
+    }
+    roll -= mix.and_terms;
+
+    if (roll < mix.or_terms) {
+        std::string query = next_word() + " || " + next_word();
+        if (extra(random) == 0) {
+            query += " || " + next_word();
+        }
+        return query;
+    }
+    roll -= mix.or_terms;
+
+    if (roll < mix.not_terms) {
+        return next_word() + " !" + next_word();
+    }
+
+    // Шаблон по началу слова (не короче трех букв)
+    const std::string* word = &next_word();
+    for (int attempt = 0; attempt < 64 && word->size() < 4; ++attempt) {
+        word = &next_word();
+    }
+    return word->substr(0, 3) + "*";
+}
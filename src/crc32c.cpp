@@ -0,0 +1,77 @@
+#include "crc32c.hpp"
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define CRC32C_HAS_SSE42 1
+#else
+#define CRC32C_HAS_SSE42 0
+#endif
+
+namespace {
+
+const uint32_t POLYNOMIAL = 0x82F63B78;  // Отраженный полином 0x1EDC6F41
+
+std::array<uint32_t, 256> make_table() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (POLYNOMIAL & (0u - (crc & 1)));
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+uint32_t crc32c_table(const uint8_t* p, size_t size, uint32_t crc) {
+    static const std::array<uint32_t, 256> table = make_table();
+
+    for (size_t i = 0; i < size; ++i) {
+        crc = (crc >> 8) ^ table[(crc ^ p[i]) & 0xFF];
+    }
+    return crc;
+}
+
+#if CRC32C_HAS_SSE42
+__attribute__((target("sse4.2")))
+uint32_t crc32c_sse42(const uint8_t* p, size_t size, uint32_t crc) {
+#if defined(__x86_64__)
+    uint64_t crc64 = crc;
+    for (; size >= 8; size -= 8, p += 8) {
+        uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = static_cast<uint32_t>(crc64);
+#endif
+    for (; size >= 4; size -= 4, p += 4) {
+        uint32_t word;
+        std::memcpy(&word, p, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+    }
+    for (; size > 0; --size, ++p) {
+        crc = _mm_crc32_u8(crc, *p);
+    }
+    return crc;
+}
+#endif
+
+using CrcFunction = uint32_t (*)(const uint8_t*, size_t, uint32_t);
+
+CrcFunction select_implementation() {
+#if CRC32C_HAS_SSE42
+    if (__builtin_cpu_supports("sse4.2")) {
+        return &crc32c_sse42;
+    }
+#endif
+    return &crc32c_table;
+}
+
+}  // namespace
+
+uint32_t crc32c(const void* data, size_t size, uint32_t crc) {
+    static const CrcFunction implementation = select_implementation();
+    return ~implementation(static_cast<const uint8_t*>(data), size, ~crc);
+}
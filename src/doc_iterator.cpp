@@ -0,0 +1,299 @@
+#include "doc_iterator.hpp"
+#include <algorithm>
+
+PostingsIterator::PostingsIterator(const std::pmr::vector<uint32_t>& postings)
+    : postings(postings) {
+}
+
+uint32_t PostingsIterator::next() {
+    if (!started) {
+        started = true;
+        position = 0;
+    } else if (position < postings.size()) {
+        position++;
+    }
+
+    current = position < postings.size() ? postings[position] : END;
+    return current;
+}
+
+uint32_t PostingsIterator::advance(uint32_t target) {
+    if (started && (current == END || current >= target)) {
+        return current;
+    }
+
+    if (!started) {
+        started = true;
+        position = 0;
+    }
+
+    // Экспоненциальный поиск от текущей позиции, затем бинарный
+    size_t low = position;
+    size_t step = 1;
+    while (low + step < postings.size() && postings[low + step] < target) {
+        low += step;
+        step *= 2;
+    }
+
+    size_t high = std::min(low + step + 1, postings.size());
+    position = std::lower_bound(postings.begin() + low, postings.begin() + high, target) -
+               postings.begin();
+
+    current = position < postings.size() ? postings[position] : END;
+    return current;
+}
+
+BitmapIterator::BitmapIterator(const Bitmap& bitmap)
+    : bitmap(bitmap), bit_count(bitmap.count()) {
+}
+
+uint32_t BitmapIterator::find_from(uint64_t position) const {
+    const uint64_t* words = bitmap.data();
+    size_t word_count = bitmap.word_count();
+    size_t w = position >> 6;
+
+    if (w >= word_count) {
+        return END;
+    }
+
+    // Биты текущего слова до position отбрасываем
+    uint64_t word = words[w] & (~uint64_t(0) << (position & 63));
+
+    while (true) {
+        if (word) {
+            return static_cast<uint32_t>(w * 64 + __builtin_ctzll(word));
+        }
+        if (++w >= word_count) {
+            return END;
+        }
+        word = words[w];
+    }
+}
+
+uint32_t BitmapIterator::next() {
+    if (!started) {
+        started = true;
+        current = find_from(0);
+    } else if (current != END) {
+        current = find_from(uint64_t(current) + 1);
+    }
+
+    return current;
+}
+
+uint32_t BitmapIterator::advance(uint32_t target) {
+    if (started && (current == END || current >= target)) {
+        return current;
+    }
+
+    started = true;
+    current = find_from(target);
+    return current;
+}
+
+AndIterator::AndIterator(std::vector<std::unique_ptr<DocIterator>> required,
+                         std::vector<std::unique_ptr<DocIterator>> excluded)
+    : required(std::move(required)), excluded(std::move(excluded)) {
+    // Ведущим идет самый короткий список
+    std::sort(this->required.begin(), this->required.end(),
+              [](const auto& a, const auto& b) { return a->cost() < b->cost(); });
+}
+
+uint32_t AndIterator::align(uint32_t target) {
+    uint32_t candidate = required[0]->advance(target);
+
+    while (candidate != END) {
+        uint32_t next_candidate = candidate;
+
+        for (size_t i = 1; i < required.size(); ++i) {
+            uint32_t doc = required[i]->advance(candidate);
+            if (doc != candidate) {
+                next_candidate = doc;
+                break;
+            }
+        }
+
+        if (next_candidate == candidate) {
+            bool excluded_hit = false;
+            for (auto& iterator : excluded) {
+                if (iterator->advance(candidate) == candidate) {
+                    excluded_hit = true;
+                    break;
+                }
+            }
+
+            if (!excluded_hit) {
+                break;
+            }
+            next_candidate = candidate + 1;
+        }
+
+        candidate = next_candidate == END ? END : required[0]->advance(next_candidate);
+    }
+
+    current = candidate;
+    return current;
+}
+
+uint32_t AndIterator::next() {
+    if (!started) {
+        started = true;
+        return align(0);
+    }
+
+    if (current == END) {
+        return END;
+    }
+
+    return align(current + 1);
+}
+
+uint32_t AndIterator::advance(uint32_t target) {
+    if (started && (current == END || current >= target)) {
+        return current;
+    }
+
+    started = true;
+    return align(target);
+}
+
+size_t AndIterator::cost() const {
+    return required[0]->cost();
+}
+
+OrIterator::OrIterator(std::vector<std::unique_ptr<DocIterator>> children)
+    : children(std::move(children)) {
+}
+
+uint32_t OrIterator::smallest() const {
+    uint32_t result = END;
+    for (const auto& child : children) {
+        result = std::min(result, child->doc());
+    }
+    return result;
+}
+
+uint32_t OrIterator::next() {
+    if (!started) {
+        started = true;
+        for (auto& child : children) {
+            child->next();
+        }
+    } else if (current != END) {
+        for (auto& child : children) {
+            if (child->doc() == current) {
+                child->next();
+            }
+        }
+    }
+
+    current = smallest();
+    return current;
+}
+
+uint32_t OrIterator::advance(uint32_t target) {
+    if (started && (current == END || current >= target)) {
+        return current;
+    }
+
+    started = true;
+    for (auto& child : children) {
+        child->advance(target);
+    }
+
+    current = smallest();
+    return current;
+}
+
+size_t OrIterator::cost() const {
+    size_t total = 0;
+    for (const auto& child : children) {
+        total += child->cost();
+    }
+    return total;
+}
+
+NotIterator::NotIterator(std::unique_ptr<DocIterator> child, uint32_t doc_count)
+    : child(std::move(child)), doc_count(doc_count) {
+}
+
+uint32_t NotIterator::skip_excluded(uint32_t target) {
+    uint32_t doc = target;
+
+    while (doc < doc_count) {
+        if (!child || child->advance(doc) != doc) {
+            return doc;
+        }
+        doc++;
+    }
+
+    return END;
+}
+
+uint32_t NotIterator::next() {
+    if (!started) {
+        started = true;
+        current = skip_excluded(0);
+    } else if (current != END) {
+        current = skip_excluded(current + 1);
+    }
+
+    return current;
+}
+
+uint32_t NotIterator::advance(uint32_t target) {
+    if (started && (current == END || current >= target)) {
+        return current;
+    }
+
+    started = true;
+    current = skip_excluded(target);
+    return current;
+}
+
+std::unique_ptr<DocIterator> make_iterator(const QueryNode& node, uint32_t doc_count) {
+    switch (node.type) {
+        case QueryNode::Type::TERM:
+            return std::make_unique<PostingsIterator>(node.postings);
+
+        case QueryNode::Type::FILTER:
+            if (!node.filter) {
+                return std::make_unique<PostingsIterator>(node.postings);
+            }
+            return std::make_unique<BitmapIterator>(*node.filter);
+
+        case QueryNode::Type::NOT:
+            return std::make_unique<NotIterator>(make_iterator(*node.children[0], doc_count),
+                                                 doc_count);
+
+        case QueryNode::Type::OR: {
+            std::vector<std::unique_ptr<DocIterator>> children;
+            for (const auto& child : node.children) {
+                children.push_back(make_iterator(*child, doc_count));
+            }
+            return std::make_unique<OrIterator>(std::move(children));
+        }
+
+        case QueryNode::Type::AND: {
+            std::vector<std::unique_ptr<DocIterator>> required;
+            std::vector<std::unique_ptr<DocIterator>> excluded;
+
+            for (const auto& child : node.children) {
+                if (child->type == QueryNode::Type::NOT) {
+                    excluded.push_back(make_iterator(*child->children[0], doc_count));
+                } else {
+                    required.push_back(make_iterator(*child, doc_count));
+                }
+            }
+
+            // Только отрицания: кандидаты - все документы
+            if (required.empty()) {
+                required.push_back(std::make_unique<NotIterator>(nullptr, doc_count));
+            }
+
+            return std::make_unique<AndIterator>(std::move(required), std::move(excluded));
+        }
+    }
+
+    return nullptr;
+}
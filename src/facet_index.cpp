@@ -0,0 +1,123 @@
+#include "facet_index.hpp"
+#include <cctype>
+
+const std::vector<std::string>& FacetIndex::field_names() {
+    static const std::vector<std::string> names = {"source", "category"};
+    return names;
+}
+
+std::string FacetIndex::normalize_value(const std::string& raw) {
+    std::string value;
+    value.reserve(raw.size());
+
+    for (unsigned char c : raw) {
+        if (std::isalnum(c) || c >= 0x80) {
+            value += static_cast<char>(std::tolower(c));
+        } else if (c != '\'' && !value.empty() && value.back() != '_') {
+            value += '_';
+        }
+    }
+
+    while (!value.empty() && value.back() == '_') {
+        value.pop_back();
+    }
+
+    return value;
+}
+
+void FacetIndex::reset(uint32_t doc_count) {
+    this->doc_count = doc_count;
+    fields.clear();
+
+    for (const auto& name : field_names()) {
+        fields[name];
+    }
+}
+
+void FacetIndex::resize(uint32_t doc_count) {
+    this->doc_count = doc_count;
+
+    for (auto& [field, values] : fields) {
+        for (auto& [value, facet] : values) {
+            facet.bitmap->resize(doc_count);
+        }
+    }
+}
+
+void FacetIndex::add(const std::string& field, uint32_t doc_id, const std::string& value) {
+    std::string normalized = normalize_value(value);
+    if (normalized.empty() || doc_id >= doc_count) {
+        return;
+    }
+
+    if (normalized.size() > 255) {
+        normalized.resize(255);
+    }
+
+    auto& bitmap = fields[field][normalized].bitmap;
+    if (!bitmap) {
+        bitmap = std::make_shared<Bitmap>(doc_count);
+    }
+    bitmap->set(doc_id);
+}
+
+void FacetIndex::set(const std::string& field, const std::string& value, Bitmap bitmap) {
+    fields[field][value].bitmap = std::make_shared<Bitmap>(std::move(bitmap));
+}
+
+void FacetIndex::set(const std::string& field, const std::string& value,
+                     const uint32_t* doc_ids, uint32_t id_count) {
+    auto& facet = fields[field][value];
+    facet.doc_ids = doc_ids;
+    facet.id_count = id_count;
+}
+
+void FacetIndex::reorder(const std::vector<uint32_t>& order) {
+    uint32_t new_count = static_cast<uint32_t>(order.size());
+
+    for (auto& [field, values] : fields) {
+        for (auto it = values.begin(); it != values.end();) {
+            auto bitmap = std::make_shared<Bitmap>(new_count);
+            for (uint32_t i = 0; i < new_count; ++i) {
+                if (it->second.bitmap->test(order[i])) {
+                    bitmap->set(i);
+                }
+            }
+
+            if (bitmap->count() == 0) {
+                it = values.erase(it);
+            } else {
+                it->second.bitmap = std::move(bitmap);
+                ++it;
+            }
+        }
+    }
+
+    doc_count = new_count;
+}
+
+bool FacetIndex::has_field(const std::string& field) const {
+    return fields.count(field) > 0;
+}
+
+const FacetIndex::Value* FacetIndex::find(const std::string& field,
+                                          const std::string& value) const {
+    auto field_it = fields.find(field);
+    if (field_it == fields.end()) {
+        return nullptr;
+    }
+
+    auto value_it = field_it->second.find(value);
+    if (value_it == field_it->second.end()) {
+        return nullptr;
+    }
+
+    return &value_it->second;
+}
+
+const FacetIndex::ValueMap& FacetIndex::values(const std::string& field) const {
+    static const ValueMap empty;
+
+    auto it = fields.find(field);
+    return it == fields.end() ? empty : it->second;
+}
@@ -0,0 +1,137 @@
+#include "file_writer.hpp"
+#include "crc32c.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+FileWriter::FileWriter(const std::string& filename, size_t buffer_size)
+    : filename(filename), temp_filename(filename + ".tmp"), buffer(buffer_size) {
+    fd = ::open(temp_filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open file for writing: " + temp_filename);
+    }
+}
+
+FileWriter::~FileWriter() {
+    // Недописанный файл не должен остаться рядом с индексом
+    if (fd >= 0) {
+        ::close(fd);
+        ::unlink(temp_filename.c_str());
+    }
+}
+
+void FileWriter::write(const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+
+    if (size >= buffer.size()) {
+        flush();
+        write_at(flushed, bytes, size);
+        flushed += size;
+        return;
+    }
+
+    if (used + size > buffer.size()) {
+        flush();
+    }
+    std::memcpy(buffer.data() + used, bytes, size);
+    used += size;
+}
+
+void FileWriter::patch(uint64_t pos, const void* data, size_t size) {
+    if (pos + size > position()) {
+        throw std::runtime_error("Patch beyond the end of file: " + temp_filename);
+    }
+
+    const char* bytes = static_cast<const char*>(data);
+
+    // Часть уже в файле, часть еще в буфере
+    if (pos < flushed) {
+        size_t on_disk = static_cast<size_t>(std::min<uint64_t>(size, flushed - pos));
+        write_at(pos, bytes, on_disk);
+        pos += on_disk;
+        bytes += on_disk;
+        size -= on_disk;
+    }
+    if (size > 0) {
+        std::memcpy(buffer.data() + (pos - flushed), bytes, size);
+    }
+}
+
+std::vector<uint32_t> FileWriter::block_checksums(uint64_t from, uint64_t to,
+                                                  uint32_t block_size) {
+    flush();
+
+    std::vector<uint32_t> checksums;
+    std::vector<char> block(block_size);
+
+    for (uint64_t pos = from; pos < to; pos += block_size) {
+        size_t size = static_cast<size_t>(std::min<uint64_t>(block_size, to - pos));
+        size_t done = 0;
+
+        while (done < size) {
+            ssize_t n = ::pread(fd, block.data() + done, size - done, pos + done);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                throw std::runtime_error("Cannot read back " + temp_filename);
+            }
+            done += static_cast<size_t>(n);
+        }
+
+        checksums.push_back(crc32c(block.data(), size));
+    }
+
+    return checksums;
+}
+
+void FileWriter::commit() {
+    flush();
+
+    if (::fsync(fd) != 0) {
+        throw std::runtime_error("Cannot sync " + temp_filename + ": " + std::strerror(errno));
+    }
+    ::close(fd);
+    fd = -1;
+
+    if (::rename(temp_filename.c_str(), filename.c_str()) != 0) {
+        ::unlink(temp_filename.c_str());
+        throw std::runtime_error("Cannot replace " + filename + ": " + std::strerror(errno));
+    }
+
+    // Переименование попадает на диск вместе с записью каталога
+    size_t slash = filename.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : filename.substr(0, slash + 1);
+
+    int dir_fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dir_fd >= 0) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+}
+
+void FileWriter::flush() {
+    if (used > 0) {
+        write_at(flushed, buffer.data(), used);
+        flushed += used;
+        used = 0;
+    }
+}
+
+void FileWriter::write_at(uint64_t pos, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::pwrite(fd, data, size, pos);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            throw std::runtime_error("Failed to write " + temp_filename + ": " + std::strerror(errno));
+        }
+        data += n;
+        pos += n;
+        size -= n;
+    }
+}
@@ -0,0 +1,105 @@
+#include "forward_index.hpp"
+#include <limits>
+#include <stdexcept>
+
+ForwardIndex::ForwardIndex(const ForwardIndex& other) {
+    *this = other;
+}
+
+ForwardIndex& ForwardIndex::operator=(const ForwardIndex& other) {
+    if (this == &other) {
+        return *this;
+    }
+
+    own_offsets = other.own_offsets;
+    own_doc_lengths = other.own_doc_lengths;
+    own_strings = other.own_strings;
+    owned = other.owned;
+    doc_count = other.doc_count;
+
+    if (owned) {
+        attach_own();
+    } else {
+        offsets_data = other.offsets_data;
+        doc_lengths_data = other.doc_lengths_data;
+        strings_data = other.strings_data;
+        strings_bytes = other.strings_bytes;
+    }
+
+    return *this;
+}
+
+void ForwardIndex::clear() {
+    own_offsets.clear();
+    own_doc_lengths.clear();
+    own_strings.clear();
+    owned = true;
+    doc_count = 0;
+    attach_own();
+}
+
+void ForwardIndex::reserve(size_t doc_count, size_t string_bytes) {
+    own_offsets.reserve(doc_count * FIELD_COUNT + 1);
+    own_doc_lengths.reserve(doc_count);
+    own_strings.reserve(string_bytes);
+    attach_own();
+}
+
+void ForwardIndex::add(std::string_view id, std::string_view url, std::string_view title,
+                       uint32_t doc_length) {
+    if (!owned) {
+        throw std::runtime_error("Cannot add documents to a mapped forward index");
+    }
+
+    if (own_offsets.empty()) {
+        own_offsets.push_back(0);
+    }
+
+    append_string(id);
+    append_string(url);
+    append_string(title);
+    own_doc_lengths.push_back(doc_length);
+
+    doc_count++;
+    attach_own();
+}
+
+void ForwardIndex::reorder(const std::vector<uint32_t>& order) {
+    ForwardIndex reordered;
+    reordered.reserve(order.size(), strings_size());
+
+    for (uint32_t doc_id : order) {
+        reordered.add(get_id(doc_id), get_url(doc_id), get_title(doc_id), get_doc_length(doc_id));
+    }
+
+    *this = std::move(reordered);
+}
+
+ForwardIndex ForwardIndex::view(uint32_t doc_count, const uint32_t* offsets,
+                                const uint32_t* doc_lengths, const char* strings,
+                                uint64_t strings_size) {
+    ForwardIndex index;
+    index.owned = false;
+    index.doc_count = doc_count;
+    index.offsets_data = offsets;
+    index.doc_lengths_data = doc_lengths;
+    index.strings_data = strings;
+    index.strings_bytes = strings_size;
+    return index;
+}
+
+void ForwardIndex::attach_own() {
+    offsets_data = own_offsets.data();
+    doc_lengths_data = own_doc_lengths.data();
+    strings_data = own_strings.data();
+    strings_bytes = own_strings.size();
+}
+
+void ForwardIndex::append_string(std::string_view value) {
+    if (own_strings.size() + value.size() > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("Forward index strings exceed 4 GB");
+    }
+
+    own_strings.insert(own_strings.end(), value.begin(), value.end());
+    own_offsets.push_back(static_cast<uint32_t>(own_strings.size()));
+}
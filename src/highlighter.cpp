@@ -0,0 +1,171 @@
+#include "highlighter.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+bool is_word_byte(unsigned char c) {
+    return std::isalnum(c) || c >= 0x80;
+}
+
+bool is_continuation_byte(unsigned char c) {
+    return (c & 0xC0) == 0x80;
+}
+
+// Переводы строк и табуляции в сниппете заменяются пробелами
+void append_text(std::string& out, const std::string& text, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        char c = text[i];
+        out.push_back((c == '\n' || c == '\r' || c == '\t') ? ' ' : c);
+    }
+}
+
+}  // namespace
+
+Highlighter::Highlighter(Analyzer& analyzer) : analyzer(analyzer) {
+}
+
+void Highlighter::set_max_length(size_t length) {
+    max_length = std::max<size_t>(length, 20);
+}
+
+void Highlighter::set_markers(const std::string& before, const std::string& after) {
+    marker_before = before;
+    marker_after = after;
+}
+
+std::vector<Highlighter::Match> Highlighter::find_matches(
+    const std::string& content, const std::vector<std::string>& terms) {
+
+    std::vector<Match> matches;
+    std::string word;
+    size_t i = 0;
+
+    while (i < content.size()) {
+        if (!is_word_byte(static_cast<unsigned char>(content[i]))) {
+            i++;
+            continue;
+        }
+
+        size_t begin = i;
+        word.clear();
+        while (i < content.size() && is_word_byte(static_cast<unsigned char>(content[i]))) {
+            word.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(content[i]))));
+            i++;
+        }
+
+        const std::string& term = analyzer.normalize_token(word);
+        if (term.empty()) {
+            continue;
+        }
+
+        auto it = std::find(terms.begin(), terms.end(), term);
+        if (it != terms.end()) {
+            matches.push_back({begin, i, static_cast<size_t>(it - terms.begin())});
+        }
+    }
+
+    return matches;
+}
+
+std::string Highlighter::snippet(const std::string& content,
+                                 const std::vector<std::string>& terms) {
+    if (content.empty()) {
+        return "";
+    }
+
+    auto matches = find_matches(content, terms);
+
+    // Окно совпадений с наибольшим числом разных терминов (два указателя)
+    size_t best_first = 0, best_last = 0;
+    size_t best_distinct = 0, best_total = 0;
+
+    std::vector<size_t> counts(terms.size(), 0);
+    size_t distinct = 0;
+    size_t first = 0;
+
+    for (size_t last = 0; last < matches.size(); ++last) {
+        if (counts[matches[last].term]++ == 0) {
+            distinct++;
+        }
+
+        while (first < last && matches[last].end - matches[first].begin > max_length) {
+            if (--counts[matches[first].term] == 0) {
+                distinct--;
+            }
+            first++;
+        }
+
+        size_t total = last - first + 1;
+        if (distinct > best_distinct || (distinct == best_distinct && total > best_total)) {
+            best_distinct = distinct;
+            best_total = total;
+            best_first = first;
+            best_last = last;
+        }
+    }
+
+    // Центрируем окно вокруг найденных совпадений
+    size_t start = 0;
+    if (!matches.empty()) {
+        size_t span_begin = matches[best_first].begin;
+        size_t span_end = std::min(matches[best_last].end, span_begin + max_length);
+        size_t slack = max_length - (span_end - span_begin);
+        start = span_begin > slack / 2 ? span_begin - slack / 2 : 0;
+        if (start > 0 && start + max_length > content.size()) {
+            start = content.size() > max_length ? content.size() - max_length : 0;
+        }
+        start = std::min(start, span_begin);
+    }
+    size_t end = std::min(content.size(), start + max_length);
+
+    // Обрезаем по границам слов и не разрываем символы UTF-8
+    if (start > 0) {
+        size_t space = content.find(' ', start);
+        if (space != std::string::npos && space < end &&
+            (matches.empty() || space < matches[best_first].begin)) {
+            start = space + 1;
+        }
+        while (start < end && is_continuation_byte(static_cast<unsigned char>(content[start]))) {
+            start++;
+        }
+    }
+
+    if (end < content.size()) {
+        size_t space = content.rfind(' ', end);
+        if (space != std::string::npos && space > start &&
+            (matches.empty() || space >= matches[best_last].end)) {
+            end = space;
+        }
+        while (end > start && is_continuation_byte(static_cast<unsigned char>(content[end]))) {
+            end--;
+        }
+    }
+
+    std::string result;
+    result.reserve(end - start + 16);
+
+    if (start > 0) {
+        result += "...";
+    }
+
+    size_t pos = start;
+    for (const auto& match : matches) {
+        if (match.begin < start || match.end > end) {
+            continue;
+        }
+
+        append_text(result, content, pos, match.begin);
+        result += marker_before;
+        append_text(result, content, match.begin, match.end);
+        result += marker_after;
+        pos = match.end;
+    }
+    append_text(result, content, pos, end);
+
+    if (end < content.size()) {
+        result += "...";
+    }
+
+    return result;
+}
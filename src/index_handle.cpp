@@ -0,0 +1,151 @@
+#include "index_handle.hpp"
+#include <iostream>
+#include <stdexcept>
+#include <sys/stat.h>
+
+IndexHandle::IndexHandle(const std::string& filename, bool verify_checksums)
+    : filename(filename), verify_checksums(verify_checksums) {
+}
+
+IndexHandle::~IndexHandle() {
+    stop_watching();
+}
+
+bool IndexHandle::stat_file(const std::string& filename, FileVersion& version) {
+    struct stat st;
+    if (::stat(filename.c_str(), &st) != 0) {
+        return false;
+    }
+
+    version.device = st.st_dev;
+    version.inode = st.st_ino;
+    version.size = st.st_size;
+    version.mtime_ns = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    return true;
+}
+
+void IndexHandle::set_warmup(const IndexWarmup::Options& options) {
+    std::lock_guard<std::mutex> lock(reload_mutex);
+    warmup = options;
+    warmup_enabled = true;
+}
+
+bool IndexHandle::reload() {
+    std::lock_guard<std::mutex> lock(reload_mutex);
+
+    // Версия до загрузки: если файл заменят во время загрузки,
+    // следующая проверка увидит отличие и загрузит его еще раз
+    FileVersion version;
+    if (!stat_file(filename, version)) {
+        std::cerr << "Index file not found: " << filename << std::endl;
+        return false;
+    }
+
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->index.set_verify_checksums(verify_checksums);
+
+    if (!snapshot->index.load_index(filename)) {
+        failed_version = version;
+        return false;
+    }
+
+    // Запросы продолжают идти по старому снимку, пока новый прогревается
+    if (warmup_enabled) {
+        try {
+            snapshot->warmup = IndexWarmup::run(snapshot->index, warmup);
+            snapshot->warmed_up = true;
+        } catch (const std::exception& e) {
+            std::cerr << "Index warmup failed: " << e.what() << std::endl;
+        }
+    }
+
+    snapshot->generation = current_generation.load(std::memory_order_relaxed) + 1;
+    loaded_version = version;
+
+    // Старый снимок освобождается, когда его отпустит последний запрос
+    {
+        std::lock_guard<std::mutex> swap_lock(snapshot_mutex);
+        current = std::move(snapshot);
+    }
+    current_generation.store(current->generation, std::memory_order_release);
+
+    return true;
+}
+
+std::shared_ptr<const IndexHandle::Snapshot> IndexHandle::snapshot() const {
+    std::lock_guard<std::mutex> lock(snapshot_mutex);
+    return current;
+}
+
+void IndexHandle::start_watching(std::chrono::milliseconds interval) {
+    stop_watching();
+
+    stopping = false;
+    watcher = std::thread(&IndexHandle::watch_loop, this, interval);
+}
+
+void IndexHandle::stop_watching() {
+    if (!watcher.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(watch_mutex);
+        stopping = true;
+    }
+    watch_signal.notify_all();
+    watcher.join();
+}
+
+void IndexHandle::watch_loop(std::chrono::milliseconds interval) {
+    std::unique_lock<std::mutex> lock(watch_mutex);
+
+    while (!watch_signal.wait_for(lock, interval, [this] { return stopping; })) {
+        FileVersion version;
+        if (!stat_file(filename, version)) {
+            continue;
+        }
+
+        bool changed;
+        {
+            std::lock_guard<std::mutex> reload_lock(reload_mutex);
+            changed = !(version == loaded_version) && !(version == failed_version);
+        }
+
+        if (changed) {
+            lock.unlock();
+            if (!reload()) {
+                std::cerr << "Index reload failed, keeping the current version" << std::endl;
+            }
+            lock.lock();
+        }
+    }
+}
+
+SearchSession::SearchSession(const IndexHandle& handle, Configure configure)
+    : handle(handle), configure(std::move(configure)) {
+    if (!refresh()) {
+        throw std::runtime_error("Index is not loaded");
+    }
+}
+
+bool SearchSession::refresh() {
+    // Обычный случай - одно атомарное чтение
+    if (snapshot && handle.generation() == snapshot->generation) {
+        return false;
+    }
+
+    auto latest = handle.snapshot();
+    if (!latest || latest == snapshot) {
+        return false;
+    }
+
+    // Сначала поиск по старому снимку, потом сам снимок
+    search.reset();
+    snapshot = std::move(latest);
+    search = std::make_unique<BooleanSearch>(snapshot->index);
+    if (configure) {
+        configure(*search);
+    }
+    return true;
+}
@@ -0,0 +1,206 @@
+#include "index_warmup.hpp"
+#include "boolean_index.hpp"
+#include "boolean_search.hpp"
+#include "metrics.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+// Запрос из JSON-строки журнала медленных запросов (первое поле "query");
+// false, если поля нет или строка испорчена (без исключений)
+bool extract_json_query(const std::string& line, std::string& query) {
+    static const std::string key = "\"query\":\"";
+    size_t pos = line.find(key);
+    if (pos == std::string::npos) {
+        return false;
+    }
+
+    query.clear();
+    for (pos += key.size(); pos < line.size(); ++pos) {
+        char c = line[pos];
+        if (c == '"') {
+            return true;
+        }
+        if (c != '\\' || pos + 1 >= line.size()) {
+            query += c;
+            continue;
+        }
+
+        char escaped = line[++pos];
+        switch (escaped) {
+            case 'n': query += '\n'; break;
+            case 't': query += '\t'; break;
+            case 'r': query += '\r'; break;
+            case 'u': {
+                // SlowQueryLog экранирует так только управляющие символы;
+                // неверная или оборванная последовательность - строка пропускается
+                if (pos + 4 >= line.size()) {
+                    return false;
+                }
+                uint32_t code = 0;
+                for (size_t i = pos + 1; i <= pos + 4; ++i) {
+                    char digit = line[i];
+                    uint32_t value = digit >= '0' && digit <= '9' ? uint32_t(digit - '0')
+                                   : digit >= 'a' && digit <= 'f' ? uint32_t(digit - 'a' + 10)
+                                   : digit >= 'A' && digit <= 'F' ? uint32_t(digit - 'A' + 10)
+                                   : 16;
+                    if (value == 16) {
+                        return false;
+                    }
+                    code = code * 16 + value;
+                }
+                pos += 4;
+
+                // Символ вне ASCII - в UTF-8; суррогатные пары не поддерживаются
+                if (code < 0x80) {
+                    query += static_cast<char>(code);
+                } else if (code < 0x800) {
+                    query += static_cast<char>(0xC0 | (code >> 6));
+                    query += static_cast<char>(0x80 | (code & 0x3F));
+                } else if (code < 0xD800 || code > 0xDFFF) {
+                    query += static_cast<char>(0xE0 | (code >> 12));
+                    query += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    query += static_cast<char>(0x80 | (code & 0x3F));
+                } else {
+                    return false;
+                }
+                break;
+            }
+            default: query += escaped; break;
+        }
+    }
+
+    return false;  // Строка оборвана
+}
+
+}  // namespace
+
+std::string IndexWarmup::Report::summary() const {
+    std::ostringstream out;
+    out << "Index warmup: " << terms_prefetched << " frequent terms prefetched ("
+        << bytes_prefetched / 1024 << " KB)";
+    if (queries_available > 0) {
+        out << ", " << queries_replayed << " of " << queries_available
+            << " logged queries replayed";
+    }
+    out << " in " << std::fixed << std::setprecision(1) << duration_ms << " ms";
+    if (budget_exhausted) {
+        out << " (time budget exhausted)";
+    }
+    return out.str();
+}
+
+std::vector<std::string> IndexWarmup::read_top_queries(const std::string& filename, size_t limit,
+                                                       size_t* distinct) {
+    std::ifstream file(filename);
+    if (!file) {
+        throw std::runtime_error("Cannot open query log: " + filename);
+    }
+
+    // Запрос -> частота и номер первого появления
+    struct Seen {
+        size_t count = 0;
+        size_t first = 0;
+    };
+    std::unordered_map<std::string, Seen> seen;
+
+    std::string line;
+    std::string query;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+
+        if (line.front() == '{') {
+            if (!extract_json_query(line, query) || query.empty()) {
+                continue;
+            }
+        } else {
+            query = line;
+        }
+
+        auto [it, inserted] = seen.try_emplace(query);
+        if (inserted) {
+            it->second.first = seen.size() - 1;
+        }
+        it->second.count++;
+    }
+
+    if (distinct) {
+        *distinct = seen.size();
+    }
+
+    std::vector<std::pair<std::string, Seen>> ranked(seen.begin(), seen.end());
+    auto more_frequent = [](const auto& a, const auto& b) {
+        if (a.second.count != b.second.count) {
+            return a.second.count > b.second.count;
+        }
+        return a.second.first < b.second.first;
+    };
+
+    size_t count = std::min(limit, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(), more_frequent);
+
+    std::vector<std::string> queries;
+    queries.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        queries.push_back(std::move(ranked[i].first));
+    }
+    return queries;
+}
+
+IndexWarmup::Report IndexWarmup::run(const BooleanIndexBuilder& index, const Options& options) {
+    auto start_time = std::chrono::steady_clock::now();
+    auto deadline = start_time + std::chrono::nanoseconds(options.budget_ns);
+    Report report;
+
+    // Журнал читается до подсказок ядру: ошибка в имени файла видна сразу
+    std::vector<std::string> queries;
+    if (!options.query_log.empty() && options.top_queries > 0) {
+        queries = read_top_queries(options.query_log, options.top_queries,
+                                   &report.queries_available);
+    }
+
+    // Подсказки дешевые и не ждут диска: ядро читает страницы, пока
+    // повторяются запросы
+    auto prefetched = index.prefetch_frequent_terms(options.top_terms, deadline);
+    report.terms_prefetched = prefetched.terms;
+    report.bytes_prefetched = prefetched.bytes;
+
+    if (!queries.empty()) {
+        // Повтор - не настоящие запросы: задержки и счетчики поиска не пишутся
+        BooleanSearch searcher(index);
+        searcher.set_record_metrics(false);
+        for (const auto& query : queries) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                break;
+            }
+            searcher.search(query);
+            report.queries_replayed++;
+        }
+    }
+
+    auto end_time = std::chrono::steady_clock::now();
+    report.budget_exhausted = end_time >= deadline;
+    report.duration_ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+
+    auto& metrics = MetricsRegistry::global();
+    metrics.histogram("index_warmup_duration_seconds", "Index warmup time after load").record(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count());
+    metrics.counter("index_warmup_queries_total", "Queries replayed to warm up the index")
+        .add(report.queries_replayed);
+    metrics.counter("index_warmup_prefetched_bytes_total",
+                    "Index bytes requested with madvise(WILLNEED) during warmup")
+        .add(report.bytes_prefetched);
+
+    return report;
+}
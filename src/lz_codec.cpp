@@ -0,0 +1,166 @@
+#include "lz_codec.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+const size_t MIN_MATCH = 4;
+const size_t MAX_OFFSET = 65535;
+const size_t HASH_BITS = 14;
+// Последние байты всегда литералы, чтобы распаковка не читала за концом
+const size_t LAST_LITERALS = 5;
+
+uint32_t read32(const char* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint32_t hash4(uint32_t value) {
+    return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+void write_length(size_t length, std::string& output) {
+    while (length >= 255) {
+        output.push_back(static_cast<char>(255));
+        length -= 255;
+    }
+    output.push_back(static_cast<char>(length));
+}
+
+void write_sequence(const char* literals, size_t literal_length, size_t match_length,
+                    size_t offset, std::string& output) {
+    size_t match_code = match_length ? match_length - MIN_MATCH : 0;
+
+    uint8_t token = static_cast<uint8_t>((std::min<size_t>(literal_length, 15) << 4) |
+                                         std::min<size_t>(match_code, 15));
+    output.push_back(static_cast<char>(token));
+
+    if (literal_length >= 15) {
+        write_length(literal_length - 15, output);
+    }
+    output.append(literals, literal_length);
+
+    if (match_length == 0) {
+        return;
+    }
+
+    output.push_back(static_cast<char>(offset & 0xFF));
+    output.push_back(static_cast<char>(offset >> 8));
+
+    if (match_code >= 15) {
+        write_length(match_code - 15, output);
+    }
+}
+
+size_t read_length(const uint8_t*& in, const uint8_t* end) {
+    size_t length = 0;
+    uint8_t byte;
+    do {
+        if (in >= end) {
+            throw std::runtime_error("Corrupted compressed block");
+        }
+        byte = *in++;
+        length += byte;
+    } while (byte == 255);
+    return length;
+}
+
+}  // namespace
+
+void lz_compress(const char* input, size_t size, std::string& output) {
+    output.reserve(output.size() + size + size / 255 + 16);
+
+    if (size < MIN_MATCH + LAST_LITERALS) {
+        write_sequence(input, size, 0, 0, output);
+        return;
+    }
+
+    // Последняя позиция каждого хэша 4-байтовой последовательности
+    std::vector<uint32_t> table(size_t(1) << HASH_BITS, UINT32_MAX);
+
+    size_t anchor = 0;
+    size_t pos = 0;
+    size_t limit = size - LAST_LITERALS;
+
+    while (pos + MIN_MATCH <= limit) {
+        uint32_t sequence = read32(input + pos);
+        uint32_t& slot = table[hash4(sequence)];
+        size_t candidate = slot;
+        slot = static_cast<uint32_t>(pos);
+
+        if (candidate == UINT32_MAX || pos - candidate > MAX_OFFSET ||
+            read32(input + candidate) != sequence) {
+            pos++;
+            continue;
+        }
+
+        size_t match_length = MIN_MATCH;
+        while (pos + match_length < limit &&
+               input[candidate + match_length] == input[pos + match_length]) {
+            match_length++;
+        }
+
+        write_sequence(input + anchor, pos - anchor, match_length, pos - candidate, output);
+
+        pos += match_length;
+        anchor = pos;
+    }
+
+    write_sequence(input + anchor, size - anchor, 0, 0, output);
+}
+
+void lz_decompress(const char* input, size_t size, char* output, size_t raw_size) {
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(input);
+    const uint8_t* in_end = in + size;
+    size_t out = 0;
+
+    while (in < in_end) {
+        uint8_t token = *in++;
+
+        size_t literal_length = token >> 4;
+        if (literal_length == 15) {
+            literal_length += read_length(in, in_end);
+        }
+
+        if (literal_length > size_t(in_end - in) || literal_length > raw_size - out) {
+            throw std::runtime_error("Corrupted compressed block");
+        }
+        std::memcpy(output + out, in, literal_length);
+        in += literal_length;
+        out += literal_length;
+
+        if (in == in_end) {
+            break;
+        }
+
+        if (in_end - in < 2) {
+            throw std::runtime_error("Corrupted compressed block");
+        }
+        size_t offset = size_t(in[0]) | (size_t(in[1]) << 8);
+        in += 2;
+
+        size_t match_length = token & 0x0F;
+        if (match_length == 15) {
+            match_length += read_length(in, in_end);
+        }
+        match_length += MIN_MATCH;
+
+        if (offset == 0 || offset > out || match_length > raw_size - out) {
+            throw std::runtime_error("Corrupted compressed block");
+        }
+
+        // Совпадение может перекрываться с копируемой областью - копируем побайтно
+        const char* match = output + out - offset;
+        for (size_t i = 0; i < match_length; ++i) {
+            output[out + i] = match[i];
+        }
+        out += match_length;
+    }
+
+    if (out != raw_size) {
+        throw std::runtime_error("Corrupted compressed block");
+    }
+}
@@ -263,12 +263,14 @@
 #include "search_cli.hpp"
 
 int main(int argc, char* argv[]) {
-    std::cout << "=== Fashion Search Engine (Boolean Search) ===" << std::endl;
-    std::cout << "Built: " << __DATE__ << " " << __TIME__ << std::endl;
-    std::cout << std::string(50, '=') << std::endl;
-
     try {
         SearchCLI cli(argc, argv);
+
+        std::ostream& out = cli.messages();
+        out << "=== Fashion Search Engine (Boolean Search) ===" << std::endl;
+        out << "Built: " << __DATE__ << " " << __TIME__ << std::endl;
+        out << std::string(50, '=') << std::endl;
+
         return cli.run();
     } catch (const std::exception& e) {
         std::cerr << "Fatal error: " << e.what() << std::endl;
@@ -0,0 +1,225 @@
+#include "metrics.hpp"
+#include "text_format.hpp"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace {
+
+std::atomic<size_t> next_thread{0};
+
+// Границы корзин для Prometheus, в наносекундах (1 мкс - 10 с)
+const uint64_t EXPORT_BOUNDS[] = {
+    1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000,
+    1000000, 2500000, 5000000, 10000000, 25000000, 50000000, 100000000,
+    250000000, 500000000, 1000000000, 2500000000, 5000000000, 10000000000};
+
+std::string seconds(uint64_t ns) {
+    std::ostringstream out;
+    out << ns / 1e9;
+    return out.str();
+}
+
+// Имя с метками: name{labels} или name
+std::string series(const std::string& name, const std::string& labels,
+                   const std::string& extra = "") {
+    std::string all = labels;
+    if (!extra.empty()) {
+        all += (all.empty() ? "" : ",") + extra;
+    }
+    return all.empty() ? name : name + "{" + all + "}";
+}
+
+}  // namespace
+
+size_t metric_shard() {
+    thread_local size_t shard = next_thread.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS;
+    return shard;
+}
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t LatencyHistogram::bucket_lower(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    int exponent = static_cast<int>(index / SUB_BUCKETS) + SUB_BITS - 1;
+    return (index % SUB_BUCKETS + SUB_BUCKETS) << (exponent - SUB_BITS);
+}
+
+uint64_t LatencyHistogram::bucket_upper(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index + 1;
+    }
+    int exponent = static_cast<int>(index / SUB_BUCKETS) + SUB_BITS - 1;
+    return bucket_lower(index) + (uint64_t(1) << (exponent - SUB_BITS));
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    Snapshot snapshot;
+    snapshot.buckets.assign(BUCKETS, 0);
+
+    for (size_t s = 0; s < METRIC_SHARDS; ++s) {
+        const Shard& shard = shards[s];
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            snapshot.buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+        }
+        snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+    }
+
+    for (uint64_t count : snapshot.buckets) {
+        snapshot.count += count;
+    }
+    return snapshot;
+}
+
+uint64_t LatencyHistogram::Snapshot::value_at(double q) const {
+    if (count == 0) {
+        return 0;
+    }
+
+    uint64_t rank = static_cast<uint64_t>(std::ceil(q * count));
+    rank = std::max<uint64_t>(rank, 1);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return bucket_upper(i) - 1;
+        }
+    }
+    return max();
+}
+
+uint64_t LatencyHistogram::Snapshot::max() const {
+    for (size_t i = buckets.size(); i > 0; --i) {
+        if (buckets[i - 1] > 0) {
+            return bucket_upper(i - 1) - 1;
+        }
+    }
+    return 0;
+}
+
+MetricsRegistry& MetricsRegistry::global() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsRegistry::Family& MetricsRegistry::family(const std::string& name, const std::string& help,
+                                                 Type type) {
+    auto it = families.find(name);
+    if (it == families.end()) {
+        it = families.emplace(name, Family{type, help, {}, {}, {}}).first;
+    } else if (it->second.type != type) {
+        throw std::runtime_error("Metric registered with another type: " + name);
+    }
+    return it->second;
+}
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help,
+                                  const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& metric = family(name, help, Type::COUNTER).counters[labels];
+    if (!metric) {
+        metric = std::make_unique<Counter>();
+    }
+    return *metric;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help,
+                              const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& metric = family(name, help, Type::GAUGE).gauges[labels];
+    if (!metric) {
+        metric = std::make_unique<Gauge>();
+    }
+    return *metric;
+}
+
+LatencyHistogram& MetricsRegistry::histogram(const std::string& name, const std::string& help,
+                                             const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& metric = family(name, help, Type::HISTOGRAM).histograms[labels];
+    if (!metric) {
+        metric = std::make_unique<LatencyHistogram>();
+    }
+    return *metric;
+}
+
+std::string MetricsRegistry::to_prometheus() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ostringstream out;
+
+    for (const auto& [name, family] : families) {
+        static const char* const types[] = {"counter", "gauge", "histogram"};
+        out << "# HELP " << name << " " << family.help << "\n";
+        out << "# TYPE " << name << " " << types[static_cast<int>(family.type)] << "\n";
+
+        for (const auto& [labels, counter] : family.counters) {
+            out << series(name, labels) << " " << counter->value() << "\n";
+        }
+        for (const auto& [labels, gauge] : family.gauges) {
+            out << series(name, labels) << " " << gauge->value() << "\n";
+        }
+
+        // Корзины накопительные; корзина гистограммы попадает в первую
+        // границу, которая не меньше ее верхнего значения
+        for (const auto& [labels, histogram] : family.histograms) {
+            auto snapshot = histogram->snapshot();
+            uint64_t cumulative = 0;
+            size_t bucket = 0;
+
+            for (uint64_t bound : EXPORT_BOUNDS) {
+                while (bucket < snapshot.buckets.size() &&
+                       LatencyHistogram::bucket_upper(bucket) - 1 <= bound) {
+                    cumulative += snapshot.buckets[bucket++];
+                }
+                out << series(name + "_bucket", labels, "le=\"" + seconds(bound) + "\"")
+                    << " " << cumulative << "\n";
+            }
+            out << series(name + "_bucket", labels, "le=\"+Inf\"") << " " << snapshot.count << "\n";
+            out << series(name + "_sum", labels) << " " << snapshot.sum / 1e9 << "\n";
+            out << series(name + "_count", labels) << " " << snapshot.count << "\n";
+        }
+    }
+
+    return out.str();
+}
+
+std::string MetricsRegistry::to_text() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ostringstream out;
+
+    for (const auto& [name, family] : families) {
+        for (const auto& [labels, counter] : family.counters) {
+            out << "  " << std::left << std::setw(60) << series(name, labels) << std::right
+                << " " << counter->value() << "\n";
+        }
+        for (const auto& [labels, gauge] : family.gauges) {
+            out << "  " << std::left << std::setw(60) << series(name, labels) << std::right
+                << " " << gauge->value() << "\n";
+        }
+        for (const auto& [labels, histogram] : family.histograms) {
+            auto snapshot = histogram->snapshot();
+            if (snapshot.count == 0) {
+                continue;
+            }
+            out << "  " << std::left << std::setw(60) << series(name, labels) << std::right
+                << " count " << snapshot.count
+                << ", p50 " << format_ns(snapshot.value_at(0.5))
+                << ", p90 " << format_ns(snapshot.value_at(0.9))
+                << ", p99 " << format_ns(snapshot.value_at(0.99))
+                << ", max " << format_ns(snapshot.max()) << "\n";
+        }
+    }
+
+    return out.str();
+}
@@ -45,6 +45,10 @@ std::vector<Document> MongoConnector::fetch_documents(int limit) {
                 document.source = doc["source"].get_string().value.to_string();
             }
 
+            if (doc["category"]) {
+                document.category = doc["category"].get_string().value.to_string();
+            }
+
             if (doc["word_count"]) {
                 document.word_count = doc["word_count"].get_int32().value;
             }
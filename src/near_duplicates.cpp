@@ -0,0 +1,187 @@
+#include "near_duplicates.hpp"
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+namespace {
+
+// Подпись делится на MAX_DISTANCE + 2 блока: у подписей на расстоянии
+// <= MAX_DISTANCE различия задевают не больше MAX_DISTANCE блоков,
+// поэтому хотя бы два блока совпадают целиком
+const uint32_t BLOCK_COUNT = NearDuplicateDetector::MAX_DISTANCE + 2;
+
+// Защита от вырожденных групп (тысячи разных подписей с одинаковыми
+// 18-20 битами): сравниваются только ближайшие по подписи соседи. На
+// реальных данных группа - единицы документов, и окно не достигается
+const size_t GROUP_WINDOW = 256;
+
+uint32_t block_start(uint32_t block) { return block * 64 / BLOCK_COUNT; }
+
+uint64_t block_bits(uint64_t signature, uint32_t block) {
+    uint32_t width = block_start(block + 1) - block_start(block);
+    return (signature >> block_start(block)) & ((uint64_t(1) << width) - 1);
+}
+
+uint64_t hash_term(const std::string& term) {
+    // FNV-1a с перемешиванием (splitmix64), чтобы все 64 бита были равновероятны
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : term) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+
+    hash ^= hash >> 30;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94D049BB133111EBULL;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+uint32_t find_root(std::vector<uint32_t>& parent, uint32_t doc) {
+    while (parent[doc] != doc) {
+        parent[doc] = parent[parent[doc]];
+        doc = parent[doc];
+    }
+    return doc;
+}
+
+// Корень - меньший ID, поэтому представитель кластера - его первый документ
+void unite(std::vector<uint32_t>& parent, uint32_t a, uint32_t b) {
+    a = find_root(parent, a);
+    b = find_root(parent, b);
+    if (a != b) {
+        parent[std::max(a, b)] = std::min(a, b);
+    }
+}
+
+}  // namespace
+
+void NearDuplicateDetector::clear() {
+    signatures.clear();
+    comparable.clear();
+}
+
+void NearDuplicateDetector::add(const std::vector<std::string>& terms) {
+    signatures.push_back(simhash(terms));
+    comparable.push_back(terms.size() >= MIN_TERMS);
+}
+
+uint64_t NearDuplicateDetector::simhash(const std::vector<std::string>& terms) {
+    // Признаки - различные пары соседних терминов: общая лексика тематики
+    // (fashion, style) не делает похожими разные статьи
+    std::vector<uint64_t> shingles;
+    shingles.reserve(terms.size());
+
+    uint64_t previous = 0;
+    for (const auto& term : terms) {
+        uint64_t hash = hash_term(term);
+        shingles.push_back(hash ^ (previous * 0x9E3779B97F4A7C15ULL));
+        previous = hash;
+    }
+
+    std::sort(shingles.begin(), shingles.end());
+    shingles.erase(std::unique(shingles.begin(), shingles.end()), shingles.end());
+
+    // Каждый признак голосует за биты своего хеша: бит подписи равен 1,
+    // если у большинства признаков этот бит равен 1
+    uint32_t ones[64] = {};
+
+    for (uint64_t hash : shingles) {
+        for (int bit = 0; bit < 64; ++bit) {
+            ones[bit] += (hash >> bit) & 1;
+        }
+    }
+
+    uint64_t signature = 0;
+    for (int bit = 0; bit < 64; ++bit) {
+        if (ones[bit] * 2 > shingles.size()) {
+            signature |= uint64_t(1) << bit;
+        }
+    }
+    return signature;
+}
+
+std::vector<uint32_t> NearDuplicateDetector::clusters() const {
+    uint32_t doc_count = static_cast<uint32_t>(signatures.size());
+
+    std::vector<uint32_t> parent(doc_count);
+    std::iota(parent.begin(), parent.end(), 0);
+
+    // Одинаковые подписи объединяются сразу; дальше сравниваются только
+    // различные подписи (по представителю - первому документу)
+    std::vector<std::pair<uint64_t, uint32_t>> distinct;
+    for (uint32_t doc = 0; doc < doc_count; ++doc) {
+        if (comparable[doc]) {
+            distinct.emplace_back(signatures[doc], doc);
+        }
+    }
+    std::sort(distinct.begin(), distinct.end());
+
+    size_t unique_count = 0;
+    for (size_t i = 0; i < distinct.size(); ++i) {
+        if (unique_count > 0 && distinct[unique_count - 1].first == distinct[i].first) {
+            unite(parent, distinct[unique_count - 1].second, distinct[i].second);
+        } else {
+            distinct[unique_count++] = distinct[i];
+        }
+    }
+    distinct.resize(unique_count);
+
+    // Таблица на каждую пару блоков: подписи раскладываются подсчетом по
+    // битам двух блоков (не больше 20 бит). Проход идет по возрастанию
+    // номера в distinct, поэтому внутри группы подписи упорядочены и окно
+    // берет ближайших соседей
+    std::vector<uint32_t> keys(distinct.size());
+    std::vector<uint32_t> order(distinct.size());
+    std::vector<uint32_t> offsets;
+
+    for (uint32_t first = 0; first < BLOCK_COUNT; ++first) {
+        for (uint32_t second = first + 1; second < BLOCK_COUNT; ++second) {
+            uint32_t second_width = block_start(second + 1) - block_start(second);
+            uint32_t key_width = block_start(first + 1) - block_start(first) + second_width;
+
+            offsets.assign((size_t(1) << key_width) + 1, 0);
+            for (size_t i = 0; i < distinct.size(); ++i) {
+                keys[i] = static_cast<uint32_t>((block_bits(distinct[i].first, first) << second_width) |
+                                                block_bits(distinct[i].first, second));
+                offsets[keys[i] + 1]++;
+            }
+            for (size_t key = 1; key < offsets.size(); ++key) {
+                offsets[key] += offsets[key - 1];
+            }
+            for (size_t i = 0; i < distinct.size(); ++i) {
+                order[offsets[keys[i]]++] = static_cast<uint32_t>(i);
+            }
+
+            size_t group_start = 0;
+            for (size_t i = 1; i < order.size(); ++i) {
+                if (keys[order[i]] != keys[order[i - 1]]) {
+                    group_start = i;
+                    continue;
+                }
+
+                const auto& current = distinct[order[i]];
+                size_t from = i - std::min(i - group_start, GROUP_WINDOW);
+
+                for (size_t j = from; j < i; ++j) {
+                    const auto& other = distinct[order[j]];
+                    if (__builtin_popcountll(current.first ^ other.first) <= MAX_DISTANCE) {
+                        unite(parent, current.second, other.second);
+                    }
+                }
+            }
+        }
+    }
+
+    // Номера кластеров в порядке первых документов
+    std::vector<uint32_t> cluster_ids(doc_count);
+    uint32_t cluster_count = 0;
+
+    for (uint32_t doc = 0; doc < doc_count; ++doc) {
+        uint32_t root = find_root(parent, doc);
+        cluster_ids[doc] = root == doc ? cluster_count++ : cluster_ids[root];
+    }
+
+    return cluster_ids;
+}
@@ -0,0 +1,256 @@
+#include "numeric_column.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <array>
+#include <utility>
+
+namespace {
+
+inline uint32_t unpack(const uint8_t* data, uint64_t bit, uint64_t mask) {
+    // Значение не шире 32 бит со сдвигом до 7 всегда помещается в 8 байт
+    uint64_t word;
+    std::memcpy(&word, data + (bit >> 3), sizeof(word));
+    return static_cast<uint32_t>((word >> (bit & 7)) & mask);
+}
+
+// Одно сравнение без знака: from <= x <= to  <=>  x - from <= to - from.
+// Цикл без ветвлений, каждые 64 документа дают одно слово результата;
+// ширина - константа шаблона, поэтому сдвиги и маска известны компилятору.
+// Сканируются документы [first_word * 64, min(last_word * 64, doc_count))
+template<uint32_t Width>
+void scan_words(const uint8_t* data, uint32_t doc_count, size_t first_word, size_t last_word,
+                uint32_t from, uint32_t width, uint64_t* words) {
+    constexpr uint64_t mask = (uint64_t(1) << Width) - 1;
+    size_t full_words = std::min<size_t>(last_word, doc_count / 64);
+
+    for (size_t w = first_word; w < full_words; ++w) {
+        const uint64_t base = uint64_t(w) * 64 * Width;
+        uint64_t word = 0;
+        for (uint32_t j = 0; j < 64; ++j) {
+            uint32_t value = unpack(data, base + uint64_t(j) * Width, mask);
+            word |= uint64_t(value - from <= width) << j;
+        }
+        words[w] = word;
+    }
+
+    if (full_words >= last_word || doc_count % 64 == 0) {
+        return;
+    }
+
+    uint64_t word = 0;
+    for (uint32_t j = 0; j < doc_count % 64; ++j) {
+        uint32_t value = unpack(data, (uint64_t(full_words) * 64 + j) * Width, mask);
+        word |= uint64_t(value - from <= width) << j;
+    }
+    words[full_words] = word;
+}
+
+using ScanFunction = void (*)(const uint8_t*, uint32_t, size_t, size_t, uint32_t, uint32_t,
+                              uint64_t*);
+
+template<uint32_t... Widths>
+constexpr std::array<ScanFunction, sizeof...(Widths)> make_scan_table(
+    std::integer_sequence<uint32_t, Widths...>) {
+    return {&scan_words<Widths + 1>...};
+}
+
+void scan_range(uint32_t bit_width, const uint8_t* data, uint32_t doc_count, size_t first_word,
+                size_t last_word, uint32_t from, uint32_t width, uint64_t* words) {
+    // Ширина 1..32 (нулевая ширина обрабатывается до сканирования)
+    static constexpr auto table = make_scan_table(std::make_integer_sequence<uint32_t, 32>());
+    table[bit_width - 1](data, doc_count, first_word, last_word, from, width, words);
+}
+
+}  // namespace
+
+NumericColumn::NumericColumn(const NumericColumn& other) {
+    *this = other;
+}
+
+NumericColumn& NumericColumn::operator=(const NumericColumn& other) {
+    if (this == &other) {
+        return *this;
+    }
+
+    values = other.values;
+    own_data = other.own_data;
+    doc_count = other.doc_count;
+    bit_width = other.bit_width;
+    min_value = other.min_value;
+    max_value = other.max_value;
+    block_min = other.block_min;
+    block_max = other.block_max;
+    owned = other.owned;
+    data = owned ? own_data.data() : other.data;
+
+    return *this;
+}
+
+void NumericColumn::clear() {
+    values.clear();
+    own_data.clear();
+    doc_count = 0;
+    bit_width = 0;
+    min_value = 0;
+    max_value = 0;
+    block_min.clear();
+    block_max.clear();
+    data = nullptr;
+    owned = true;
+}
+
+void NumericColumn::add(uint32_t value) {
+    if (!owned) {
+        throw std::runtime_error("Cannot add values to a mapped numeric column");
+    }
+    values.push_back(value);
+}
+
+void NumericColumn::pack() {
+    if (!owned) {
+        return;
+    }
+
+    doc_count = static_cast<uint32_t>(values.size());
+    min_value = 0;
+    max_value = 0;
+
+    if (!values.empty()) {
+        auto [min_it, max_it] = std::minmax_element(values.begin(), values.end());
+        min_value = *min_it;
+        max_value = *max_it;
+    }
+
+    uint32_t span = max_value - min_value;
+    bit_width = span == 0 ? 0 : 32 - __builtin_clz(span);
+
+    own_data.assign(packed_size(), 0);
+
+    for (uint32_t i = 0; i < doc_count; ++i) {
+        uint64_t delta = values[i] - min_value;
+        uint64_t bit = uint64_t(i) * bit_width;
+
+        uint64_t word;
+        std::memcpy(&word, own_data.data() + (bit >> 3), sizeof(word));
+        word |= delta << (bit & 7);
+        std::memcpy(own_data.data() + (bit >> 3), &word, sizeof(word));
+    }
+
+    values.clear();
+    values.shrink_to_fit();
+    data = own_data.data();
+    build_blocks();
+}
+
+void NumericColumn::build_blocks() {
+    size_t block_count = (size_t(doc_count) + BLOCK_DOCS - 1) / BLOCK_DOCS;
+    block_min.assign(block_count, 0);
+    block_max.assign(block_count, 0);
+
+    if (bit_width == 0) {
+        return;
+    }
+
+    uint64_t mask = (uint64_t(1) << bit_width) - 1;
+    for (size_t block = 0; block < block_count; ++block) {
+        uint32_t begin = static_cast<uint32_t>(block * BLOCK_DOCS);
+        uint32_t end = std::min<uint32_t>(begin + BLOCK_DOCS, doc_count);
+
+        uint32_t low = UINT32_MAX;
+        uint32_t high = 0;
+        for (uint32_t i = begin; i < end; ++i) {
+            uint32_t value = unpack(data, uint64_t(i) * bit_width, mask);
+            low = std::min(low, value);
+            high = std::max(high, value);
+        }
+        block_min[block] = low;
+        block_max[block] = high;
+    }
+}
+
+void NumericColumn::reorder(const std::vector<uint32_t>& order) {
+    NumericColumn reordered;
+    for (uint32_t doc_id : order) {
+        reordered.add(get(doc_id));
+    }
+    reordered.pack();
+
+    *this = std::move(reordered);
+}
+
+NumericColumn NumericColumn::view(uint32_t doc_count, uint32_t bit_width, uint32_t min_value,
+                                  uint32_t max_value, const uint8_t* data) {
+    if (bit_width > 32) {
+        throw std::runtime_error("Invalid numeric column bit width");
+    }
+
+    NumericColumn column;
+    column.owned = false;
+    column.doc_count = doc_count;
+    column.bit_width = bit_width;
+    column.min_value = min_value;
+    column.max_value = max_value;
+    column.data = data;
+    column.build_blocks();
+    return column;
+}
+
+size_t NumericColumn::packed_size() const {
+    return (uint64_t(doc_count) * bit_width + 7) / 8 + sizeof(uint64_t);
+}
+
+uint32_t NumericColumn::get(uint32_t doc_id) const {
+    if (bit_width == 0) {
+        return min_value;
+    }
+
+    uint64_t mask = (uint64_t(1) << bit_width) - 1;
+    return min_value + unpack(data, uint64_t(doc_id) * bit_width, mask);
+}
+
+Bitmap NumericColumn::range(uint32_t low, uint32_t high) const {
+    if (doc_count == 0 || low > high || high < min_value || low > max_value) {
+        return Bitmap(doc_count);
+    }
+
+    // Границы в упакованных значениях (value - min_value)
+    uint32_t from = std::max(low, min_value) - min_value;
+    uint32_t to = std::min(high, max_value) - min_value;
+
+    std::vector<uint64_t> words((uint64_t(doc_count) + 63) / 64, 0);
+
+    // Диапазон покрывает все значения колонки
+    if (from == 0 && to == max_value - min_value) {
+        Bitmap all(doc_count, std::move(words));
+        all.flip();
+        return all;
+    }
+
+    // Блоки вне диапазона пропускаются, блоки целиком внутри заполняются
+    // без чтения значений; сканируются только блоки на границах
+    constexpr size_t block_words = BLOCK_DOCS / 64;
+    size_t word_count = words.size();
+    for (size_t block = 0; block < block_min.size(); ++block) {
+        if (block_max[block] < from || block_min[block] > to) {
+            continue;
+        }
+
+        size_t first_word = block * block_words;
+        size_t last_word = std::min(first_word + block_words, word_count);
+        if (block_min[block] >= from && block_max[block] <= to) {
+            std::fill(words.begin() + first_word, words.begin() + last_word, ~uint64_t(0));
+            continue;
+        }
+
+        scan_range(bit_width, data, doc_count, first_word, last_word, from, to - from,
+                   words.data());
+    }
+
+    // Заполненное последнее слово - только до doc_count
+    if (doc_count % 64 != 0) {
+        words.back() &= (uint64_t(1) << (doc_count % 64)) - 1;
+    }
+
+    return Bitmap(doc_count, std::move(words));
+}
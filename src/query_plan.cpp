@@ -0,0 +1,86 @@
+#include "query_plan.hpp"
+
+namespace {
+
+bool is_leaf(const QueryNode& node) {
+    return node.type == QueryNode::Type::TERM || node.type == QueryNode::Type::FILTER;
+}
+
+void append_node(const QueryNode& node, std::string& out) {
+    switch (node.type) {
+        case QueryNode::Type::TERM:
+        case QueryNode::Type::FILTER:
+            out += node.label;
+            return;
+        case QueryNode::Type::AND:
+            out += "(AND";
+            break;
+        case QueryNode::Type::OR:
+            out += "(OR";
+            break;
+        case QueryNode::Type::NOT:
+            out += "(NOT";
+            break;
+    }
+
+    for (const auto& child : node.children) {
+        out += ' ';
+        append_node(*child, out);
+    }
+    out += ')';
+}
+
+}  // namespace
+
+std::string plan_to_string(const QueryNode& node) {
+    std::string out;
+    append_node(node, out);
+    return out;
+}
+
+QueryShape plan_shape(const QueryNode& node) {
+    switch (node.type) {
+        case QueryNode::Type::TERM:
+            if (node.label.find('*') != std::string::npos) {
+                return QueryShape::WILDCARD;
+            }
+            if (node.label.find('~') != std::string::npos) {
+                return QueryShape::FUZZY;
+            }
+            return QueryShape::TERM;
+
+        case QueryNode::Type::FILTER:
+            return QueryShape::FILTER;
+
+        case QueryNode::Type::NOT:
+            return is_leaf(*node.children[0]) ? QueryShape::NOT : QueryShape::COMPLEX;
+
+        case QueryNode::Type::OR:
+            for (const auto& child : node.children) {
+                if (!is_leaf(*child)) {
+                    return QueryShape::COMPLEX;
+                }
+            }
+            return QueryShape::OR;
+
+        case QueryNode::Type::AND: {
+            bool negated = false;
+            for (const auto& child : node.children) {
+                if (child->type == QueryNode::Type::NOT && is_leaf(*child->children[0])) {
+                    negated = true;
+                } else if (!is_leaf(*child)) {
+                    return QueryShape::COMPLEX;
+                }
+            }
+            return negated ? QueryShape::NOT : QueryShape::AND;
+        }
+    }
+
+    return QueryShape::COMPLEX;
+}
+
+const char* shape_name(QueryShape shape) {
+    static const char* const names[] = {"term", "wildcard", "fuzzy", "filter",
+                                        "and", "or", "not", "complex"};
+    return names[static_cast<int>(shape)];
+}
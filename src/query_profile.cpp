@@ -0,0 +1,103 @@
+#include "query_profile.hpp"
+#include "text_format.hpp"
+#include <sstream>
+#include <iomanip>
+
+namespace {
+
+void append_text(const QueryProfile::Node& node, size_t depth, std::ostringstream& out) {
+    std::string name = std::string(depth * 2, ' ') + node.operation;
+    if (!node.label.empty()) {
+        name += " " + node.label;
+    }
+
+    out << "  " << std::left << std::setw(36) << name << std::right
+        << " out " << std::setw(8) << node.output_size
+        << "  eval " << std::setw(9) << format_ns(node.eval_ns);
+
+    if (node.lists_read > 0 || node.fetch_ns > 0) {
+        out << "  fetch " << format_ns(node.fetch_ns)
+            << ", lists " << node.lists_read
+            << ", postings " << node.postings_read
+            << ", bytes " << node.bytes_decoded;
+    }
+    if (node.skips > 0) {
+        out << "  skips " << node.skips;
+    }
+    out << "\n";
+
+    for (const auto& child : node.children) {
+        append_text(child, depth + 1, out);
+    }
+}
+
+void append_json(const QueryProfile::Node& node, std::ostringstream& out) {
+    out << "{\"op\":\"" << node.operation << "\"";
+    if (!node.label.empty()) {
+        out << ",\"label\":";
+        out << json_string(node.label);
+    }
+    out << ",\"out\":" << node.output_size
+        << ",\"eval_ns\":" << node.eval_ns;
+    if (node.lists_read > 0 || node.fetch_ns > 0) {
+        out << ",\"fetch_ns\":" << node.fetch_ns
+            << ",\"lists\":" << node.lists_read
+            << ",\"postings\":" << node.postings_read
+            << ",\"bytes_decoded\":" << node.bytes_decoded;
+    }
+    if (node.skips > 0) {
+        out << ",\"skips\":" << node.skips;
+    }
+    if (!node.children.empty()) {
+        out << ",\"children\":[";
+        for (size_t i = 0; i < node.children.size(); ++i) {
+            if (i > 0) {
+                out << ',';
+            }
+            append_json(node.children[i], out);
+        }
+        out << ']';
+    }
+    out << '}';
+}
+
+}  // namespace
+
+std::string profile_to_text(const QueryProfile& profile) {
+    std::ostringstream out;
+
+    if (!profile.error.empty()) {
+        out << "Query error: " << profile.error << "\n";
+        return out.str();
+    }
+
+    out << "Plan: " << profile.plan << "\n";
+    out << "Results: " << profile.result_count
+        << ", parse " << format_ns(profile.parse_ns)
+        << ", eval " << format_ns(profile.eval_ns)
+        << ", total " << format_ns(profile.total_ns) << "\n";
+    append_text(profile.root, 0, out);
+    return out.str();
+}
+
+std::string profile_to_json(const QueryProfile& profile) {
+    std::ostringstream out;
+    out << "{\"query\":";
+    out << json_string(profile.query);
+
+    if (!profile.error.empty()) {
+        out << ",\"error\":";
+        out << json_string(profile.error);
+    } else {
+        out << ",\"plan\":";
+        out << json_string(profile.plan);
+        out << ",\"results\":" << profile.result_count
+            << ",\"parse_ns\":" << profile.parse_ns
+            << ",\"eval_ns\":" << profile.eval_ns
+            << ",\"total_ns\":" << profile.total_ns
+            << ",\"root\":";
+        append_json(profile.root, out);
+    }
+    out << '}';
+    return out.str();
+}
@@ -0,0 +1,227 @@
+#include "result_writer.hpp"
+#include "forward_index.hpp"
+#include "file_writer.hpp"
+#include "text_format.hpp"
+#include <charconv>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+
+void append_number(std::string& out, uint64_t value) {
+    char buffer[24];
+    auto end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+    out.append(buffer, end);
+}
+
+void append_uint32(std::string& out, uint32_t value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+}  // namespace
+
+ResultWriter::Format ResultWriter::parse_format(const std::string& name) {
+    if (name == "text") {
+        return Format::TEXT;
+    }
+    if (name == "tsv") {
+        return Format::TSV;
+    }
+    if (name == "jsonl") {
+        return Format::JSONL;
+    }
+    if (name == "bin") {
+        return Format::BINARY;
+    }
+    throw std::runtime_error("Unknown output format: " + name);
+}
+
+void ResultWriter::append(Format format, std::string& out, const std::string& query,
+                          const std::vector<uint32_t>& doc_ids, const ForwardIndex& documents) {
+    switch (format) {
+        case Format::TEXT:
+            out += "Query: ";
+            out += query;
+            out += "\nResults: ";
+            append_number(out, doc_ids.size());
+            out += '\n';
+            // Строки читаются из прямого индекса без копий (как format_results)
+            for (uint32_t doc_id : doc_ids) {
+                if (doc_id >= documents.size()) {
+                    continue;
+                }
+                std::string_view title = documents.get_title(doc_id);
+                out += "  - ";
+                out += title.empty() ? std::string_view("Untitled Document") : title;
+                out += " (";
+                out += documents.get_url(doc_id);
+                out += ")\n";
+            }
+            out += '\n';
+            break;
+
+        case Format::TSV:
+            // Табуляции и переводы строк запроса ломают формат
+            for (char c : query) {
+                out += (c == '\t' || c == '\n' || c == '\r') ? ' ' : c;
+            }
+            out += '\t';
+            append_number(out, doc_ids.size());
+            out += '\t';
+            for (size_t i = 0; i < doc_ids.size(); ++i) {
+                if (i > 0) {
+                    out += ',';
+                }
+                append_number(out, doc_ids[i]);
+            }
+            out += '\n';
+            break;
+
+        case Format::JSONL:
+            out += "{\"query\":";
+            append_json_string(out, query);
+            out += ",\"count\":";
+            append_number(out, doc_ids.size());
+            out += ",\"doc_ids\":[";
+            for (size_t i = 0; i < doc_ids.size(); ++i) {
+                if (i > 0) {
+                    out += ',';
+                }
+                append_number(out, doc_ids[i]);
+            }
+            out += "]}\n";
+            break;
+
+        case Format::BINARY:
+            append_uint32(out, static_cast<uint32_t>(query.size()));
+            out += query;
+            append_uint32(out, static_cast<uint32_t>(doc_ids.size()));
+            out.append(reinterpret_cast<const char*>(doc_ids.data()),
+                       doc_ids.size() * sizeof(uint32_t));
+            break;
+    }
+}
+
+ResultWriter::ResultWriter(const std::string& filename, size_t queue_capacity)
+    : queue(queue_capacity) {
+    if (!filename.empty()) {
+        file = std::make_unique<FileWriter>(filename);
+    }
+    writer = std::thread(&ResultWriter::write_loop, this);
+}
+
+ResultWriter::~ResultWriter() {
+    // Без finish файл не публикуется (FileWriter удаляет временный)
+    stop();
+}
+
+void ResultWriter::submit(size_t sequence, std::string&& block, bool last) {
+    Block item{sequence, std::move(block), last};
+
+    // Результаты не теряются: при полной очереди ждем поток записи
+    while (!queue.try_push(std::move(item))) {
+        wake_signal.notify_one();
+        std::this_thread::yield();
+    }
+    wake_signal.notify_one();
+}
+
+void ResultWriter::finish() {
+    stop();
+
+    if (!error.empty()) {
+        throw std::runtime_error(error);
+    }
+    if (file) {
+        file->commit();
+    } else {
+        std::cout.flush();
+    }
+}
+
+void ResultWriter::stop() {
+    if (!writer.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        finishing = true;
+    }
+    wake_signal.notify_one();
+    writer.join();
+}
+
+void ResultWriter::write_loop() {
+    // Блоки, пришедшие раньше предыдущих, ждут своей очереди; части
+    // текущего блока пишутся сразу
+    struct Pending {
+        std::vector<std::string> parts;
+        bool complete = false;
+    };
+
+    std::map<size_t, Pending> pending;
+    size_t next_sequence = 0;
+    Block block;
+
+    auto write = [&](const std::string& data) {
+        if (!error.empty()) {
+            return;
+        }
+        try {
+            if (file) {
+                file->write(data.data(), data.size());
+            } else {
+                std::cout.write(data.data(), static_cast<std::streamsize>(data.size()));
+            }
+            written.fetch_add(data.size(), std::memory_order_relaxed);
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+    };
+
+    while (true) {
+        bool done;
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex);
+            done = finishing;
+        }
+
+        while (queue.try_pop(block)) {
+            auto& entry = pending[block.sequence];
+            entry.parts.push_back(std::move(block.data));
+            entry.complete = block.last;
+        }
+
+        while (!pending.empty() && pending.begin()->first == next_sequence) {
+            auto& entry = pending.begin()->second;
+            for (const auto& part : entry.parts) {
+                write(part);
+            }
+            entry.parts.clear();
+
+            if (!entry.complete) {
+                break;
+            }
+            pending.erase(pending.begin());
+            next_sequence++;
+        }
+
+        // finishing выставляется после последнего submit: все блоки уже забраны
+        if (done) {
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        if (!finishing) {
+            wake_signal.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
+
+    if (!pending.empty() && error.empty()) {
+        error = "Result blocks are missing from the output";
+    }
+}
@@ -0,0 +1,64 @@
+#include "scratch_arena.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+ScratchArena::ScratchArena(size_t initial_size)
+    : initial_size(std::clamp<size_t>(initial_size, 4096, MAX_RETAINED)) {
+    add_block(this->initial_size);
+}
+
+ScratchArena::~ScratchArena() {
+    release_blocks();
+}
+
+void ScratchArena::add_block(size_t size) {
+    blocks.push_back({static_cast<char*>(::operator new(size)), size});
+    reserved += size;
+}
+
+void ScratchArena::release_blocks() {
+    for (const auto& block : blocks) {
+        ::operator delete(block.data);
+    }
+    blocks.clear();
+    reserved = 0;
+}
+
+void ScratchArena::reset() {
+    // Несколько блоков - запрос перерос арену: дальше хватит одного не
+    // больше MAX_RETAINED (не меньше initial_size, он тоже ограничен).
+    // Единственный блок остается как есть
+    if (blocks.size() > 1) {
+        size_t size = std::min(reserved, MAX_RETAINED);
+        release_blocks();
+        add_block(size);
+    }
+
+    current = 0;
+    offset = 0;
+    used = 0;
+}
+
+void* ScratchArena::do_allocate(size_t bytes, size_t alignment) {
+    while (true) {
+        Block& block = blocks[current];
+        uintptr_t base = reinterpret_cast<uintptr_t>(block.data);
+        size_t start = ((base + offset + alignment - 1) & ~uintptr_t(alignment - 1)) - base;
+
+        if (start + bytes <= block.size) {
+            used += start - offset + bytes;
+            peak = std::max(peak, used);
+            offset = start + bytes;
+            return block.data + start;
+        }
+
+        // Остаток блока пропускается; новый блок вдвое больше последнего
+        used += block.size - offset;
+        if (current + 1 == blocks.size()) {
+            add_block(std::max(blocks.back().size * 2, bytes + alignment));
+        }
+        current++;
+        offset = 0;
+    }
+}
@@ -2,11 +2,18 @@
 #include "boolean_index.hpp"
 #include "boolean_search.hpp"
 #include "file_connector.hpp"
+#include "index_handle.hpp"
+#include "query_profile.hpp"
+#include "metrics.hpp"
+#include "slow_query_log.hpp"
+#include "result_writer.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
 #include <chrono>
+#include <thread>
+#include <atomic>
 
 SearchCLI::SearchCLI(int argc, char* argv[]) {
     if (!parse_arguments(argc, argv)) {
@@ -33,6 +40,59 @@ bool SearchCLI::parse_arguments(int argc, char* argv[]) {
             config.build_index = true;
         } else if (arg == "-s" || arg == "--stats") {
             config.show_stats = true;
+        } else if (arg == "--fuzzy") {
+            config.fuzzy = true;
+        } else if (arg == "--no-snippets") {
+            config.snippets = false;
+        } else if (arg == "--facets") {
+            config.show_facets = true;
+        } else if (arg == "--no-collapse") {
+            config.collapse = false;
+        } else if (arg == "--dedup") {
+            if (i + 1 < argc) {
+                config.dedup = argv[++i];
+            } else {
+                std::cerr << "Error: Missing mode after --dedup" << std::endl;
+                return false;
+            }
+            if (config.dedup != "none" && config.dedup != "collapse" && config.dedup != "drop") {
+                std::cerr << "Error: Unknown dedup mode: " << config.dedup << std::endl;
+                return false;
+            }
+        } else if (arg == "--order") {
+            if (i + 1 < argc) {
+                config.order = argv[++i];
+            } else {
+                std::cerr << "Error: Missing order after --order" << std::endl;
+                return false;
+            }
+            if (config.order != "input" && config.order != "url") {
+                std::cerr << "Error: Unknown document order: " << config.order << std::endl;
+                return false;
+            }
+        } else if (arg == "--hot-tier") {
+            if (i + 1 < argc) {
+                config.hot_tier = std::stoi(argv[++i]);
+            } else {
+                std::cerr << "Error: Missing size after --hot-tier" << std::endl;
+                return false;
+            }
+            if (config.hot_tier < 0) {
+                std::cerr << "Error: Invalid hot tier size: " << config.hot_tier << std::endl;
+                return false;
+            }
+        } else if (arg == "--watch") {
+            config.watch = true;
+        } else if (arg == "--verify") {
+            config.verify = true;
+        } else if (arg == "--ranked") {
+            config.ranked = true;
+        } else if (arg == "--profile") {
+            config.profile = true;
+        } else if (arg == "--count") {
+            config.count_only = true;
+        } else if (arg == "--exists") {
+            config.exists_only = true;
         } else if (arg == "-f" || arg == "--file") {
             if (i + 1 < argc) {
                 config.query_file = argv[++i];
@@ -54,6 +114,101 @@ bool SearchCLI::parse_arguments(int argc, char* argv[]) {
                 std::cerr << "Error: Missing number after --limit" << std::endl;
                 return false;
             }
+        } else if (arg == "--slow-log") {
+            if (i + 1 < argc) {
+                config.slow_log_file = argv[++i];
+            } else {
+                std::cerr << "Error: Missing filename after --slow-log" << std::endl;
+                return false;
+            }
+        } else if (arg == "--slow-ms") {
+            if (i + 1 < argc) {
+                config.slow_ms = std::stod(argv[++i]);
+            } else {
+                std::cerr << "Error: Missing threshold after --slow-ms" << std::endl;
+                return false;
+            }
+            if (config.slow_ms < 0) {
+                std::cerr << "Error: Invalid slow query threshold: " << config.slow_ms << std::endl;
+                return false;
+            }
+        } else if (arg == "--sample") {
+            if (i + 1 < argc) {
+                config.sample_every = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else {
+                std::cerr << "Error: Missing number after --sample" << std::endl;
+                return false;
+            }
+        } else if (arg == "--threads") {
+            if (i + 1 < argc) {
+                config.threads = std::stoi(argv[++i]);
+            } else {
+                std::cerr << "Error: Missing number after --threads" << std::endl;
+                return false;
+            }
+            if (config.threads < 1) {
+                std::cerr << "Error: Invalid number of threads: " << config.threads << std::endl;
+                return false;
+            }
+        } else if (arg == "--format") {
+            if (i + 1 < argc) {
+                config.format = argv[++i];
+            } else {
+                std::cerr << "Error: Missing format after --format" << std::endl;
+                return false;
+            }
+            if (config.format != "text" && config.format != "tsv" &&
+                config.format != "jsonl" && config.format != "bin") {
+                std::cerr << "Error: Unknown output format: " << config.format << std::endl;
+                return false;
+            }
+        } else if (arg == "--warmup") {
+            config.warmup = true;
+        } else if (arg == "--warmup-log") {
+            if (i + 1 < argc) {
+                config.warmup_log = argv[++i];
+                config.warmup = true;
+            } else {
+                std::cerr << "Error: Missing filename after --warmup-log" << std::endl;
+                return false;
+            }
+        } else if (arg == "--warmup-queries") {
+            if (i + 1 < argc) {
+                config.warmup_queries = std::stoi(argv[++i]);
+            } else {
+                std::cerr << "Error: Missing number after --warmup-queries" << std::endl;
+                return false;
+            }
+            if (config.warmup_queries < 0) {
+                std::cerr << "Error: Invalid number of warmup queries: " << config.warmup_queries
+                          << std::endl;
+                return false;
+            }
+        } else if (arg == "--warmup-ms") {
+            if (i + 1 < argc) {
+                config.warmup_ms = std::stod(argv[++i]);
+            } else {
+                std::cerr << "Error: Missing time after --warmup-ms" << std::endl;
+                return false;
+            }
+            if (config.warmup_ms < 0) {
+                std::cerr << "Error: Invalid warmup budget: " << config.warmup_ms << std::endl;
+                return false;
+            }
+        } else if (arg == "--metrics") {
+            if (i + 1 < argc) {
+                config.metrics_file = argv[++i];
+            } else {
+                std::cerr << "Error: Missing filename after --metrics" << std::endl;
+                return false;
+            }
+        } else if (arg == "--data") {
+            if (i + 1 < argc) {
+                config.data_file = argv[++i];
+            } else {
+                std::cerr << "Error: Missing filename after --data" << std::endl;
+                return false;
+            }
         } else if (arg == "--index") {
             if (i + 1 < argc) {
                 config.index_file = argv[++i];
@@ -75,19 +230,36 @@ bool SearchCLI::parse_arguments(int argc, char* argv[]) {
         }
     }
 
+    // Эти режимы печатают свой вывод сами, без ResultWriter
+    if ((config.threads > 1 || !config.format.empty()) &&
+        (config.count_only || config.exists_only || config.ranked || config.profile)) {
+        std::cerr << "Error: --threads and --format cannot be combined with "
+                  << "--count, --exists, --ranked or --profile" << std::endl;
+        return false;
+    }
+
     return true;
 }
 
+std::ostream& SearchCLI::messages() const {
+    bool results_on_stdout = !config.build_index && !config.show_stats && !config.interactive &&
+                             (config.threads > 1 || !config.format.empty()) &&
+                             config.output_file.empty();
+    return results_on_stdout ? std::cerr : std::cout;
+}
+
 int SearchCLI::run() {
+    int status = 1;
+
     try {
         if (config.build_index) {
-            return run_build_index();
+            status = run_build_index();
         } else if (config.show_stats) {
-            return run_show_stats();
+            status = run_show_stats();
         } else if (config.interactive) {
-            return run_interactive();
+            status = run_interactive();
         } else if (!config.query_file.empty()) {
-            return run_batch();
+            status = run_batch();
         } else {
             std::cerr << "Error: No operation specified\n" << std::endl;
             show_help();
@@ -95,14 +267,69 @@ int SearchCLI::run() {
         }
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
-        return 1;
     }
+
+    if (!config.metrics_file.empty()) {
+        save_metrics();
+    }
+    return status;
+}
+
+std::unique_ptr<SlowQueryLog> SearchCLI::open_slow_log() {
+    if (config.slow_log_file.empty()) {
+        return nullptr;
+    }
+
+    SlowQueryLog::Options options;
+    options.filename = config.slow_log_file;
+    options.threshold_ns = static_cast<uint64_t>(config.slow_ms * 1e6);
+    options.sample_every = config.sample_every;
+    return std::make_unique<SlowQueryLog>(options);
+}
+
+IndexWarmup::Options SearchCLI::warmup_options() const {
+    IndexWarmup::Options options;
+    options.query_log = config.warmup_log;
+    options.top_queries = static_cast<size_t>(config.warmup_queries);
+    options.budget_ns = static_cast<uint64_t>(config.warmup_ms * 1e6);
+    return options;
+}
+
+void SearchCLI::report_slow_log(const SlowQueryLog* log) {
+    if (!log) {
+        return;
+    }
+
+    messages() << "Slow query log: " << log->get_written() << " queries written to "
+               << log->get_filename();
+    if (log->get_dropped() > 0) {
+        messages() << " (" << log->get_dropped() << " dropped)";
+    }
+    messages() << std::endl;
+}
+
+void SearchCLI::save_metrics() {
+    std::string text = MetricsRegistry::global().to_prometheus();
+
+    // Результаты на стандартном выводе - метрики и сообщение в поток ошибок
+    if (config.metrics_file == "-") {
+        messages() << "\n" << text;
+        return;
+    }
+
+    std::ofstream outfile(config.metrics_file);
+    if (!outfile) {
+        std::cerr << "Cannot write metrics to " << config.metrics_file << std::endl;
+        return;
+    }
+    outfile << text;
+    messages() << "Metrics saved to: " << config.metrics_file << std::endl;
 }
 
 int SearchCLI::run_build_index() {
     std::cout << "Building index..." << std::endl;
 
-    FileConnector connector("fashion_data_compact.json");
+    FileConnector connector(config.data_file);
     auto documents = connector.fetch_documents();
 
     if (documents.empty()) {
@@ -114,6 +341,15 @@ int SearchCLI::run_build_index() {
 
     // Строим индекс
     BooleanIndexBuilder index_builder;
+    if (config.dedup == "collapse") {
+        index_builder.set_dedup_mode(BooleanIndexBuilder::DedupMode::COLLAPSE);
+    } else if (config.dedup == "drop") {
+        index_builder.set_dedup_mode(BooleanIndexBuilder::DedupMode::DROP);
+    }
+    if (config.order == "url") {
+        index_builder.set_document_order(BooleanIndexBuilder::DocumentOrder::URL);
+    }
+    index_builder.set_hot_tier_size(static_cast<uint32_t>(config.hot_tier));
     index_builder.build_from_documents(documents);
 
     index_builder.save_index(config.index_file);
@@ -127,6 +363,18 @@ int SearchCLI::run_build_index() {
               << stats.avg_term_length << " chars" << std::endl;
     std::cout << "  Avg doc length: " << stats.avg_doc_length << " terms" << std::endl;
     std::cout << "  Indexing time: " << stats.indexing_time_ms << " ms" << std::endl;
+    std::cout << "  Postings: " << stats.postings_bytes / 1024 << " KB" << std::endl;
+    std::cout << "  Scratch arena peak: " << stats.scratch_peak_bytes / 1024 << " KB per document"
+              << std::endl;
+
+    if (stats.content_stored_bytes > 0) {
+        std::cout << "  Content store: " << stats.content_stored_bytes / 1024 << " KB ("
+                  << stats.content_raw_bytes / 1024 << " KB raw text)" << std::endl;
+    }
+
+    if (stats.duplicate_documents > 0) {
+        std::cout << "  Near-duplicates: " << stats.duplicate_documents << std::endl;
+    }
 
     return 0;
 }
@@ -135,6 +383,7 @@ int SearchCLI::run_show_stats() {
     std::cout << "Loading index: " << config.index_file << std::endl;
 
     BooleanIndexBuilder index_builder;
+    index_builder.set_verify_checksums(config.verify);
     if (!index_builder.load_index(config.index_file)) {
         std::cerr << "Failed to load index" << std::endl;
         return 1;
@@ -150,28 +399,61 @@ int SearchCLI::run_show_stats() {
     std::cout << "  Avg doc length: " << stats.avg_doc_length << " terms" << std::endl;
     std::cout << "  Indexing time: " << stats.indexing_time_ms << " ms" << std::endl;
 
+    if (stats.content_stored_bytes > 0) {
+        std::cout << "  Content store: " << stats.content_stored_bytes / 1024 << " KB ("
+                  << stats.content_raw_bytes / 1024 << " KB raw text)" << std::endl;
+    }
+
+    if (stats.duplicate_documents > 0) {
+        std::cout << "  Near-duplicates: " << stats.duplicate_documents << std::endl;
+    }
+
     return 0;
 }
 
 int SearchCLI::run_interactive() {
     std::cout << "Loading index: " << config.index_file << std::endl;
 
-    BooleanIndexBuilder index_builder;
-    if (!index_builder.load_index(config.index_file)) {
+    IndexHandle handle(config.index_file, config.verify);
+    if (config.warmup) {
+        handle.set_warmup(warmup_options());
+    }
+    if (!handle.reload()) {
         std::cerr << "Failed to load index" << std::endl;
         return 1;
     }
 
-    BooleanSearch searcher(index_builder);
+    // Новая версия индекса подхватывается между запросами
+    if (config.watch) {
+        handle.start_watching(std::chrono::seconds(1));
+    }
+
+    auto slow_log = open_slow_log();
+
+    SearchSession session(handle, [this, &slow_log](BooleanSearch& searcher) {
+        searcher.set_fuzzy_fallback(config.fuzzy);
+        searcher.set_collapse_duplicates(config.collapse);
+        searcher.set_query_log(slow_log.get());
+    });
+
+    if (const IndexWarmup::Report* warmup = session.warmup()) {
+        std::cout << warmup->summary() << std::endl;
+    }
 
     std::cout << "\n=== Boolean Search Interactive Mode ===" << std::endl;
-    std::cout << "Index loaded: " << index_builder.get_statistics().total_documents
+    std::cout << "Index loaded: " << session.index().get_statistics().total_documents
               << " documents" << std::endl;
     std::cout << "Type 'quit' or 'exit' to quit" << std::endl;
-    std::cout << "Supported operators: AND (&&), OR (||), NOT (!), parentheses" << std::endl;
+    std::cout << "Supported operators: AND (&&), OR (||), NOT (!), parentheses, wildcards (*)" << std::endl;
     std::cout << "Example: fashion AND (design || trend) !shoes" << std::endl;
     std::cout << std::string(60, '=') << std::endl;
 
+    // Запрос, для которого можно показать следующую страницу, и курсор
+    // следующей страницы
+    std::string page_query;
+    std::string page_cursor;
+    size_t shown = 0;
+
     while (true) {
         std::cout << "\nQuery: ";
         std::string query;
@@ -185,6 +467,17 @@ int SearchCLI::run_interactive() {
             break;
         }
 
+        // Курсор прежней версии индекса не подходит к новой
+        if (session.refresh()) {
+            std::cout << "Index updated: " << session.index().get_statistics().total_documents
+                      << " documents (version " << session.generation() << ")" << std::endl;
+            if (const IndexWarmup::Report* warmup = session.warmup()) {
+                std::cout << warmup->summary() << std::endl;
+            }
+            page_cursor.clear();
+        }
+        BooleanSearch& searcher = session.searcher();
+
         if (query == "help") {
             std::cout << "\nBoolean Search Syntax:" << std::endl;
             std::cout << "  fashion design          - implicit AND" << std::endl;
@@ -192,53 +485,243 @@ int SearchCLI::run_interactive() {
             std::cout << "  fashion || design       - OR" << std::endl;
             std::cout << "  !shoes                  - NOT" << std::endl;
             std::cout << "  (fashion || style) && design - parentheses" << std::endl;
+            std::cout << "  desig*                  - prefix" << std::endl;
+            std::cout << "  *sign*                  - infix" << std::endl;
+            std::cout << "  desgn~1                 - up to 1 typo (default 2)" << std::endl;
+            std::cout << "  source:wikipedia        - filter by source or category" << std::endl;
+            std::cout << "  words:[500 TO 2000]     - filter by word count (* for open bound)" << std::endl;
+            std::cout << "  more                    - next page of the last query" << std::endl;
+            std::cout << "  explain QUERY           - execution plan with per-operator costs" << std::endl;
+            std::cout << "  metrics                 - counters and latency percentiles" << std::endl;
             continue;
         }
 
+        if (query == "metrics") {
+            std::cout << MetricsRegistry::global().to_text();
+            continue;
+        }
+
+        // EXPLAIN: план и показатели узлов без вывода результатов
+        if (query.size() > 8 && (query.compare(0, 8, "explain ") == 0 ||
+                                 query.compare(0, 8, "EXPLAIN ") == 0)) {
+            std::cout << profile_to_text(searcher.explain(query.substr(8)));
+            continue;
+        }
+
+        if (query == "more" || query == "next") {
+            if (page_cursor.empty()) {
+                std::cout << "No more results" << std::endl;
+                continue;
+            }
+
+            // Следующая страница продолжает обход с курсора, без пересчета
+            // уже показанных
+            auto page = searcher.search_page(page_query, page_cursor, config.limit_results);
+            print_page(searcher, page.doc_ids, page_query, shown);
+
+            shown += page.doc_ids.size();
+            page_cursor = page.next_cursor;
+
+            if (!page_cursor.empty()) {
+                std::cout << "\n(type 'more' for the next page)" << std::endl;
+            }
+            continue;
+        }
+
+        // Первая страница и общее количество: полный список результатов
+        // не строится
         auto start_time = std::chrono::high_resolution_clock::now();
-        auto results = searcher.search(query);
+        size_t total = searcher.count(query);
+        auto page = searcher.search_page(query, "", config.limit_results);
         auto end_time = std::chrono::high_resolution_clock::now();
 
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-            end_time - start_time).count();
+        double duration = std::chrono::duration<double, std::milli>(end_time - start_time).count();
 
-        std::cout << "\nFound " << results.size() << " results in "
+        std::cout << "\nFound " << total << " results in "
                   << duration << " ms" << std::endl;
 
-        if (!results.empty()) {
-            auto formatted = searcher.format_results(results, 0, config.limit_results);
+        page_cursor.clear();
+        shown = 0;
 
-            for (size_t i = 0; i < formatted.size(); ++i) {
-                const auto& result = formatted[i];
-                std::cout << "\n" << (i + 1) << ". " << result.title << std::endl;
-                std::cout << "    URL: " << result.url << std::endl;
-                std::cout << "    Doc ID: " << result.doc_id << std::endl;
+        if (!page.doc_ids.empty()) {
+            print_page(searcher, page.doc_ids, query, 0);
+
+            page_query = query;
+            page_cursor = page.next_cursor;
+            shown = page.doc_ids.size();
+
+            if (!page_cursor.empty()) {
+                std::cout << "\n... and " << (total - std::min(total, shown))
+                          << " more results (type 'more' for the next page)" << std::endl;
             }
 
-            if (results.size() > config.limit_results) {
-                std::cout << "\n... and " << (results.size() - config.limit_results)
-                          << " more results (use --limit to show more)" << std::endl;
+            if (config.show_facets) {
+                print_facets(searcher, query);
             }
         }
 
+        if (config.profile) {
+            std::cout << "\n" << profile_to_text(searcher.explain(query));
+        }
+
         if (!config.output_file.empty()) {
-            save_results(results, query, config.output_file);
+            save_results(searcher.search(query), query, config.output_file);
+        }
+    }
+
+    report_slow_log(slow_log.get());
+    return 0;
+}
+
+void SearchCLI::print_page(BooleanSearch& searcher, const std::vector<uint32_t>& doc_ids,
+                           const std::string& query, size_t first_number) {
+    auto formatted = searcher.format_results(doc_ids, 0, doc_ids.size());
+    if (config.snippets) {
+        searcher.add_snippets(formatted, query);
+    }
+
+    for (size_t i = 0; i < formatted.size(); ++i) {
+        const auto& result = formatted[i];
+        std::cout << "\n" << (first_number + i + 1) << ". " << result.title << std::endl;
+        std::cout << "    URL: " << result.url << std::endl;
+        std::cout << "    Doc ID: " << result.doc_id << std::endl;
+        if (!result.snippet.empty()) {
+            std::cout << "    " << result.snippet << std::endl;
+        }
+    }
+}
+
+void SearchCLI::print_facets(BooleanSearch& searcher, const std::string& query) {
+    for (const auto& [field, counts] : searcher.facet_counts(query)) {
+        if (counts.empty()) {
+            continue;
+        }
+
+        std::cout << "  " << field << ":";
+        for (size_t i = 0; i < counts.size() && i < 10; ++i) {
+            std::cout << " " << counts[i].value << " (" << counts[i].count << ")";
+        }
+        if (counts.size() > 10) {
+            std::cout << " ...";
+        }
+        std::cout << std::endl;
+    }
+}
+
+int SearchCLI::run_count(BooleanSearch& searcher, const std::vector<std::string>& queries) {
+    auto batch_start = std::chrono::high_resolution_clock::now();
+
+    for (size_t i = 0; i < queries.size(); ++i) {
+        std::cout << "\nQuery " << (i + 1) << ": \"" << queries[i] << "\"" << std::endl;
+
+        if (config.exists_only) {
+            std::cout << "  Exists: " << (searcher.exists(queries[i]) ? "yes" : "no") << std::endl;
+        } else {
+            std::cout << "  Results: " << searcher.count(queries[i]) << std::endl;
+        }
+    }
+
+    auto batch_end = std::chrono::high_resolution_clock::now();
+    double total_time = std::chrono::duration<double, std::milli>(batch_end - batch_start).count();
+
+    std::cout << "\nBatch processing completed in " << total_time << " ms" << std::endl;
+
+    return 0;
+}
+
+int SearchCLI::run_ranked(BooleanSearch& searcher, const std::vector<std::string>& queries) {
+    auto batch_start = std::chrono::high_resolution_clock::now();
+    size_t full_tier_queries = 0;
+
+    for (size_t i = 0; i < queries.size(); ++i) {
+        auto ranked = searcher.search_ranked(queries[i], std::max(config.limit_results, 0));
+        full_tier_queries += searcher.get_last_stats().full_tier_used;
+
+        std::vector<uint32_t> doc_ids;
+        for (const auto& doc : ranked) {
+            doc_ids.push_back(doc.doc_id);
+        }
+
+        auto formatted = searcher.format_results(doc_ids, 0, doc_ids.size());
+        for (size_t j = 0; j < formatted.size(); ++j) {
+            formatted[j].relevance = ranked[j].score;
+        }
+        if (config.snippets) {
+            searcher.add_snippets(formatted, queries[i]);
+        }
+
+        std::cout << "\nQuery " << (i + 1) << ": \"" << queries[i] << "\"" << std::endl;
+        std::cout << "  Top " << formatted.size() << " results" << std::endl;
+
+        for (size_t j = 0; j < formatted.size(); ++j) {
+            std::cout << "    " << (j + 1) << ". " << formatted[j].title << " ("
+                      << std::fixed << std::setprecision(3) << formatted[j].relevance << ")" << std::endl;
+            if (!formatted[j].snippet.empty()) {
+                std::cout << "       " << formatted[j].snippet << std::endl;
+            }
         }
     }
 
+    auto batch_end = std::chrono::high_resolution_clock::now();
+    double total_time = std::chrono::duration<double, std::milli>(batch_end - batch_start).count();
+
+    std::cout << "\nBatch processing completed in " << total_time << " ms" << std::endl;
+    std::cout << "Queries answered from the hot tier: " << (queries.size() - full_tier_queries)
+              << " of " << queries.size() << std::endl;
+
+    return 0;
+}
+
+int SearchCLI::run_profile(BooleanSearch& searcher, const std::vector<std::string>& queries) {
+    // Профиль запроса - строка JSON, в --output или на стандартный вывод
+    std::ofstream outfile;
+    if (!config.output_file.empty()) {
+        outfile.open(config.output_file);
+        if (!outfile) {
+            std::cerr << "Cannot write profiles to " << config.output_file << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = outfile.is_open() ? outfile : std::cout;
+
+    uint64_t total_ns = 0;
+    for (const auto& query : queries) {
+        auto profile = searcher.explain(query);
+        total_ns += profile.total_ns;
+        out << profile_to_json(profile) << "\n";
+    }
+
+    if (outfile.is_open()) {
+        std::cout << "Profiles saved to: " << config.output_file << std::endl;
+    }
+    std::cout << "Profiled " << queries.size() << " queries in " << total_ns / 1e6 << " ms"
+              << std::endl;
+
     return 0;
 }
 
 int SearchCLI::run_batch() {
-    std::cout << "Loading index: " << config.index_file << std::endl;
+    std::ostream& info = messages();
+    info << "Loading index: " << config.index_file << std::endl;
 
     BooleanIndexBuilder index_builder;
-    if (!index_builder.load_index(config.index_file)) {
+    index_builder.set_verify_checksums(config.verify);
+
+    // Индекс сообщает о загрузке в std::cout - на это время туда же,
+    // куда остальные служебные сообщения
+    std::streambuf* saved = std::cout.rdbuf(info.rdbuf());
+    bool loaded = index_builder.load_index(config.index_file);
+    std::cout.rdbuf(saved);
+    if (!loaded) {
         std::cerr << "Failed to load index" << std::endl;
         return 1;
     }
 
-    BooleanSearch searcher(index_builder);
+    if (config.warmup) {
+        info << IndexWarmup::run(index_builder, warmup_options()).summary() << std::endl;
+    }
+
+    auto slow_log = open_slow_log();
     std::vector<std::string> queries;
 
     // Проверяем, является ли query_file именем файла или самим запросом
@@ -257,56 +740,166 @@ int SearchCLI::run_batch() {
         queries.push_back(config.query_file);
     }
 
-    std::cout << "Processing " << queries.size() << " queries..." << std::endl;
+    info << "Processing " << queries.size() << " queries..." << std::endl;
+
+    // У потоков конвейера свои BooleanSearch
+    if (config.threads > 1 || !config.format.empty()) {
+        int status = run_pipeline(index_builder, queries, slow_log.get());
+        report_slow_log(slow_log.get());
+        return status;
+    }
+
+    BooleanSearch searcher(index_builder);
+    searcher.set_fuzzy_fallback(config.fuzzy);
+    searcher.set_collapse_duplicates(config.collapse);
+    searcher.set_query_log(slow_log.get());
+
+    if (config.count_only || config.exists_only) {
+        return run_count(searcher, queries);
+    }
+
+    if (config.ranked) {
+        return run_ranked(searcher, queries);
+    }
+
+    if (config.profile) {
+        return run_profile(searcher, queries);
+    }
 
     auto batch_start = std::chrono::high_resolution_clock::now();
     auto batch_results = searcher.batch_search(queries);
     auto batch_end = std::chrono::high_resolution_clock::now();
 
-    auto total_time = std::chrono::duration_cast<std::chrono::milliseconds>(
-        batch_end - batch_start).count();
+    double total_time = std::chrono::duration<double, std::milli>(batch_end - batch_start).count();
+
+    // Полные результаты в файл пишет отдельный поток, пока печатается сводка
+    std::unique_ptr<ResultWriter> writer;
+    if (!config.output_file.empty()) {
+        writer = std::make_unique<ResultWriter>(config.output_file);
+    }
+    std::string block;
+    size_t blocks = 0;
 
+    // Сводка без сброса буфера на каждой строке
     for (size_t i = 0; i < batch_results.size(); ++i) {
         const auto& [query, results] = batch_results[i];
-        std::cout << "\nQuery " << (i + 1) << ": \"" << query << "\"" << std::endl;
-        std::cout << "  Results: " << results.size() << std::endl;
+        std::cout << "\nQuery " << (i + 1) << ": \"" << query << "\"\n";
+        std::cout << "  Results: " << results.size() << "\n";
 
         if (!results.empty() && config.limit_results > 0) {
             auto formatted = searcher.format_results(results, 0,
                                                      std::min(config.limit_results, 5));
+            if (config.snippets) {
+                searcher.add_snippets(formatted, query);
+            }
 
             for (size_t j = 0; j < formatted.size(); ++j) {
-                std::cout << "    " << (j + 1) << ". " << formatted[j].title << std::endl;
+                std::cout << "    " << (j + 1) << ". " << formatted[j].title << "\n";
+                if (!formatted[j].snippet.empty()) {
+                    std::cout << "       " << formatted[j].snippet << "\n";
+                }
             }
 
             if (results.size() > formatted.size()) {
                 std::cout << "    ... and " << (results.size() - formatted.size())
-                          << " more" << std::endl;
+                          << " more\n";
+            }
+
+            if (config.show_facets) {
+                print_facets(searcher, query);
+            }
+        }
+
+        if (writer) {
+            ResultWriter::append(ResultWriter::Format::TEXT, block, query, results,
+                                 index_builder.get_forward_index());
+            if (block.size() >= (1 << 20) || i + 1 == batch_results.size()) {
+                writer->submit(blocks++, std::move(block));
+                block = std::string();
             }
         }
     }
 
     std::cout << "\nBatch processing completed in " << total_time << " ms" << std::endl;
     std::cout << "Average time per query: "
-              << (queries.empty() ? 0 : total_time / queries.size()) << " ms" << std::endl;
+              << (queries.empty() ? 0.0 : total_time / queries.size()) << " ms" << std::endl;
+    std::cout << "Scratch arena peak: " << searcher.get_scratch_peak() / 1024 << " KB per query"
+              << std::endl;
+    report_slow_log(slow_log.get());
+
+    if (writer) {
+        writer->finish();
+        std::cout << "Results saved to: " << config.output_file << std::endl;
+    }
 
-    if (!config.output_file.empty()) {
-        std::ofstream outfile(config.output_file);
-        if (outfile) {
-            for (const auto& [query, results] : batch_results) {
-                outfile << "Query: " << query << "\n";
-                outfile << "Results: " << results.size() << "\n";
-
-                auto formatted = searcher.format_results(results, 0, results.size());
-                for (const auto& result : formatted) {
-                    outfile << "  - " << result.title << " (" << result.url << ")\n";
-                }
+    return 0;
+}
 
-                outfile << "\n";
+int SearchCLI::run_pipeline(const BooleanIndexBuilder& index,
+                            const std::vector<std::string>& queries,
+                            SlowQueryLog* slow_log) {
+    auto format = ResultWriter::parse_format(config.format.empty() ? "text" : config.format);
+    ResultWriter writer(config.output_file);
+
+    // Потоки берут запросы блоками; блок форматируется в буфер потока
+    // и уходит писателю целиком
+    const size_t chunk_size = 64;
+    const size_t chunks = (queries.size() + chunk_size - 1) / chunk_size;
+    std::atomic<size_t> next_chunk{0};
+    std::atomic<size_t> total_results{0};
+
+    auto worker = [&]() {
+        BooleanSearch searcher(index);
+        searcher.set_fuzzy_fallback(config.fuzzy);
+        searcher.set_collapse_duplicates(config.collapse);
+        searcher.set_query_log(slow_log);
+
+        size_t chunk;
+        while ((chunk = next_chunk.fetch_add(1, std::memory_order_relaxed)) < chunks) {
+            std::string block;
+            size_t results_in_chunk = 0;
+
+            size_t end = std::min(queries.size(), (chunk + 1) * chunk_size);
+            for (size_t i = chunk * chunk_size; i < end; ++i) {
+                auto results = searcher.search(queries[i]);
+                results_in_chunk += results.size();
+                ResultWriter::append(format, block, queries[i], results, index.get_forward_index());
+
+                // Большие выдачи уходят писателю частями, буфер не растет
+                if (block.size() >= (1 << 20) && i + 1 < end) {
+                    writer.submit(chunk, std::move(block), false);
+                    block = std::string();
+                }
             }
-            outfile.close();
-            std::cout << "Results saved to: " << config.output_file << std::endl;
+
+            total_results.fetch_add(results_in_chunk, std::memory_order_relaxed);
+            writer.submit(chunk, std::move(block));
         }
+    };
+
+    auto batch_start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < config.threads; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    writer.finish();
+
+    auto batch_end = std::chrono::high_resolution_clock::now();
+    double total_time = std::chrono::duration<double, std::milli>(batch_end - batch_start).count();
+
+    // Результаты на стандартном выводе - сводка в поток ошибок
+    std::ostream& summary = messages();
+    summary << "\nBatch processing completed in " << total_time << " ms ("
+            << config.threads << " threads)" << std::endl;
+    summary << "Results: " << total_results.load() << " documents, "
+            << writer.bytes_written() / 1024 << " KB written" << std::endl;
+    if (!config.output_file.empty()) {
+        summary << "Results saved to: " << config.output_file << std::endl;
     }
 
     return 0;
@@ -315,13 +908,16 @@ int SearchCLI::run_batch() {
 void SearchCLI::save_results(const std::vector<uint32_t>& doc_ids,
                              const std::string& query,
                              const std::string& filename) {
-    std::ofstream outfile(filename, std::ios::app);
-    if (outfile) {
-        outfile << "Query: " << query << "\n";
-        outfile << "Results: " << doc_ids.size() << "\n";
-        outfile << "Timestamp: " << std::chrono::system_clock::now().time_since_epoch().count()
-                << "\n\n";
-        outfile.close();
+    // Файл открывается при первом запросе, запись буферизуется
+    if (!results_file.is_open()) {
+        results_file.open(filename, std::ios::app);
+    }
+
+    if (results_file) {
+        results_file << "Query: " << query << "\n";
+        results_file << "Results: " << doc_ids.size() << "\n";
+        results_file << "Timestamp: " << std::chrono::system_clock::now().time_since_epoch().count()
+                     << "\n\n";
     }
 }
 
@@ -334,14 +930,40 @@ void SearchCLI::show_help() {
     std::cout << "  -i, --interactive       Run in interactive mode" << std::endl;
     std::cout << "  -b, --build             Build index from data file" << std::endl;
     std::cout << "  -s, --stats             Show index statistics" << std::endl;
+    std::cout << "  --fuzzy                 Correct typos in terms without results" << std::endl;
+    std::cout << "  --no-snippets           Do not show text snippets in results" << std::endl;
+    std::cout << "  --facets                Show result counts by source and category" << std::endl;
+    std::cout << "  --no-collapse           Show near-duplicate documents separately" << std::endl;
+    std::cout << "  --dedup MODE            Near-duplicates when building: none, collapse, drop" << std::endl;
+    std::cout << "  --order ORDER           Document ID order when building: input, url" << std::endl;
+    std::cout << "  --hot-tier K            Keep top K documents of frequent terms in a hot tier" << std::endl;
+    std::cout << "  --watch                 Reload the index in interactive mode when it is rebuilt" << std::endl;
+    std::cout << "  --verify                Verify index checksums while reading" << std::endl;
+    std::cout << "  --ranked                Show top results (--limit) ranked by term weights" << std::endl;
+    std::cout << "  --profile               Print per-query execution profiles (JSON lines in batch mode)" << std::endl;
+    std::cout << "  --count                 Print only the number of results" << std::endl;
+    std::cout << "  --exists                Print only whether a query has results" << std::endl;
     std::cout << "  -f, --file FILE         Read queries from file" << std::endl;
     std::cout << "  -o, --output FILE       Save results to file" << std::endl;
+    std::cout << "  --threads N             Search threads for batch mode (results via --format)" << std::endl;
+    std::cout << "  --format FORMAT         Batch output: text, tsv, jsonl, bin (doc ID arrays)" << std::endl;
     std::cout << "  -l, --limit N           Limit results to N (default: 50)" << std::endl;
     std::cout << "  --index FILE            Specify index file (default: fashion_index.bin)" << std::endl;
+    std::cout << "  --data FILE             Documents for --build (default: fashion_data_compact.json)" << std::endl;
+    std::cout << "  --slow-log FILE         Log slow queries with per-operator plan timings (JSON lines)" << std::endl;
+    std::cout << "  --slow-ms MS            Slow query threshold for --slow-log (default: 100)" << std::endl;
+    std::cout << "  --sample N              Also log every N-th query to --slow-log" << std::endl;
+    std::cout << "  --warmup                Prefetch the dictionary and frequent posting lists after load" << std::endl;
+    std::cout << "  --warmup-log FILE       Also replay the most frequent queries of a query log (implies --warmup)" << std::endl;
+    std::cout << "  --warmup-queries K      Logged queries to replay (default: 100)" << std::endl;
+    std::cout << "  --warmup-ms MS          Warmup time budget (default: 2000)" << std::endl;
+    std::cout << "  --metrics FILE          Write metrics in Prometheus text format on exit (- for stdout)" << std::endl;
     std::cout << "\nExamples:" << std::endl;
     std::cout << "  Build index:            fashion_search_engine --build" << std::endl;
     std::cout << "  Interactive search:     fashion_search_engine --interactive" << std::endl;
     std::cout << "  Single query:           fashion_search_engine \"fashion AND design\"" << std::endl;
     std::cout << "  Batch search:           fashion_search_engine --file queries.txt" << std::endl;
+    std::cout << "  Profile queries:        fashion_search_engine --profile --file queries.txt -o profiles.jsonl" << std::endl;
+    std::cout << "  Warm start:             fashion_search_engine --warmup-log queries.txt --interactive" << std::endl;
     std::cout << "  Show stats:             fashion_search_engine --stats" << std::endl;
 }
\ No newline at end of file
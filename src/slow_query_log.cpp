@@ -0,0 +1,94 @@
+#include "slow_query_log.hpp"
+#include "metrics.hpp"
+#include <chrono>
+#include <stdexcept>
+
+SlowQueryLog::SlowQueryLog(const Options& options)
+    : options(options), queue(options.capacity) {
+    out.open(options.filename, std::ios::app);
+    if (!out) {
+        throw std::runtime_error("Cannot open slow query log: " + options.filename);
+    }
+
+    writer = std::thread(&SlowQueryLog::write_loop, this);
+}
+
+SlowQueryLog::~SlowQueryLog() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        stopping = true;
+    }
+    wake_signal.notify_one();
+    writer.join();
+}
+
+SlowQueryLog::Reason SlowQueryLog::classify(uint64_t total_ns) {
+    if (total_ns >= options.threshold_ns) {
+        return Reason::SLOW;
+    }
+    if (options.sample_every > 0 &&
+        query_number.fetch_add(1, std::memory_order_relaxed) % options.sample_every == 0) {
+        return Reason::SAMPLED;
+    }
+    return Reason::NONE;
+}
+
+void SlowQueryLog::submit(Reason reason, QueryProfile&& profile) {
+    static Counter& slow = MetricsRegistry::global().counter(
+        "slow_query_log_entries_total", "Queries queued for the slow query log", "reason=\"slow\"");
+    static Counter& sampled = MetricsRegistry::global().counter(
+        "slow_query_log_entries_total", "Queries queued for the slow query log", "reason=\"sampled\"");
+    static Counter& lost = MetricsRegistry::global().counter(
+        "slow_query_log_dropped_total", "Slow query log entries dropped on a full queue");
+
+    Entry entry;
+    entry.reason = reason;
+    entry.unix_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    entry.profile = std::move(profile);
+
+    if (!queue.try_push(std::move(entry))) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        lost.add();
+        return;
+    }
+
+    (reason == Reason::SLOW ? slow : sampled).add();
+    wake_signal.notify_one();
+}
+
+void SlowQueryLog::write_loop() {
+    Entry entry;
+
+    while (true) {
+        bool any = false;
+        while (queue.try_pop(entry)) {
+            write_entry(entry);
+            any = true;
+        }
+
+        // Очередь опустела - запись видна в файле до следующего запроса
+        if (any) {
+            out.flush();
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        if (stopping) {
+            break;
+        }
+        wake_signal.wait_for(lock, std::chrono::milliseconds(100));
+    }
+
+    // Записи, поставленные до остановки
+    while (queue.try_pop(entry)) {
+        write_entry(entry);
+    }
+    out.flush();
+}
+
+void SlowQueryLog::write_entry(const Entry& entry) {
+    out << "{\"time_ms\":" << entry.unix_ms
+        << ",\"reason\":\"" << (entry.reason == Reason::SLOW ? "slow" : "sampled")
+        << "\",\"profile\":" << profile_to_json(entry.profile) << "}\n";
+    written.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,62 @@
+#include "term_matching.hpp"
+#include <vector>
+#include <algorithm>
+
+bool wildcard_match(std::string_view pattern, std::string_view term) {
+    size_t p = 0, t = 0;
+    size_t star = std::string_view::npos, star_t = 0;
+
+    while (t < term.size()) {
+        if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            star_t = t;
+        } else if (p < pattern.size() && pattern[p] == term[t]) {
+            p++;
+            t++;
+        } else if (star != std::string_view::npos) {
+            p = star + 1;
+            t = ++star_t;
+        } else {
+            return false;
+        }
+    }
+
+    while (p < pattern.size() && pattern[p] == '*') {
+        p++;
+    }
+
+    return p == pattern.size();
+}
+
+uint32_t bounded_edit_distance(std::string_view a, std::string_view b, uint32_t max_edits) {
+    size_t length_diff = a.size() > b.size() ? a.size() - b.size() : b.size() - a.size();
+    if (length_diff > max_edits) {
+        return max_edits + 1;
+    }
+
+    std::vector<uint32_t> row(b.size() + 1);
+    for (size_t j = 0; j <= b.size(); ++j) {
+        row[j] = static_cast<uint32_t>(j);
+    }
+
+    for (size_t i = 1; i <= a.size(); ++i) {
+        uint32_t diagonal = row[0];
+        row[0] = static_cast<uint32_t>(i);
+        uint32_t row_min = row[0];
+
+        for (size_t j = 1; j <= b.size(); ++j) {
+            uint32_t above = row[j];
+            row[j] = std::min({above + 1, row[j - 1] + 1,
+                               diagonal + (a[i - 1] == b[j - 1] ? 0u : 1u)});
+            diagonal = above;
+            row_min = std::min(row_min, row[j]);
+        }
+
+        // Все значения строки уже больше порога - дальше только больше
+        if (row_min > max_edits) {
+            return max_edits + 1;
+        }
+    }
+
+    return std::min(row[b.size()], max_edits + 1);
+}
@@ -0,0 +1,45 @@
+#include "text_format.hpp"
+#include <cstdio>
+
+void append_json_string(std::string& out, const std::string& text) {
+    out += '"';
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buffer[8];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                    out += buffer;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+std::string json_string(const std::string& text) {
+    std::string out;
+    out.reserve(text.size() + 2);
+    append_json_string(out, text);
+    return out;
+}
+
+std::string format_ns(uint64_t ns) {
+    char buffer[32];
+    if (ns < 1000) {
+        std::snprintf(buffer, sizeof(buffer), "%llu ns", static_cast<unsigned long long>(ns));
+    } else if (ns < 1000000) {
+        std::snprintf(buffer, sizeof(buffer), "%.1f us", ns / 1e3);
+    } else if (ns < 1000000000) {
+        std::snprintf(buffer, sizeof(buffer), "%.2f ms", ns / 1e6);
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%.2f s", ns / 1e9);
+    }
+    return buffer;
+}
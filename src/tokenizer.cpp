@@ -42,7 +42,7 @@ TokenizationResult Tokenizer::tokenize(const std::string& text) {
     }
 
     auto end_time = std::chrono::high_resolution_clock::now();
-    result.processing_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+    result.processing_time_ms = std::chrono::duration<double, std::milli>(
         end_time - start_time).count();
 
     return result;
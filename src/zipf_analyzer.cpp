@@ -3,20 +3,16 @@
 #include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <limits>
 
 ZipfAnalysis ZipfAnalyzer::analyze(const std::vector<std::string>& tokens) {
     ZipfAnalysis result;
 
-    // Подсчет частот с использованием нашей хеш-таблицы
+    // Подсчет частот с использованием нашей хеш-таблицы: один поиск на токен
     HashTable<std::string, int> frequency_table(10007);
 
     for (const auto& token : tokens) {
-        int count = 0;
-        if (frequency_table.get(token, count)) {
-            frequency_table.insert(token, count + 1);
-        } else {
-            frequency_table.insert(token, 1);
-        }
+        frequency_table[token]++;
     }
 
     // Получаем все пары и сортируем по частоте
@@ -89,4 +85,52 @@ std::vector<double> ZipfAnalyzer::calculate_mandelbrot(const ZipfAnalysis& analy
     }
 
     return predictions;
+}
+
+MandelbrotFit ZipfAnalyzer::fit_mandelbrot(const ZipfAnalysis& analysis) {
+    MandelbrotFit best;
+    if (analysis.rank_freq_pairs.size() < 2) {
+        return best;
+    }
+
+    best.error = std::numeric_limits<double>::infinity();
+
+    for (double B = 0.0; B <= 100.0; B = (B < 1.0) ? B + 0.25 : B * 1.25) {
+        double sum_w = 0, sum_x = 0, sum_y = 0, sum_xx = 0, sum_xy = 0;
+        for (const auto& [rank, freq] : analysis.rank_freq_pairs) {
+            double w = 1.0 / rank;
+            double x = std::log(rank + B);
+            double y = std::log(freq);
+            sum_w += w;
+            sum_x += w * x;
+            sum_y += w * y;
+            sum_xx += w * x * x;
+            sum_xy += w * x * y;
+        }
+
+        double denominator = sum_w * sum_xx - sum_x * sum_x;
+        if (denominator <= 0) {
+            continue;
+        }
+
+        double slope = (sum_w * sum_xy - sum_x * sum_y) / denominator;
+        double alpha = -slope;
+        double C = std::exp((sum_y - slope * sum_x) / sum_w);
+
+        // Ошибка по предсказаниям модели с этими параметрами
+        auto predictions = calculate_mandelbrot(analysis, C, B, alpha);
+        double error = 0.0;
+        for (size_t i = 0; i < predictions.size(); ++i) {
+            const auto& [rank, freq] = analysis.rank_freq_pairs[i];
+            double diff = std::log(predictions[i]) - std::log(freq);
+            error += diff * diff / rank;
+        }
+        error /= sum_w;
+
+        if (error < best.error) {
+            best = {C, B, alpha, error};
+        }
+    }
+
+    return best;
 }
\ No newline at end of file
@@ -0,0 +1,239 @@
+// Генератор синтетического корпуса и журнала запросов (CorpusGenerator).
+// Документы пишутся в JSON (--out) или сразу передаются построителю
+// индекса (--index), журнал запросов - по запросу в строке (--query-log,
+// формат --file поисковой программы). Параметры распределений можно
+// подобрать по настоящим документам (--fit).
+//
+// Построитель держит весь индекс в памяти до записи: около 2 КБ на
+// документ модели по умолчанию (1 млн документов - около 2 ГБ).
+//
+// Примеры:
+//   generate_corpus --docs 1000000 --index synthetic_index.bin
+//   generate_corpus --fit fashion_data_compact.json --docs 100000 --out synthetic.json
+//   generate_corpus --docs 0 --queries 10000 --mix and=50,or=20,not=20,term=10 --query-log q.txt
+
+#include "corpus_generator.hpp"
+#include "boolean_index.hpp"
+#include "file_connector.hpp"
+#include "text_format.hpp"
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace {
+
+struct Options {
+    size_t documents = 100000;
+    size_t queries = 0;
+    uint64_t seed = 42;
+    std::string fit_file;
+    std::string out_file;
+    std::string index_file;
+    std::string query_log_file;
+    std::string mix;
+    int hot_tier = 0;
+    CorpusModel model;
+    size_t vocabulary = 0;  // 0 - из модели
+    double alpha = 0.0;     // 0 - из модели
+};
+
+void show_help() {
+    std::cout << "Synthetic corpus and query log generator\n" << std::endl;
+    std::cout << "Usage:" << std::endl;
+    std::cout << "  generate_corpus [OPTIONS]\n" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --docs N                Number of documents (default: 100000)" << std::endl;
+    std::cout << "  --out FILE              Write documents as JSON" << std::endl;
+    std::cout << "  --index FILE            Stream documents into the index builder and save the index" << std::endl;
+    std::cout << "                          (built in memory: about 2 KB per document)" << std::endl;
+    std::cout << "  --hot-tier K            Hot tier size of the built index" << std::endl;
+    std::cout << "  --queries N             Number of queries in the query log" << std::endl;
+    std::cout << "  --query-log FILE        Write queries, one per line" << std::endl;
+    std::cout << "  --mix SPEC              Query mix weights: term=35,and=30,or=15,not=15,wildcard=5" << std::endl;
+    std::cout << "  --fit FILE              Fit term frequencies and document lengths to a data file" << std::endl;
+    std::cout << "  --vocab N               Vocabulary size (default: 100000 or fitted)" << std::endl;
+    std::cout << "  --alpha X               Zipf exponent (default: 1.0 or fitted)" << std::endl;
+    std::cout << "  --seed N                Random seed (default: 42)" << std::endl;
+}
+
+bool parse_arguments(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            return false;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Error: Missing value after " << arg << std::endl;
+            return false;
+        }
+
+        std::string value = argv[++i];
+        if (arg == "--docs") {
+            options.documents = std::stoull(value);
+        } else if (arg == "--out") {
+            options.out_file = value;
+        } else if (arg == "--index") {
+            options.index_file = value;
+        } else if (arg == "--hot-tier") {
+            options.hot_tier = std::stoi(value);
+        } else if (arg == "--queries") {
+            options.queries = std::stoull(value);
+        } else if (arg == "--query-log") {
+            options.query_log_file = value;
+        } else if (arg == "--mix") {
+            options.mix = value;
+        } else if (arg == "--fit") {
+            options.fit_file = value;
+        } else if (arg == "--vocab") {
+            options.vocabulary = std::stoull(value);
+        } else if (arg == "--alpha") {
+            options.alpha = std::stod(value);
+        } else if (arg == "--seed") {
+            options.seed = std::stoull(value);
+        } else {
+            std::cerr << "Error: Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (options.documents > 0 && options.out_file.empty() && options.index_file.empty()) {
+        std::cerr << "Error: Specify --out and/or --index for documents" << std::endl;
+        return false;
+    }
+    if (options.queries > 0 && options.query_log_file.empty()) {
+        std::cerr << "Error: Specify --query-log for queries" << std::endl;
+        return false;
+    }
+    if (options.hot_tier < 0) {
+        std::cerr << "Error: Invalid hot tier size: " << options.hot_tier << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Один документ на строку, поля как в Document
+void write_document(std::ostream& out, const Document& doc) {
+    out << "{\"id\": ";
+    out << json_string(doc.id);
+    out << ", \"url\": ";
+    out << json_string(doc.url);
+    out << ", \"title\": ";
+    out << json_string(doc.title);
+    out << ", \"source\": ";
+    out << json_string(doc.source);
+    out << ", \"category\": ";
+    out << json_string(doc.category);
+    out << ", \"word_count\": " << doc.word_count << ", \"content\": ";
+    out << json_string(doc.content);
+    out << "}";
+}
+
+int generate(Options& options) {
+    if (!options.fit_file.empty()) {
+        FileConnector connector(options.fit_file);
+        auto sample = connector.fetch_documents();
+        options.model = CorpusModel::fit(sample);
+
+        std::cout << "Fitted to " << sample.size() << " documents: vocabulary "
+                  << options.model.vocabulary_size << ", alpha " << std::fixed
+                  << std::setprecision(3) << options.model.zipf_alpha << ", B "
+                  << options.model.zipf_shift << ", length median "
+                  << std::setprecision(0) << std::exp(options.model.length_mu)
+                  << " words" << std::endl;
+    }
+    if (options.vocabulary > 0) {
+        options.model.vocabulary_size = options.vocabulary;
+    }
+    if (options.alpha > 0) {
+        options.model.zipf_alpha = options.alpha;
+    }
+
+    CorpusGenerator generator(options.model, options.seed);
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    if (options.documents > 0) {
+        std::ofstream out;
+        if (!options.out_file.empty()) {
+            out.open(options.out_file);
+            if (!out) {
+                std::cerr << "Error: Cannot write " << options.out_file << std::endl;
+                return 1;
+            }
+            out << "[\n";
+        }
+
+        BooleanIndexBuilder builder;
+        bool build_index = !options.index_file.empty();
+        if (build_index) {
+            builder.set_hot_tier_size(static_cast<uint32_t>(options.hot_tier));
+            builder.begin_build(options.documents);
+        }
+
+        Document doc;
+        for (size_t i = 0; i < options.documents; ++i) {
+            generator.next_document(doc);
+
+            if (out.is_open()) {
+                write_document(out, doc);
+                out << (i + 1 < options.documents ? ",\n" : "\n");
+            }
+            if (build_index) {
+                builder.add_document(doc);
+            }
+
+            if ((i + 1) % 1000000 == 0) {
+                std::cout << "Generated " << i + 1 << " documents" << std::endl;
+            }
+        }
+
+        if (out.is_open()) {
+            out << "]\n";
+            out.close();
+            std::cout << "Documents written to " << options.out_file << std::endl;
+        }
+
+        if (build_index) {
+            builder.finish_build();
+            builder.save_index(options.index_file);
+        }
+    }
+
+    if (options.queries > 0) {
+        QueryMix mix = options.mix.empty() ? QueryMix{} : QueryMix::parse(options.mix);
+
+        std::ofstream log(options.query_log_file);
+        if (!log) {
+            std::cerr << "Error: Cannot write " << options.query_log_file << std::endl;
+            return 1;
+        }
+        for (size_t i = 0; i < options.queries; ++i) {
+            log << generator.next_query(mix) << "\n";
+        }
+        std::cout << "Queries written to " << options.query_log_file << std::endl;
+    }
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    std::cout << "Total time: " << std::fixed << std::setprecision(1)
+              << std::chrono::duration<double>(end_time - start_time).count() << " s" << std::endl;
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_arguments(argc, argv, options)) {
+        show_help();
+        return 1;
+    }
+
+    try {
+        return generate(options);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}